@@ -1,41 +1,31 @@
 ﻿#include "Application.h"
-#include <Windows.h>
 
 namespace PGR {
 
-	float linear(float t, float st, float et, float sv, float ev) {
-		return sv + (t - st) / (et - st) * (ev - sv);
+	// MSVC opens and changes to wide paths directly; elsewhere paths are UTF-8.
+	static void OpenFile(std::ifstream& file, const std::wstring& path) {
+#ifdef _WIN32
+		file.open(path);
+#else
+		file.open(std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(path));
+#endif
 	}
 
-	Vec2 rotatePoint(float x, float y, float r, float deg) {
-		return Vec2(
-			x + r * cos(deg * PI / 180.0f),
-			y + r * sin(deg * PI / 180.0f)
-		);
+	// Where benchmark and verify runs send frames they only measure.
+	static const char* NullDevice() {
+#ifdef _WIN32
+		return "NUL";
+#else
+		return "/dev/null";
+#endif
 	}
 
-	float randf(float a, float b) {
-		static std::mt19937 rng{ std::random_device{}() };
-		std::uniform_real_distribution<float> dist(a, b);
-		return dist(rng);
-	}
-
-	float getPosYEvent(float t, std::vector<JudgeLineMoveEvent> es) {
-		const int i = findEvent(t, es);
-		if (i == -1)
-			return 0.0f;
-		const JudgeLineMoveEvent& e = es[i];
-
-		return linear(t, e.startTime, e.endTime, e.start2, e.end2);
-	}
-
-	float getSpeedValue(float t, std::vector<SpeedEvent> es) {
-		const int i = findEvent(t, es);
-		if (i == -1)
-			return 0.0f;
-		const SpeedEvent& e = es[i];
-
-		return e.value;
+	static int ChangeDir(const std::wstring& path) {
+#ifdef _WIN32
+		return _wchdir(path.c_str());
+#else
+		return chdir(std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(path).c_str());
+#endif
 	}
 
 	Application::Application(
@@ -44,6 +34,83 @@ namespace PGR {
 		const int width, const int height)
 		: m_Name(name), m_Width(width), m_Height(height) {
 
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+			if (arg == "--audio-wav" && i + 1 < argc)
+				m_AudioWavPath = argv[++i];
+			else if (arg == "--chart" && i + 1 < argc)
+				m_ChartInfoPath = converter.from_bytes(argv[++i]);
+			else if (arg == "--mixdown" && i + 1 < argc)
+				m_MixdownPath = argv[++i];
+			else if (arg == "--headless")
+				m_Headless = true;
+			else if (arg == "--clock-sim")
+				m_ClockSim = true;
+			else if (arg == "--pacing-sim")
+				m_PacingSim = true;
+			else if (arg == "--target-fps" && i + 1 < argc)
+				m_TargetFps = Max(0.0f, (float)atof(argv[++i]));
+			else if (arg == "--verify-seek" && i + 1 < argc)
+				m_VerifySeekFrames = atoi(argv[++i]);
+			else if (arg == "--export" && i + 1 < argc)
+				m_ExportPath = argv[++i];
+			else if (arg == "--format" && i + 1 < argc) {
+				if (!ParseFrameFormat(argv[++i], m_ExportFormat))
+					printf("Unknown format %s, using y4m\n", argv[i]);
+			}
+			else if (arg == "--fps" && i + 1 < argc)
+				m_ExportFps = Max(1, atoi(argv[++i]));
+			else if (arg == "--size" && i + 1 < argc)
+				sscanf(argv[++i], "%dx%d", &m_ExportWidth, &m_ExportHeight);
+			else if (arg == "--duration" && i + 1 < argc)
+				m_ExportDuration = (float)atof(argv[++i]);
+			else if (arg == "--threads" && i + 1 < argc)
+				m_ExportThreads = Max(1, atoi(argv[++i]));
+			else if (arg == "--encoders" && i + 1 < argc)
+				m_ExportEncoders = Max(1, atoi(argv[++i]));
+			else if (arg == "--no-elide")
+				m_ExportElide = false;
+			else if (arg == "--framebuffer" && i + 1 < argc) {
+				if (!ParseFramebufferFormat(argv[++i], m_FramebufferFormat))
+					printf("Unknown framebuffer %s, using float\n", argv[i]);
+			}
+			else if (arg == "--export-scaling")
+				m_ExportScaling = true;
+			else if (arg == "--frames" && i + 1 < argc) {
+				if (sscanf(argv[++i], "%d:%d", &m_ExportStartFrame, &m_ExportEndFrame) == 2)
+					m_ExportSegment = true;
+				else
+					printf("Bad frame range %s, expected start:end\n", argv[i]);
+			}
+			else if (arg == "--verify-manifest" && i + 1 < argc)
+				m_VerifyManifestPath = argv[++i];
+			else if (arg == "--qoi-to-png" && i + 1 < argc)
+				m_QoiToPngPath = argv[++i];
+			else if (arg == "--pipeline-depth" && i + 1 < argc)
+				m_PipelineDepth = std::clamp(atoi(argv[++i]), 1, 3);
+			else if (arg == "--pipeline-bench" && i + 1 < argc)
+				m_PipelineBenchFrames = atoi(argv[++i]);
+			else if (arg == "--profile-csv" && i + 1 < argc)
+				m_ProfileCsvPath = argv[++i];
+			else if (arg == "--profile-bench" && i + 1 < argc)
+				m_ProfileBenchFrames = atoi(argv[++i]);
+			else if (arg == "--trace" && i + 1 < argc)
+				m_TracePath = argv[++i];
+			else if (arg == "--merge" && i + 1 < argc) {
+				m_MergePath = argv[++i];
+				while (i + 1 < argc)
+					m_MergeManifests.push_back(argv[++i]);
+			}
+		}
+
+		if (!m_TracePath.empty()) {
+			if (Trace::Start(m_TracePath))
+				Trace::SetThreadName("Main");
+			else
+				printf("Can't write %s, not tracing\n", m_TracePath.c_str());
+		}
+
 		Init();
 	}
 
@@ -51,128 +118,38 @@ namespace PGR {
 		Terminate();
 	}
 
-	void Application::DrawTexture(Texture* texture, const int x, const int y, const float sx, float sy, float angle) {
-		if (!texture) return;
-
-		if (sy == -1)
-			sy = sx;
-
-		const int texWidth = texture->GetWidth();
-		const int texHeight = texture->GetHeight();
-		const float srcW = static_cast<float>(texWidth);
-		const float srcH = static_cast<float>(texHeight);
-		const float w = srcW * sx;
-		const float h = srcH * sy;
-
-		const float rad = angle * 3.14159265f / 180.0f;
-		const float cosA = cosf(rad);
-		const float sinA = sinf(rad);
-
-		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
-		float corners[4][2] = { {0, 0}, {w, 0}, {0, h}, {w, h} };
-		for (int k = 0; k < 4; ++k) {
-			float rx = corners[k][0] * cosA - corners[k][1] * sinA;
-			float ry = corners[k][0] * sinA + corners[k][1] * cosA;
-			minX = Min(minX, rx);
-			minY = Min(minY, ry);
-			maxX = Max(maxX, rx);
-			maxY = Max(maxY, ry);
-		}
-
-		const int startY = static_cast<int>(std::floor(minY));
-		const int endY = static_cast<int>(std::ceil(maxY));
-		const int startX = static_cast<int>(std::floor(minX));
-		const int endX = static_cast<int>(std::ceil(maxX));
-
-		const float invSx = 1.0f / sx;
-		const float invSy = 1.0f / sy;
-
-		const int windowWidth = m_Width;
-		const int windowHeight = m_Height;
-
-		Framebuffer* framebuffer = m_Framebuffer;
-
-		for (int j = startY; j <= endY; ++j) {
-			const float jSinA = j * sinA;
-			const float jCosA = j * cosA;
-			const int dstY = y + j;
-
-			if (dstY < 0 || dstY >= windowHeight)
-				continue;
-
-			for (int i = startX; i <= endX; ++i) {
-				const int dstX = x + i;
-				if (dstX < 0 || dstX >= windowWidth)
-					continue;
-
-				const float tx = (i * cosA + jSinA) * invSx;
-				const float ty = (-i * sinA + jCosA) * invSy;
-
-				if (tx >= 0 && tx < srcW && ty >= 0 && ty < srcH) {
-					const int texX = static_cast<int>(tx);
-					const int texY = static_cast<int>(ty);
-
-					Vec4 tColor = texture->GetColor(texX, texY);
-					framebuffer->SetColor(dstX, dstY, tColor);
-				}
-			}
-		}
-	}
-
 	void Application::LoadJsons() {
-		cJSON* root;
-		cJSON* arrayInt;
-		cJSON* arrayExt;
-		cJSON* line;
-		cJSON* obj;
-
+		PGR_TRACE_SCOPE("LoadJsons", "load");
 		puts("Reading render info...\n");
 
 		std::ifstream file("respack.json");
 		std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 		file.close();
-		root = cJSON_Parse(json.c_str());
-
-		arrayExt = cJSON_GetObjectItem(root, "hitFX");
-		m_Respack.hitFx.X = (float)cJSON_GetArrayItem(arrayExt, 0)->valueint;
-		m_Respack.hitFx.Y = (float)cJSON_GetArrayItem(arrayExt, 1)->valueint;
-
-		arrayExt = cJSON_GetObjectItem(root, "holdAtlas");
-		m_Respack.holdAtlas.X = (float)cJSON_GetArrayItem(arrayExt, 0)->valueint;
-		m_Respack.holdAtlas.Y = (float)cJSON_GetArrayItem(arrayExt, 1)->valueint;
-
-		arrayExt = cJSON_GetObjectItem(root, "holdAtlasMH");
-		m_Respack.holdAtlasMH.X = (float)cJSON_GetArrayItem(arrayExt, 0)->valueint;
-		m_Respack.holdAtlasMH.Y = (float)cJSON_GetArrayItem(arrayExt, 1)->valueint;
-
-		cJSON_Delete(root);
+		{
+			PGR_TRACE_SCOPE("Parse respack", "load");
+			ParseRespack(json, m_Respack);
+		}
 		std::cout << "HitFX frame num: " << m_Respack.hitFx.X * m_Respack.hitFx.Y << std::endl << "Hold head&tail Len.: " << m_Respack.holdAtlas.X << " " <<m_Respack.holdAtlas.Y << std::endl << "HoldMH head&tail Len.: " << m_Respack.holdAtlasMH.X << " " << m_Respack.holdAtlasMH.Y << std::endl;
 
 		puts("Reading chart info...\n");
 
-		OPENFILENAMEW ofn;
-		wchar_t szFile[260] = L"";
-
-		ZeroMemory(&ofn, sizeof(ofn));
-		ofn.lStructSize = sizeof(ofn);
-		ofn.hwndOwner = NULL;
-		ofn.lpstrFile = szFile;
-		ofn.nMaxFile = sizeof(szFile) / sizeof(wchar_t);
-		ofn.lpstrFilter = L"Text Files (*.txt)\0*.txt\0All Files (*.*)\0*.*\0";
-		ofn.nFilterIndex = 1;
-		ofn.lpstrInitialDir = L"chart\\";
-		ofn.lpstrTitle = L"Choose chartInfo file";
-		ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST;
-
 		m_C.chart.wPath = _getcwd(NULL, 0);
 
-		if (GetOpenFileNameW(&ofn))
-			file.open(ofn.lpstrFile);
+		std::wstring chartInfo = m_ChartInfoPath;
+		if (!chartInfo.empty()) {
+			OpenFile(file, chartInfo);
+			// Leave the working directory where the file dialog would have.
+			size_t lastSlash = chartInfo.find_last_of(L"\\/");
+			if (lastSlash != std::wstring::npos)
+				ChangeDir(chartInfo.substr(0, lastSlash + 1));
+		}
+		else if (!(chartInfo = m_Platform->OpenChartDialog()).empty())
+			OpenFile(file, chartInfo);
+		else
+			puts("No chart given, pass --chart <info.txt>.");
 
 		m_C.chart.path = _getcwd(NULL, 0);
 
-		std::wstring chartInfo = ofn.lpstrFile;
-
 		if (!file.is_open()) {
 			m_C.chart.info.name = L"";
 			m_C.chart.info.level = L"";
@@ -191,6 +168,9 @@ namespace PGR {
 			while (!file.eof()) {
 				std::string line;
 				std::getline(file, line);
+				// info.txt is usually saved with CRLF; only MSVC strips the CR.
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
 				if (line.find("Name:") == 0) {
                     m_C.chart.info.name = converter.from_bytes(line.substr(6));
 				}
@@ -214,183 +194,25 @@ namespace PGR {
 		printf("Name: %ls\nLevel: %ls\nSong: %ls\nPicture: %ls\nChart: %ls\n", m_C.chart.info.name.c_str(), m_C.chart.info.level.c_str(), m_C.chart.info.song.c_str(), m_C.chart.info.picture.c_str(), m_C.chart.info.chart.c_str());
 
 		puts("\nReading chart\n");
-		file.open(m_C.chart.info.chart);
-		json = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-		file.close();
-		root = cJSON_Parse(json.c_str());
-
-		std::map<float, int> noteSectCounter;
+		{
+			PGR_TRACE_SCOPE("Read chart", "load");
+			OpenFile(file, m_C.chart.info.chart);
+			json = std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			file.close();
+		}
 
-		arrayExt = cJSON_GetObjectItem(root, "judgeLineList");
+		if (!LoadChartData(json, m_C.chart.data))
+			puts("Failed to parse the chart, it has no lines.");
 
 		printf("Line   Notes    Move  Rotate   Alpha   Speed\n");
-
-		for (int i = 0; i < cJSON_GetArraySize(arrayExt); i++) {
-			JudgeLine jline;
-			line = cJSON_GetArrayItem(arrayExt, i);
-			jline.bpm = (float)cJSON_GetObjectItem(line, "bpm")->valuedouble;
-			arrayInt = cJSON_GetObjectItem(line, "judgeLineMoveEvents");
-			for (int j = 0; j < cJSON_GetArraySize(arrayInt); j++) {
-				JudgeLineMoveEvent e;
-				obj = cJSON_GetArrayItem(arrayInt, j);
-				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
-				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
-				e.start = (float)cJSON_GetObjectItem(obj, "start")->valuedouble;
-				e.end = (float)cJSON_GetObjectItem(obj, "end")->valuedouble;
-				e.start2 = (float)cJSON_GetObjectItem(obj, "start2")->valuedouble;
-				e.end2 = (float)cJSON_GetObjectItem(obj, "end2")->valuedouble;
-				jline.moveEvents.push_back(e);
-				float t = j == cJSON_GetArraySize(arrayInt) - 1 ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
-				if (t > m_C.chart.data.time) {
-					m_C.chart.data.time = t;
-				}
-			}
-			arrayInt = cJSON_GetObjectItem(line, "judgeLineRotateEvents");
-			for (int j = 0; j < cJSON_GetArraySize(arrayInt); j++) {
-				JudgeLineRotateEvent e;
-				obj = cJSON_GetArrayItem(arrayInt, j);
-				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
-				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
-				e.start = (float)cJSON_GetObjectItem(obj, "start")->valuedouble;
-				e.end = (float)cJSON_GetObjectItem(obj, "end")->valuedouble;
-				jline.rotateEvents.push_back(e);
-				float t = j == cJSON_GetArraySize(arrayInt) - 1 ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
-				if (t > m_C.chart.data.time) {
-					m_C.chart.data.time = t;
-				}
-			}
-			arrayInt = cJSON_GetObjectItem(line, "judgeLineDisappearEvents");
-			for (int j = 0; j < cJSON_GetArraySize(arrayInt); j++) {
-				JudgeLineDisappearEvent e;
-				obj = cJSON_GetArrayItem(arrayInt, j);
-				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
-				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
-				e.start = (float)cJSON_GetObjectItem(obj, "start")->valuedouble;
-				e.end = (float)cJSON_GetObjectItem(obj, "end")->valuedouble;
-				jline.disappearEvents.push_back(e);
-				float t = j == cJSON_GetArraySize(arrayInt) - 1 ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
-				if (t > m_C.chart.data.time) {
-					m_C.chart.data.time = t;
-				}
-			}
-			arrayInt = cJSON_GetObjectItem(line, "speedEvents");
-			for (int j = 0; j < cJSON_GetArraySize(arrayInt); j++) {
-				SpeedEvent e;
-				obj = cJSON_GetArrayItem(arrayInt, j);
-				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
-				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
-				e.value = (float)cJSON_GetObjectItem(obj, "value")->valuedouble;
-				jline.speedEvents.push_back(e);
-				float t = j == cJSON_GetArraySize(arrayInt) - 1 ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
-				if (t > m_C.chart.data.time) {
-					m_C.chart.data.time = t;
-				}
-			}
-			arrayInt = cJSON_GetObjectItem(line, "notesAbove");
-			for (int j = 0; j < cJSON_GetArraySize(arrayInt); j++) {
-				Note n;
-				obj = cJSON_GetArrayItem(arrayInt, j);
-				n.type = (int)cJSON_GetObjectItem(obj, "type")->valueint;
-				n.time = (float)cJSON_GetObjectItem(obj, "time")->valuedouble;
-				n.floorPosition = (float)cJSON_GetObjectItem(obj, "floorPosition")->valuedouble;
-				n.holdTime = (float)cJSON_GetObjectItem(obj, "holdTime")->valuedouble;
-				n.speed = (float)cJSON_GetObjectItem(obj, "speed")->valuedouble;
-				n.positionX = (float)cJSON_GetObjectItem(obj, "positionX")->valuedouble;
-				jline.notesAbove.push_back(n);
-				float t = n.type != 3 ? jline.beat2sec(n.time) : jline.beat2sec(n.holdTime);
-				if (t > m_C.chart.data.time) {
-					m_C.chart.data.time = t;
-				}
-			}
-			arrayInt = cJSON_GetObjectItem(line, "notesBelow");
-			for (int j = 0; j < cJSON_GetArraySize(arrayInt); j++) {
-				Note n;
-				obj = cJSON_GetArrayItem(arrayInt, j);
-				n.type = (int)cJSON_GetObjectItem(obj, "type")->valueint;
-				n.time = (float)cJSON_GetObjectItem(obj, "time")->valuedouble;
-				n.floorPosition = (float)cJSON_GetObjectItem(obj, "floorPosition")->valuedouble;
-				n.holdTime = (float)cJSON_GetObjectItem(obj, "holdTime")->valuedouble;
-				n.speed = (float)cJSON_GetObjectItem(obj, "speed")->valuedouble;
-				n.positionX = (float)cJSON_GetObjectItem(obj, "positionX")->valuedouble;
-				jline.notesBelow.push_back(n);
-				float t = n.type != 3 ? jline.beat2sec(n.time) : jline.beat2sec(n.holdTime);
-				if (t > m_C.chart.data.time) {
-					m_C.chart.data.time = t;
-				}
-			}
-
-			std::sort(jline.notesAbove.begin(), jline.notesAbove.end(), [](Note a, Note b) { return a.time < b.time; });
-			std::sort(jline.notesBelow.begin(), jline.notesBelow.end(), [](Note a, Note b) { return a.time < b.time; });
-			std::sort(jline.speedEvents.begin(), jline.speedEvents.end(), [](SpeedEvent a, SpeedEvent b) { return a.startTime < b.startTime; });
-			std::sort(jline.moveEvents.begin(), jline.moveEvents.end(), [](JudgeLineMoveEvent a, JudgeLineMoveEvent b) { return a.startTime < b.startTime; });
-			std::sort(jline.rotateEvents.begin(), jline.rotateEvents.end(), [](JudgeLineRotateEvent a, JudgeLineRotateEvent b) { return a.startTime < b.startTime; });
-			std::sort(jline.disappearEvents.begin(), jline.disappearEvents.end(), [](JudgeLineDisappearEvent a, JudgeLineDisappearEvent b) { return a.startTime < b.startTime; });
-
-			jline.initSpeedEvents();
-			jline.mergeNotes();
-			jline.initNoteFp();
-
-			for (auto& n : jline.notes) {
-				n.sect = jline.beat2sec(n.time);
-				n.secht = jline.beat2sec(n.holdTime);
-				n.holdEndTime = n.sect + n.secht;
-				n.holdLength = n.secht * n.speed * pgrh;
-				n.isHold = n.type == 3;
-				n.clicked = false;
-				n.line = i;
-				if (noteSectCounter.find(n.sect) == noteSectCounter.end()) {
-					noteSectCounter[n.sect] = 0;
-				}
-
-				noteSectCounter[n.sect]++;
-
-			}
-
-			jline.notesAbove.clear();
-			jline.notesBelow.clear();
-
-			m_C.chart.data.judgeLines.push_back(jline);
-
-			m_C.chart.data.noteCount += (int)jline.notes.size();
-
-			printf("%4d\t%4zu\t%4zu\t%4zu\t%4zu\t%4zu\n", i, jline.notes.size(), jline.moveEvents.size(), jline.rotateEvents.size(), jline.disappearEvents.size(), jline.speedEvents.size());
-
+		for (size_t i = 0; i < m_C.chart.data.judgeLines.size(); i++) {
+			const JudgeLine& jline = m_C.chart.data.judgeLines[i];
+			printf("%4d\t%4zu\t%4zu\t%4zu\t%4zu\t%4zu\n", (int)i, jline.notes.size(), jline.moveEvents.size(), jline.rotateEvents.size(), jline.disappearEvents.size(), jline.speedEvents.size());
 		}
 
 		puts("\nEnd.\n");
 
 		puts("Parsing Note...\n");
-		for (auto& line : m_C.chart.data.judgeLines) {
-			for (auto& n : line.notes) {
-				n.morebets = noteSectCounter[n.sect] > 1;
-				EventsValue ev = line.getState(n.time);
-				Vec2 pos = rotatePoint(
-					ev.x * m_Width, ev.y * m_Height,
-					n.positionX * m_Width * pgrw, ev.rotate
-				);
-				m_C.chart.data.clickEffectCollection.push_back({ n, n.sect, Particles((float)m_Width, (float)m_Height) });
-				if (n.isHold) {
-					float dt = 30 / line.bpm;
-					float st = n.sect + dt;
-					while (st < n.holdEndTime) {
-						ev = line.getState(st);
-						pos = rotatePoint(
-							ev.x * m_Width, ev.y * m_Height,
-							n.positionX * m_Width * pgrw, ev.rotate
-						);
-						m_C.chart.data.clickEffectCollection.push_back({ n, st, Particles((float)m_Width, (float)m_Height) });
-						st += dt;
-					}
-				}
-			}
-		}
-
-		std::sort(
-			m_C.chart.data.clickEffectCollection.begin(),
-			m_C.chart.data.clickEffectCollection.end(),
-			[](NoteMap a, NoteMap b) { return a.sect < b.sect; }
-		);
-
 		printf("\nHitFX num: %zd\n", m_C.chart.data.clickEffectCollection.size());
 
 		puts("End.\n");
@@ -400,40 +222,25 @@ namespace PGR {
 	}
 
 	void Application::LoadImgs() {
+		PGR_TRACE_SCOPE("LoadImgs", "load");
 
 		puts("\nLoading Imgs...\n");
 
-		Texture* hold = m_C.noteImgs.hold;
-		m_C.noteImgs.holdHead = hold->ClipImg(0, (int)m_Respack.holdAtlas.X);
-		m_C.noteImgs.holdBody = hold->ClipImg((int)m_Respack.holdAtlas.X, hold->GetHeight() - (int)m_Respack.holdAtlas.Y);
-		m_C.noteImgs.holdTail = hold->ClipImg(hold->GetHeight() - (int)m_Respack.holdAtlas.Y, hold->GetHeight());
-
-		Texture* holdMH = m_C.noteImgs.holdMH;
-		m_C.noteImgs.holdMHHead = holdMH->ClipImg(0, (int)m_Respack.holdAtlasMH.X);
-		m_C.noteImgs.holdMHBody = holdMH->ClipImg((int)m_Respack.holdAtlasMH.X, holdMH->GetHeight() - (int)m_Respack.holdAtlasMH.Y);
-		m_C.noteImgs.holdMHTail = holdMH->ClipImg(holdMH->GetHeight() - (int)m_Respack.holdAtlasMH.Y, holdMH->GetHeight());
-
-		m_C.holdBodyImgs[0] = m_C.noteImgs.holdBody;
-		m_C.holdBodyImgs[1] = m_C.noteImgs.holdMHBody;
-		m_C.holdTailImgs[0] = m_C.noteImgs.holdTail;
-		m_C.holdTailImgs[1] = m_C.noteImgs.holdMHTail;
-
-		m_C.noteHeadImgs[0][0] = m_C.noteImgs.click;
-		m_C.noteHeadImgs[0][1] = m_C.noteImgs.clickMH;
-		m_C.noteHeadImgs[1][0] = m_C.noteImgs.drag;
-		m_C.noteHeadImgs[1][1] = m_C.noteImgs.dragMH;
-		m_C.noteHeadImgs[2][0] = m_C.noteImgs.holdHead;
-		m_C.noteHeadImgs[2][1] = m_C.noteImgs.holdMHHead;
-		m_C.noteHeadImgs[3][0] = m_C.noteImgs.flick;
-		m_C.noteHeadImgs[3][1] = m_C.noteImgs.flickMH;
+		ClipHoldImgs(m_C, m_Respack);
 
 		if (_chdir(m_C.chart.path.c_str()))
 			exit(1);
 
 		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
 
-		m_C.chart.image = new Texture(converter.to_bytes(m_C.chart.info.picture).c_str());
-		m_C.chart.blurImage = m_C.chart.image->GetBlurImg(0.0f);
+		{
+			PGR_TRACE_SCOPE("Load background", "load");
+			m_C.chart.image = new Texture(converter.to_bytes(m_C.chart.info.picture).c_str());
+		}
+		{
+			PGR_TRACE_SCOPE("Blur background", "load");
+			m_C.chart.blurImage = m_C.chart.image->GetBlurImg(0.0f);
+		}
 
 		puts("End.\n");
 
@@ -443,24 +250,18 @@ namespace PGR {
 	}
 
 	void Application::LoadFxImgs() {
+		PGR_TRACE_SCOPE("LoadFxImgs", "load");
 		puts("Loading hitFX...\n");
-		for (int j = (int)m_Respack.hitFx.Y - 1; j >= 0; j--) {
-			for (int i = 0; i < (int)m_Respack.hitFx.X; i++) {
-				m_C.hitFxImgs.push_back(
-					m_C.noteImgs.hitFx->ClipBlockImg(
-						(int)((i / m_Respack.hitFx.X) * m_C.noteImgs.hitFx->GetWidth()),
-						(int)((j / m_Respack.hitFx.Y) * m_C.noteImgs.hitFx->GetHeight()),
-						(int)(((i + 1) / m_Respack.hitFx.X) * m_C.noteImgs.hitFx->GetWidth()),
-						(int)(((j + 1) / m_Respack.hitFx.Y) * m_C.noteImgs.hitFx->GetHeight())
-					)->ColorTexture(Vec4(pcolor, 1.0f))
-				);
-			}
-		}
+		const size_t fxBytes = ClipHitFxImgs(m_C, m_Respack);
+		// Frames are stored uncolored and tinted with pcolor while blitting,
+		// so no second colored copy of every frame is kept around.
+		printf("HitFX frames: %zu, %.2f MB (colored copy skipped)\n", m_C.hitFxImgs.size(), fxBytes / 1048576.0);
 		puts("End.\n");
 		puts("Loading audio...\n");
-		mciSendString("open click.wav type waveaudio alias click", NULL, 0, NULL);
-		mciSendString("open drag.wav type waveaudio alias drag", NULL, 0, NULL);
-		mciSendString("open flick.wav type waveaudio alias flick", NULL, 0, NULL);
+		PGR_TRACE_SCOPE("Load audio", "load");
+		m_C.hitSounds.click = m_Mixer.LoadSound("click.wav");
+		m_C.hitSounds.drag = m_Mixer.LoadSound("drag.wav");
+		m_C.hitSounds.flick = m_Mixer.LoadSound("flick.wav");
 
 		if (_chdir(m_C.chart.path.c_str()))
 			exit(1);
@@ -468,8 +269,15 @@ namespace PGR {
 		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
 
 		std::string music = converter.to_bytes(m_C.chart.info.song);
-		std::string str = "open " + music + " alias music";
-		mciSendString(str.c_str(), NULL, 0, NULL);
+		if (m_Music.Open(music)) {
+			m_Mixer.SetMusic(&m_Music);
+			printf("Streaming %s (%.1f s, %d KB ring)\n", music.c_str(), m_Music.GetDuration(),
+				(int)(MusicStream::RingFrames * Mixer::Channels * sizeof(float) / 1024));
+		}
+		else if (m_Platform->OpenMusic(music))
+			m_PlatformMusic = true;
+		else
+			printf("Failed to open %s, playing without music\n", music.c_str());
 
 		if (_chdir(m_C.chart.wPath.c_str()))
 			exit(1);
@@ -477,31 +285,590 @@ namespace PGR {
 		puts("End.\n");
 	}
 
+	void Application::PackImgs() {
+		PGR_TRACE_SCOPE("PackImgs", "load");
+		puts("Packing skin atlas...\n");
+
+		PackSkin(m_C);
+
+		for (size_t i = 0; i < m_C.atlas->GetPageCount(); i++) {
+			Texture* page = m_C.atlas->GetPage(i);
+			printf("Page %zu: %dx%d\n", i, page->GetWidth(), page->GetHeight());
+		}
+		printf("Atlas: %.2f MB\n", m_C.atlas->GetTexelCount() * sizeof(Vec4) / 1048576.0);
+
+		puts("End.\n");
+	}
+
 	void Application::LoadFiles() {
 		LoadJsons();
 		LoadImgs();
 		LoadFxImgs();
+		PackImgs();
+	}
+
+	bool Application::MixAudio(const std::string& path, size_t begin, size_t end, MixdownStats* stats) {
+		if (_chdir(m_C.chart.path.c_str()))
+			exit(1);
+
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+		AudioClip song;
+		if (!LoadAudioFile(converter.to_bytes(m_C.chart.info.song), song, Mixer::SampleRate, Mixer::Channels))
+			puts("Failed to load song, mixing hitsounds only.");
+
+		if (_chdir(m_C.chart.wPath.c_str()))
+			exit(1);
+
+		std::vector<MixdownHit> hits;
+		hits.reserve(m_C.chart.data.hitsounds.size());
+		for (const HitsoundEvent& e : m_C.chart.data.hitsounds)
+			hits.push_back({ e.time, m_C.hitSounds.Get(e.type) });
+
+		const int threads = Max(1, (int)std::thread::hardware_concurrency());
+		return MixdownToWav(path, song, m_Mixer.GetSounds(), hits, threads, stats, begin, end);
+	}
+
+	void Application::RunMixdown() {
+		puts("Mixing down...\n");
+
+		MixdownStats stats;
+		if (!MixAudio(m_MixdownPath, 0, (size_t)-1, &stats)) {
+			printf("Failed to write %s\n", m_MixdownPath.c_str());
+			return;
+		}
+
+		printf("Mixdown: %.1f s of audio, %zu hits in %.3f s on %d threads (%.0fx realtime)\n",
+			stats.audioSeconds, stats.hits, stats.wallSeconds, stats.threads,
+			stats.wallSeconds > 0.0 ? stats.audioSeconds / stats.wallSeconds : 0.0);
+		puts("End.\n");
+	}
+
+	void Application::ScheduleHitsounds() {
+		const std::vector<HitsoundEvent>& events = m_C.chart.data.hitsounds;
+
+		// Time went backwards (seek): rewind the cursor.
+		if (m_Time < m_HitsoundTime) {
+			m_HitsoundCursor = std::lower_bound(events.begin(), events.end(), m_Time,
+				[](const HitsoundEvent& e, float t) { return e.time < t; }) - events.begin();
+		}
+		m_HitsoundTime = m_Time;
+
+		// The streamed song lets the mixer place hits on their exact sample, so
+		// queue them a little early. MCI music has no such clock.
+		const float horizon = m_PlatformMusic ? m_Time : m_Time + hitsoundLookahead;
+		for (; m_HitsoundCursor < events.size() && events[m_HitsoundCursor].time < horizon; m_HitsoundCursor++) {
+			const HitsoundEvent& e = events[m_HitsoundCursor];
+			if (m_PlatformMusic)
+				m_Mixer.Play(m_C.hitSounds.Get(e.type));
+			else
+				m_Mixer.PlayAt(m_C.hitSounds.Get(e.type), e.time);
+		}
+	}
+
+	void Application::RunVerifySeek() {
+		const int frames = m_VerifySeekFrames;
+		printf("Verifying %d frames: sequential vs shuffled order...\n\n", frames);
+
+		Framebuffer* framebuffer = Framebuffer::Create(m_Width, m_Height);
+		framebuffer->LoadFontTTF("font.ttf");
+
+		// Sample the whole chart plus a little past the end.
+		const float duration = m_C.chart.data.time + 1.0f;
+		auto timeOf = [&](int i) { return duration * (float)i / (float)frames; };
+
+		auto renderHash = [&](ChartRenderer& renderer, float t) {
+			framebuffer->Clear(Vec3(0.0f));
+			renderer.Render(framebuffer, t, m_C.camera);
+			const unsigned char* bytes = (const unsigned char*)framebuffer->GetColorBuffer();
+			const size_t size = sizeof(Vec3) * framebuffer->GetWidth() * framebuffer->GetHeight();
+			uint64_t hash = 14695981039346656037ULL;
+			for (size_t i = 0; i < size; i++)
+				hash = (hash ^ bytes[i]) * 1099511628211ULL;
+			return hash;
+		};
+
+		ChartRenderer sequential(m_C);
+		std::vector<uint64_t> expected(frames);
+		for (int i = 0; i < frames; i++)
+			expected[i] = renderHash(sequential, timeOf(i));
+
+		std::vector<int> order(frames);
+		for (int i = 0; i < frames; i++)
+			order[i] = i;
+		std::shuffle(order.begin(), order.end(), std::mt19937(m_C.chart.data.seed));
+
+		// Once with the renderer that just played forward, once with a fresh one.
+		ChartRenderer shuffled(m_C);
+		int mismatches = 0;
+		for (ChartRenderer* renderer : { &sequential, &shuffled }) {
+			for (int i : order) {
+				if (renderHash(*renderer, timeOf(i)) == expected[i])
+					continue;
+				if (mismatches++ < 10)
+					printf("  frame %d (t = %.3f s) differs\n", i, timeOf(i));
+			}
+		}
+
+		delete framebuffer;
+
+		printf("Verify seek: %d frames x 2 shuffled passes, %d mismatches\n", frames, mismatches);
+		m_ExitCode = mismatches ? 1 : 0;
+	}
+
+	float Application::GetExportDuration() {
+		// Whole chart by default, or the song if it runs longer.
+		if (m_ExportDuration > 0.0f)
+			return m_ExportDuration;
+		return Max(m_C.chart.data.time + 1.0f, m_Music.IsOpen() ? (float)m_Music.GetDuration() : 0.0f);
+	}
+
+	void Application::RunExport() {
+		const float duration = GetExportDuration();
+
+		ExportSettings settings;
+		settings.fps = m_ExportFps;
+		settings.frames = (int)std::ceil(duration * m_ExportFps);
+		settings.threads = m_ExportThreads;
+		settings.elideRepeats = m_ExportElide;
+		settings.framebufferFormat = m_FramebufferFormat;
+		settings.progressEvery = m_ExportFps * 10;
+		if (m_ExportSegment) {
+			settings.firstFrame = Max(0, m_ExportStartFrame);
+			settings.frames = Max(0, m_ExportEndFrame - settings.firstFrame);
+			settings.hashFrames = true;
+		}
+
+		printf("Exporting frames [%d, %d) (%.2f s) at %dx%d, %d fps on %d threads to %s\n\n",
+			settings.firstFrame, settings.firstFrame + settings.frames, (float)settings.frames / m_ExportFps,
+			m_ExportWidth, m_ExportHeight, m_ExportFps, settings.threads,
+			m_ExportPath == "-" ? "stdout" : m_ExportPath.c_str());
+
+		m_FrameWriter.SetFirstFrame(settings.firstFrame);
+		ExportStats stats;
+		if (!ExportFrames(m_C, m_C.camera, m_FrameWriter, settings, &stats)) {
+			printf("Export stopped at frame %d: output closed\n", stats.frames);
+			m_ExitCode = 1;
+		}
+		const ImageSequenceWriter& images = m_FrameWriter.GetImages();
+		const int encoders = images.GetEncoderCount();
+		if (!m_FrameWriter.Close()) {
+			puts("Export: some images failed to write");
+			m_ExitCode = 1;
+		}
+
+		const double wall = stats.wallSeconds;
+		const int frames = Max(stats.frames, 1);
+		printf("Export: %d frames in %.2f s, %.1f fps rendered (%.2fx realtime)\n",
+			stats.frames, wall, wall > 0.0 ? stats.frames / wall : 0.0, wall > 0.0 ? stats.frames / (wall * m_ExportFps) : 0.0);
+		printf("Export: render %.2f ms/frame, %s %.2f ms/frame, write %.2f ms/frame, %.1f MB\n",
+			stats.renderSeconds * 1000.0 / frames, m_FrameWriter.EncodesFrames() ? "encode" : "convert", stats.convertSeconds * 1000.0 / frames,
+			stats.writeSeconds * 1000.0 / frames, m_FrameWriter.GetBytesWritten() / 1048576.0);
+		printf("Export: %d threads, %d slots, workers stalled %.2f s, writer waited %.2f s\n",
+			stats.threads, stats.slots, stats.stallSeconds, stats.waitSeconds);
+		if (m_ExportElide) {
+			// Rendered frames stand in for what the elided ones would have cost.
+			const int rendered = Max(stats.frames - stats.elidedFrames, 1);
+			printf("Export: %d frames elided as repeats (%.1f%%), ~%.2f s of render and convert saved, keys %.2f ms/frame\n",
+				stats.elidedFrames, stats.elidedFrames * 100.0 / frames,
+				(stats.renderSeconds + stats.convertSeconds) / rendered * stats.elidedFrames, stats.keySeconds * 1000.0 / frames);
+		}
+		if (IsImageFormat(m_ExportFormat)) {
+			printf("Export: %d encoders, encode %.2f ms/image, %llu images, %llu linked as repeats, render blocked on encoders %.2f s\n",
+				encoders, images.GetEncodeSeconds() * 1000.0 / Max((int)images.GetImageCount(), 1),
+				(unsigned long long)images.GetImageCount(), (unsigned long long)images.GetRepeatCount(), images.GetBlockedSeconds());
+		}
+
+		if (m_ExportSegment && m_ExitCode == 0)
+			WriteSegment(settings, stats);
+		puts("End.\n");
+	}
+
+	void Application::WriteSegment(const ExportSettings& settings, const ExportStats& stats) {
+		std::filesystem::path video(m_ExportPath);
+		std::filesystem::path base = video;
+		// An image sequence keeps its slice and manifest next to the images.
+		if (IsImageFormat(m_ExportFormat)) {
+			if (m_ExportPath.find('%') == std::string::npos)
+				video /= std::string("%06d.") + GetFrameFormatName(m_ExportFormat);
+			char name[64];
+			snprintf(name, sizeof(name), "segment-%d-%d", settings.firstFrame, settings.firstFrame + settings.frames);
+			base = video.parent_path() / name;
+		}
+		const std::string audioPath = std::filesystem::path(base).replace_extension(".wav").string();
+		const std::string manifestPath = std::filesystem::path(base).replace_extension(".json").string();
+
+		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+		SegmentManifest manifest;
+		manifest.chart = converter.to_bytes(m_C.chart.info.name);
+		manifest.chartSeed = m_C.chart.data.seed;
+		manifest.width = m_ExportWidth;
+		manifest.height = m_ExportHeight;
+		manifest.fps = m_ExportFps;
+		manifest.format = m_ExportFormat;
+		manifest.framebuffer = settings.framebufferFormat;
+		manifest.startFrame = settings.firstFrame;
+		manifest.endFrame = settings.firstFrame + settings.frames;
+		manifest.video = video.filename().string();
+		manifest.audio = std::filesystem::path(audioPath).filename().string();
+		manifest.sampleRate = Mixer::SampleRate;
+		manifest.channels = Mixer::Channels;
+		manifest.startSample = FrameToSample(manifest.startFrame, manifest.fps, manifest.sampleRate);
+		manifest.endSample = FrameToSample(manifest.endFrame, manifest.fps, manifest.sampleRate);
+		manifest.frameHashes = stats.frameHashes;
+
+		if (!MixAudio(audioPath, (size_t)manifest.startSample, (size_t)manifest.endSample, nullptr)) {
+			printf("Failed to write %s\n", audioPath.c_str());
+			m_ExitCode = 1;
+			return;
+		}
+		if (!WriteManifest(manifestPath, manifest)) {
+			printf("Failed to write %s\n", manifestPath.c_str());
+			m_ExitCode = 1;
+			return;
+		}
+		printf("Segment: frames [%d, %d), samples [%lld, %lld), manifest %s\n",
+			manifest.startFrame, manifest.endFrame, (long long)manifest.startSample, (long long)manifest.endSample, manifestPath.c_str());
+	}
+
+	void Application::RunMerge() {
+		printf("Merging %zu segments into %s...\n\n", m_MergeManifests.size(), m_MergePath.c_str());
+
+		MergeStats stats;
+		if (!MergeSegments(m_MergeManifests, m_MergePath, &stats)) {
+			printf("Merge failed after %d segments, %d frames, %d hash mismatches\n", stats.segments, stats.frames, stats.hashMismatches);
+			m_ExitCode = 1;
+			return;
+		}
+		printf("Merge: %d segments, %d frames, %lld samples, all hashes match\n", stats.segments, stats.frames, (long long)stats.samples);
+		puts("End.\n");
+	}
+
+	void Application::RunVerifyManifest() {
+		SegmentManifest manifest;
+		if (!ReadManifest(m_VerifyManifestPath, manifest)) {
+			printf("Can't read manifest %s\n", m_VerifyManifestPath.c_str());
+			m_ExitCode = 1;
+			return;
+		}
+		if (manifest.chartSeed != m_C.chart.data.seed) {
+			printf("Manifest %s was made from a different chart\n", m_VerifyManifestPath.c_str());
+			m_ExitCode = 1;
+			return;
+		}
+
+		printf("Re-rendering frames [%d, %d) of %s to check their hashes...\n\n",
+			manifest.startFrame, manifest.endFrame, m_VerifyManifestPath.c_str());
+
+		// Hashes are of the converted frames, which for image formats are RGB24.
+		const FrameFormat format = IsImageFormat(manifest.format) ? FrameFormat::RGB24 : manifest.format;
+		FrameWriter writer;
+		if (!writer.Open(NullDevice(), format, manifest.width, manifest.height, manifest.fps)) {
+			printf("Failed to open %s\n", NullDevice());
+			m_ExitCode = 1;
+			return;
+		}
+
+		ExportSettings settings;
+		settings.fps = manifest.fps;
+		settings.firstFrame = manifest.startFrame;
+		settings.frames = manifest.endFrame - manifest.startFrame;
+		settings.threads = m_ExportThreads;
+		settings.elideRepeats = m_ExportElide;
+		settings.framebufferFormat = manifest.framebuffer;
+		settings.hashFrames = true;
+
+		ExportStats stats;
+		ExportFrames(m_C, m_C.camera, writer, settings, &stats);
+
+		int mismatches = 0;
+		for (int i = 0; i < settings.frames; i++) {
+			if (stats.frameHashes[i] == manifest.frameHashes[i])
+				continue;
+			if (mismatches++ < 10)
+				printf("  frame %d differs\n", manifest.startFrame + i);
+		}
+
+		printf("Verify manifest: %d frames, %d mismatches\n", settings.frames, mismatches);
+		m_ExitCode = mismatches ? 1 : 0;
+	}
+
+	void Application::RunQoiToPng() {
+		printf("Converting %s to PNG on %d threads...\n\n", m_QoiToPngPath.c_str(), m_ExportEncoders);
+
+		QoiConvertStats stats;
+		if (!ConvertQoiToPng(m_QoiToPngPath, m_ExportEncoders, &stats))
+			m_ExitCode = 1;
+		printf("QOI to PNG: %d files, %d failed in %.2f s, %.1f MB -> %.1f MB\n",
+			stats.files, stats.failed, stats.seconds, stats.qoiBytes / 1048576.0, stats.pngBytes / 1048576.0);
+		puts("End.\n");
+	}
+
+	void Application::RunPipelineBench() {
+		const int frames = m_PipelineBenchFrames;
+		const float duration = GetExportDuration();
+		const int width = m_ExportWidth, height = m_ExportHeight;
+		printf("Pipeline benchmark: %d frames over %.2f s at %dx%d, %s framebuffer, presented into a DIB-sized buffer\n\n",
+			frames, duration, width, height, GetFramebufferFormatName(m_FramebufferFormat));
+		printf("Depth      fps  Speedup  Render ms  Present ms  Latency ms  Max ms  Output\n");
+
+		using Clock = std::chrono::steady_clock;
+		std::vector<uint32_t> dib((size_t)width * height);
+		double base = 0.0;
+		uint64_t expected = 0;
+		int mismatches = 0;
+
+		for (int depth = 1; depth <= 3; depth++) {
+			ChartRenderer renderer(m_C);
+			FramePipeline pipeline(width, height, m_FramebufferFormat, depth);
+			double present = 0.0;
+			uint64_t hash = 14695981039346656037ULL;
+
+			auto presentFrames = [&](int keep) {
+				while (pipeline.GetInFlight() > keep) {
+					Framebuffer* framebuffer = pipeline.Acquire();
+					const Clock::time_point start = Clock::now();
+					framebuffer->CopyToBGRX(dib.data(), width, width, height);
+					present += std::chrono::duration<double>(Clock::now() - start).count();
+					for (uint32_t pixel : dib)
+						hash = (hash ^ pixel) * 1099511628211ULL;
+					pipeline.Release(framebuffer);
+				}
+			};
+
+			const Clock::time_point start = Clock::now();
+			for (int i = 0; i < frames; i++) {
+				const float t = duration * (float)i / (float)frames;
+				pipeline.Submit(width, height, [&renderer, this, t](Framebuffer* framebuffer) {
+					renderer.Render(framebuffer, t, m_C.camera);
+				});
+				presentFrames(depth - 1);
+			}
+			presentFrames(0);
+			const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+			// Every depth must show the same frames in the same order.
+			if (depth == 1)
+				expected = hash;
+			else if (hash != expected)
+				mismatches++;
+
+			const FramePipelineStats stats = pipeline.GetStats();
+			const double fps = frames / wall;
+			if (depth == 1)
+				base = fps;
+			printf("%5d %8.1f %7.2fx %10.2f %11.2f %11.2f %7.2f  %s\n", depth, fps, base > 0.0 ? fps / base : 0.0,
+				stats.renderSeconds * 1000.0 / frames, present * 1000.0 / frames,
+				stats.latencySum * 1000.0 / frames, stats.latencyMax * 1000.0, hash == expected ? "same" : "DIFFERENT");
+		}
+
+		m_ExitCode = mismatches ? 1 : 0;
+		puts("End.\n");
+	}
+
+	void Application::RunProfileBench() {
+		const int frames = m_ProfileBenchFrames;
+		const float duration = GetExportDuration();
+		const int width = m_ExportWidth, height = m_ExportHeight;
+		printf("Profile benchmark: %d frames over %.2f s at %dx%d, %s framebuffer, pipeline depth %d\n\n",
+			frames, duration, width, height, GetFramebufferFormatName(m_FramebufferFormat), m_PipelineDepth);
+
+		using Clock = std::chrono::steady_clock;
+		FrameProfiler profiler;
+		if (!m_ProfileCsvPath.empty() && !profiler.OpenCsv(m_ProfileCsvPath))
+			printf("Can't write %s\n", m_ProfileCsvPath.c_str());
+
+		// The viewer's path: rendered on the pipeline, presented into a DIB-sized buffer.
+		{
+			ChartRenderer renderer(m_C);
+			FramePipeline pipeline(width, height, m_FramebufferFormat, m_PipelineDepth);
+			std::vector<uint32_t> dib((size_t)width * height);
+
+			auto presentFrames = [&](int keep) {
+				while (pipeline.GetInFlight() > keep) {
+					FrameTimings timings;
+					Framebuffer* framebuffer = pipeline.Acquire(&timings);
+					const Clock::time_point start = Clock::now();
+					framebuffer->CopyToBGRX(dib.data(), width, width, height);
+					timings[ProfilePhase::Present] = std::chrono::duration<double>(Clock::now() - start).count();
+					pipeline.Release(framebuffer);
+					profiler.Record(timings);
+				}
+			};
+
+			for (int i = 0; i < frames; i++) {
+				const float t = duration * (float)i / (float)frames;
+				pipeline.Submit(width, height, [&renderer, this, t](Framebuffer* framebuffer) {
+					renderer.Render(framebuffer, t, m_C.camera);
+				});
+				presentFrames(pipeline.GetDepth() - 1);
+			}
+			presentFrames(0);
+		}
+		profiler.PrintStats();
+
+		// The timers' own cost: the same frames rendered with and without a
+		// target, alternating so both see the same cache and clock state.
+		ChartRenderer renderer(m_C);
+		Framebuffer* framebuffer = Framebuffer::Create(width, height, m_FramebufferFormat);
+		framebuffer->LoadFontTTF("font.ttf");
+		double plain = 0.0, timed = 0.0;
+		for (int i = 0; i < frames; i++) {
+			const float t = duration * (float)i / (float)frames;
+			for (int pass = 0; pass < 2; pass++) {
+				FrameTimings timings;
+				SetProfileTarget(pass ? &timings : nullptr);
+				const Clock::time_point start = Clock::now();
+				framebuffer->Clear(Vec3(0.0f));
+				renderer.Render(framebuffer, t, m_C.camera);
+				(pass ? timed : plain) += std::chrono::duration<double>(Clock::now() - start).count();
+			}
+		}
+		SetProfileTarget(nullptr);
+		delete framebuffer;
+
+#ifdef PGR_PROFILER
+		const char* build = "on";
+#else
+		const char* build = "compiled out";
+#endif
+		printf("\nTimers (%s): %.3f ms/frame untimed, %.3f ms/frame timed, overhead %+.2f%%\n", build,
+			plain * 1000.0 / frames, timed * 1000.0 / frames, plain > 0.0 ? (timed / plain - 1.0) * 100.0 : 0.0);
+		puts("End.\n");
+	}
+
+	void Application::RunExportScaling() {
+		const float duration = GetExportDuration();
+		// For image formats the encoders are the bottleneck, so those are
+		// scaled instead, behind a fixed set of render threads. QOI is encoded
+		// on the render threads, so it scales those like the video formats.
+		const bool images = IsImageFormat(m_ExportFormat) && m_ExportFormat != FrameFormat::QOI;
+		const int maxCount = images ? m_ExportEncoders : m_ExportThreads;
+
+		std::vector<int> counts;
+		for (int n = 1; n < maxCount; n *= 2)
+			counts.push_back(n);
+		counts.push_back(maxCount);
+
+		printf("Export scaling: %d frames (%.2f s) at %dx%d, %d fps, output discarded\n\n",
+			(int)std::ceil(duration * m_ExportFps), duration, m_ExportWidth, m_ExportHeight, m_ExportFps);
+		if (images)
+			printf("%d render threads, %s\nEncoders      fps  Speedup  Efficiency  Encode ms  Blocked s\n", m_ExportThreads, GetFrameFormatName(m_ExportFormat));
+		else
+			printf("Threads      fps  Speedup  Efficiency  Render ms  Stall s\n");
+
+		double base = 0.0;
+		for (int count : counts) {
+			FrameWriter writer;
+			// An empty image pattern encodes and drops every image.
+			const std::string path = IsImageFormat(m_ExportFormat) ? std::string() : std::string(NullDevice());
+			if (!writer.Open(path, m_ExportFormat, m_ExportWidth, m_ExportHeight, m_ExportFps, images ? count : m_ExportEncoders)) {
+				printf("Failed to open %s\n", path.c_str());
+				m_ExitCode = 1;
+				return;
+			}
+
+			ExportSettings settings;
+			settings.fps = m_ExportFps;
+			settings.frames = (int)std::ceil(duration * m_ExportFps);
+			settings.threads = images ? m_ExportThreads : count;
+			settings.elideRepeats = m_ExportElide;
+			settings.framebufferFormat = m_FramebufferFormat;
+
+			// Image output is only done once the encoders have drained.
+			const auto start = std::chrono::steady_clock::now();
+			ExportStats stats;
+			ExportFrames(m_C, m_C.camera, writer, settings, &stats);
+			writer.Close();
+			const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			const double fps = wall > 0.0 ? stats.frames / wall : 0.0;
+			if (count == 1)
+				base = fps;
+			const double speedup = base > 0.0 ? fps / base : 0.0;
+			const int frames = std::max(stats.frames, 1);
+			if (images) {
+				const ImageSequenceWriter& sequence = writer.GetImages();
+				printf("%8d  %7.1f  %6.2fx  %9.0f%%  %9.2f  %9.2f\n",
+					count, fps, speedup, speedup / count * 100.0,
+					sequence.GetEncodeSeconds() * 1000.0 / frames, sequence.GetBlockedSeconds());
+			}
+			else {
+				printf("%7d  %7.1f  %6.2fx  %9.0f%%  %9.2f  %7.2f\n",
+					count, fps, speedup, speedup / count * 100.0,
+					stats.renderSeconds * 1000.0 / frames, stats.stallSeconds);
+			}
+		}
+		puts("\nEnd.\n");
 	}
 
 	void Application::Init() {
 
+		if (m_ClockSim || m_PacingSim || !m_MergePath.empty() || !m_QoiToPngPath.empty())
+			return;
+
+		if (m_ExportSegment && m_ExportPath == "-") {
+			puts("A segment (--frames) needs a file to export to.");
+			m_ExitCode = 1;
+			return;
+		}
+
+		// Before anything is logged: exporting to stdout moves the log to stderr.
+		if (!m_ExportPath.empty() && !m_FrameWriter.Open(m_ExportPath, m_ExportFormat, m_ExportWidth, m_ExportHeight, m_ExportFps, m_ExportEncoders)) {
+			printf("Failed to open %s for export\n", m_ExportPath.c_str());
+			m_ExitCode = 1;
+			return;
+		}
+
+		m_Platform = Platform::Create(m_Headless);
 		LoadFiles();
 
-		Window::Init();
-		m_Window = Window::Create(m_Name, m_Width, m_Height);
+		if (!m_MixdownPath.empty() || m_VerifySeekFrames > 0 || !m_ExportPath.empty() || m_ExportScaling || !m_VerifyManifestPath.empty() || m_PipelineBenchFrames > 0 || m_ProfileBenchFrames > 0)
+			return;
 
-		m_Framebuffer = Framebuffer::Create(m_Width, m_Height);
-		m_Framebuffer->LoadFontTTF("font.ttf");
+		if (!m_Platform->OpenWindow(m_Name, m_Width, m_Height)) {
+			printf("No window with the %s platform; use --export, --mixdown or --verify-seek.\n", m_Platform->GetName());
+			m_ExitCode = 1;
+			return;
+		}
+
+		m_Renderer = new ChartRenderer(m_C);
+
+		m_Pipeline = new FramePipeline(m_Width, m_Height, m_FramebufferFormat, m_PipelineDepth);
+		if (!m_ProfileCsvPath.empty() && !m_Profiler.OpenCsv(m_ProfileCsvPath))
+			printf("Can't write %s\n", m_ProfileCsvPath.c_str());
+
+		if (m_AudioWavPath.empty())
+			m_AudioOutput = AudioOutput::Create();
+		else
+			m_AudioOutput = new NullOutput(m_AudioWavPath);
+		m_Clock.SetOutputLatency(m_AudioOutput->GetLatency());
+		m_Music.SetClock(&m_Clock);
+		if (!m_AudioOutput->Start(&m_Mixer))
+			puts("Audio output unavailable.");
 
-		m_Window->DrawFramebuffer(m_Framebuffer);
 		m_StartFrameTime = std::chrono::steady_clock::now();
 
 	}
 
 	void Application::Terminate() {
-		delete m_Window;
-		Window::Terminate();
-		delete m_Framebuffer;
+		// Its render thread draws with m_Renderer.
+		if (m_Pipeline) {
+			m_Pipeline->PrintStats();
+			delete m_Pipeline;
+			m_Pipeline = nullptr;
+		}
+		delete m_Renderer;
+		delete m_Platform;
+		m_Platform = nullptr;
+		// Every thread that records into the trace has been joined by now.
+		Trace::Stop();
+		if (m_Scheduler.GetStats().frames > 0)
+			m_Scheduler.PrintStats();
+		if (m_Profiler.GetFrames() > 0)
+			m_Profiler.PrintStats();
+		if (m_PresentFrames > 0)
+			printf("Present: %d frames, %.3f ms/frame (%s framebuffer)\n", m_PresentFrames,
+				m_PresentSeconds * 1000.0 / m_PresentFrames, GetFramebufferFormatName(m_FramebufferFormat));
 		delete m_C.chart.image;
 		delete m_C.noteImgs.click;
 		delete m_C.noteImgs.drag;
@@ -535,653 +902,276 @@ namespace PGR {
 			m_C.hitFxImgs[i] = nullptr;
 			delete m_C.hitFxImgs[i];
 		}
-		mciSendString("close click", NULL, 0, NULL);
-		mciSendString("close drag", NULL, 0, NULL);
-		mciSendString("close flick", NULL, 0, NULL);
+		delete m_C.atlas;
+		m_C.atlas = nullptr;
+		if (m_AudioOutput) {
+			m_AudioOutput->Stop();
+			m_Mixer.PrintStats(m_AudioOutput->GetLatency());
+			if (m_Music.IsOpen())
+				printf("Music: %llu underruns\n", (unsigned long long)m_Music.GetUnderruns());
+			m_Clock.PrintStats();
+			delete m_AudioOutput;
+			m_AudioOutput = nullptr;
+		}
 	}
 
 	void Application::Run() {
-		constexpr float TARGET_FPS = 60.0f;
-		constexpr float FRAME_TIME_MS = 1000.0f / TARGET_FPS;
-		
-		while (!m_Window->Closed()) {
-			const int currentWidth = m_Window->GetWidth();
-			const int currentHeight = m_Window->GetHeight();
-			if (m_Width != currentWidth || m_Height != currentHeight) {
-				m_Width = currentWidth;
-				m_Height = currentHeight;
-				if (m_Width > 0 && m_Height > 0) {
-					m_Framebuffer->Resize(m_Width, m_Height);
-				}
-			}
-
-			m_Window->PollInputEvents();
-			
-			if (m_Width > 0 && m_Height > 0) {
-				OnUpdate();
-			}
-
-			const auto currentTime = std::chrono::steady_clock::now();
-			m_LastFrameTime = currentTime;
-
-			constexpr double NANOSECONDS_TO_SECONDS = 1.0 / 1000000000.0;
-			if (IsPlaying) {
-				m_Time = static_cast<float>((currentTime - m_StartFrameTime).count() * NANOSECONDS_TO_SECONDS);
-			} else {
-				m_StartFrameTime = currentTime - std::chrono::milliseconds(static_cast<int>(m_Time * 1000));
-			}
+		if (!m_MixdownPath.empty()) {
+			RunMixdown();
+			return;
 		}
-	}
 
-	void Application::Render(float size, float ox, float oy) {
-
-		std::chrono::duration Time = std::chrono::steady_clock::now() - m_StartFrameTime;
-        float t = std::chrono::duration_cast<std::chrono::milliseconds>(Time).count() / 1000.0f;
-
-		DrawTexture(
-			m_C.chart.blurImage, 0, 0,
-			(float)m_Width / m_C.chart.blurImage->GetWidth(),
-			(float)m_Height / m_C.chart.blurImage->GetHeight()
-		);
-
-		m_Framebuffer->FillRect(0, 0, m_Width, m_Height, Vec4(0.0f, 0.0f, 0.0f, 0.2f));
+		if (m_ClockSim) {
+			RunClockSimulation();
+			return;
+		}
 
-		Texture* texture = m_C.chart.image;
-		DrawTexture(
-			texture, (int)(m_Width / 2 - m_Width * size / 2 + ox), (int)(m_Height / 2 - m_Height * size / 2 + oy),
-			(float)m_Width / texture->GetWidth() * size,
-			(float)m_Height / texture->GetHeight() * size
-		);
+		if (m_PacingSim) {
+			RunPacingSimulation();
+			return;
+		}
 
-		m_Framebuffer->FillRect(
-			(int)(m_Width / 2.0f - m_Width / 2.0f * m_C.camera.size + m_C.camera.Pos.X),
-			m_Height - (int)(m_Height / 2.0f - m_Height / 2.0f * m_C.camera.size + m_C.camera.Pos.Y),
-			(int)(m_Width / 2.0f + m_Width / 2.0f * m_C.camera.size + m_C.camera.Pos.X),
-			m_Height - (int)(m_Height / 2.0f + m_Height / 2.0f * m_C.camera.size + m_C.camera.Pos.Y),
-			Vec4(0.0f, 0.0f, 0.0f, 0.6f)
-		);
+		if (m_VerifySeekFrames > 0) {
+			RunVerifySeek();
+			return;
+		}
 
-		float noteW = noteSize * m_Width * size;
+		if (!m_MergePath.empty()) {
+			RunMerge();
+			return;
+		}
 
-		int combo = 0;
+		if (!m_VerifyManifestPath.empty()) {
+			RunVerifyManifest();
+			return;
+		}
 
-		for (size_t i = 0; i < m_C.chart.data.judgeLines.size(); i++) {
+		if (!m_QoiToPngPath.empty()) {
+			RunQoiToPng();
+			return;
+		}
 
-			JudgeLine line = m_C.chart.data.judgeLines[i];
+		if (m_PipelineBenchFrames > 0) {
+			RunPipelineBench();
+			return;
+		}
 
-			EventsValue e = line.getState(t);
-			EventsValue ev = e;
-			ev.x *= m_Width, ev.y *= m_Height;
-			ev.x = (ev.x - m_Width / 2) * size + m_Width / 2 + ox;
-			ev.y = (ev.y - m_Height / 2) * size + m_Height / 2 + oy;
-			Vec2 linePos[2] = {
-				rotatePoint(ev.x, ev.y, m_Height * lineh * size, ev.rotate),
-				rotatePoint(ev.x, ev.y, m_Height * lineh * size, ev.rotate + 180.0f)
-			};
+		if (m_ProfileBenchFrames > 0) {
+			RunProfileBench();
+			return;
+		}
 
-			m_Framebuffer->DrawLine(
-				(int)linePos[0].X, (int)linePos[0].Y,
-				(int)linePos[1].X, (int)linePos[1].Y,
-				m_Height * linew * size,
-				Vec4(i == m_Line ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : pcolor, __DEBUG__ ? ev.alpha * 0.99f + 0.01f : ev.alpha)
-			);
+		if (m_ExportScaling) {
+			RunExportScaling();
+			return;
+		}
 
-			Vec2 lineAPos = rotatePoint(ev.x, ev.y, m_Height * 0.025f, ev.rotate + 90.0f);
+		if (!m_ExportPath.empty()) {
+			if (m_FrameWriter.IsOpen())
+				RunExport();
+			return;
+		}
 
-			if (__DEBUG__) {
+		m_Scheduler.SetTargetFps(m_TargetFps);
 
-				m_Framebuffer->DrawLine(
-					(int)ev.x, (int)ev.y,
-					(int)lineAPos.X, (int)lineAPos.Y,
-					m_Height * linew * size, Vec4(i == m_Line ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : pcolor, ev.alpha * 0.99f + 0.01f)
-				);
+		while (m_Platform->IsWindowOpen()) {
+			const int events = m_Platform->PollEvents();
 
+			bool resized = false;
+			const int currentWidth = m_Platform->GetWidth();
+			const int currentHeight = m_Platform->GetHeight();
+			if (m_Width != currentWidth || m_Height != currentHeight) {
+				m_Width = currentWidth;
+				m_Height = currentHeight;
+				resized = true;
 			}
 
-			float beatt = line.sec2beat(t);
-			float lineFp = line.getFp(beatt);
-
-			JudgeLine& currentLine = m_C.chart.data.judgeLines[i];
-			float pgrwTimesWidth = pgrw * m_Width * size;
-			float PI_OVER_180 = PI / 180.0f;
-			float cosEvRotate = cos(ev.rotate * PI_OVER_180);
-			float sinEvRotate = sin(ev.rotate * PI_OVER_180);
-
-
-			if (__DEBUG__) {
-				char speedBuf[32];
-				sprintf(speedBuf, "%.2f", ev.speed);
-
-				char PosXBuf[32];
-				sprintf(PosXBuf, "%.2f", (double)e.x - (double)0.5f);
-
-				char PosYBuf[32];
-				sprintf(PosYBuf, "%.2f", (double)e.y - (double)0.5f);
-
-				std::string lineStr =
-					"[" + std::to_string(i) +
-					"] (" + PosXBuf +
-					", " + PosYBuf +
-					") " + std::to_string((int)ev.rotate) +
-					"d " + std::to_string((int)(ev.alpha * 100.0f)) +
-					": " + speedBuf;
-
-				m_Framebuffer->DrawCenterTextTTF(
-					(int)(ev.x + sin(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
-					(int)(m_Height - ev.y + cos(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
-					lineStr,
-					Vec4(i == m_Line ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : pcolor, ev.alpha * 0.9f + 0.1f), m_Width * 0.04f, -ev.rotate
-				);
-
-				if (m_Line == i) {
-					std::string lineStr =
-						"[" + std::to_string(m_Line) +
-						"] (" + PosXBuf +
-						", " + PosYBuf +
-						") " + std::to_string((int)ev.rotate) +
-						"d " + std::to_string((int)(ev.alpha * 100.0f)) +
-						": " + speedBuf;
-
-					m_Framebuffer->DrawCenterTextTTF(
-						(int)(m_Width / 2.0f),
-						(int)(m_Height - m_Height * 0.03f),
-						lineStr,
-						Vec4(1.0f), m_Width * 0.04f, 0.0f
-					);
-				}
-
+			// Paused with nothing new to show: the last frame stays up until input.
+			if (!IsPlaying && events == 0 && !resized && !IsInputHeld()) {
+				PresentFrames(0);
+				const double idleStart = PlaybackClock::Now();
+				m_Platform->WaitEvents(FrameScheduler::IdleTimeout);
+				m_Scheduler.Idle(idleStart, PlaybackClock::Now());
+				continue;
 			}
-		}
-
-		for (int i = 0; i < m_C.chart.data.judgeLines.size(); i++) {
-			JudgeLine line = m_C.chart.data.judgeLines[i];
-
-			EventsValue e = line.getState(t);
-			EventsValue ev = e;
-			ev.x *= m_Width, ev.y *= m_Height;
-			ev.x = (ev.x - m_Width / 2) * size + m_Width / 2 + ox;
-			ev.y = (ev.y - m_Height / 2) * size + m_Height / 2 + oy;
-
-			float beatt = line.sec2beat(t);
-			float lineFp = line.getFp(beatt);
-
-			JudgeLine& currentLine = m_C.chart.data.judgeLines[i];
-			float pgrwTimesWidth = pgrw * m_Width * size;
-			float PI_OVER_180 = PI / 180.0f;
-			float cosEvRotate = cos(ev.rotate * PI_OVER_180);
-			float sinEvRotate = sin(ev.rotate * PI_OVER_180);
-
-			auto& notes = currentLine.notes;
-			size_t notesCount = notes.size();
-			for (size_t j = 0; j < notesCount; j++) {
-				if (notes[j].sect < t && !notes[j].clicked) {
-					switch (notes[j].type) {
-					case 1:
-					case 3:
-						mciSendString("play click from 0", NULL, 0, NULL);
-						break;
-					case 2:
-						mciSendString("play drag from 0", NULL, 0, NULL);
-						break;
-					case 4:
-						mciSendString("play flick from 0", NULL, 0, NULL);
-						break;
-					}
-					notes[j].clicked = true;
-				}
-
-				const Note& note = notes[j];
-
-				if ((!note.isHold && note.sect < t) || (note.isHold && note.holdEndTime < t)) {
-					combo++;
-					continue;
-				}
-
-				float noteFp = (note.floorPosition - lineFp) * pgrh * (pgrbeat / line.bpm) * m_Height * size;
-
-				if (!note.isHold) {
-					noteFp *= note.speed;
-					if (noteFp < -1e6) {
-						continue;
-					}
-				}
-
-				if ((__DEBUG__ ? noteFp : noteFp / size) > m_Height * 2) {
-					continue;
-				}
-
-				if ((!note.isHold && noteFp < 0) || (note.isHold && noteFp < 0 && !note.clicked)) {
-					continue;
-				}
 
-				bool drawHead = note.sect > t;
-				Texture* noteHeadImg = m_C.noteHeadImgs[note.type - 1][note.morebets];
+			const int ticks = m_Scheduler.BeginFrame(PlaybackClock::Now());
 
-				float thisNoteWidth = 1.0f * noteSize * size;
+			// Audio-locked while the song plays, frozen while paused.
+			m_Time = (float)m_Clock.Update(PlaybackClock::Now());
+			if (IsPlaying)
+				ScheduleHitsounds();
 
-				if (note.morebets) {
-					thisNoteWidth = noteSize * size * (
-						(float)(m_C.noteHeadImgs[note.type - 1][1]->GetWidth())
-						/ (float)(m_C.noteHeadImgs[note.type - 1][0]->GetWidth())
-						);
-				}
-
-				float headImgWidth = (float)noteHeadImg->GetWidth();
-				float headImgHeight = (float)noteHeadImg->GetHeight();
-				float thisNoteHeadHeight = thisNoteWidth / headImgWidth * headImgHeight;
-				float posX = note.positionX * pgrwTimesWidth;
-
-				float noteAtlineX = ev.x + posX * cosEvRotate;
-				float noteAtlineY = ev.y + posX * sinEvRotate;
-				Vec2 noteAtlinePos(noteAtlineX, noteAtlineY);
-
-				float l2nRotate = ev.rotate - (note.isAbove ? -90 : 90);
-				float l2nRad = l2nRotate * PI_OVER_180;
-				float cosL2n = cos(l2nRad);
-				float sinL2n = sin(l2nRad);
-
-				float headX = noteAtlineX + noteFp * cosL2n;
-				float headY = noteAtlineY + noteFp * sinL2n;
-				Vec2 noteHeadPos(headX, headY);
-
-				float noteDrawRotate = ev.rotate - (note.isAbove ? 0 : 180);
-				float drawRad = noteDrawRotate * PI_OVER_180;
-				float cosDrawRad = cos(drawRad);
-				float sinDrawRad = sin(drawRad);
-
-				float texScale = thisNoteWidth * m_Width / headImgWidth;
-				float Size = m_Width * noteSize / headImgWidth * size;
-				float W = texScale * headImgWidth / 2.0f;
-				float H = texScale * headImgHeight / 2.0f;
-				float w = W * cosDrawRad - H * sinDrawRad;
-				float h = H * cosDrawRad + W * sinDrawRad;
-
-				float noteBodyHeight = 0.0f;
-
-				if (note.isHold) {
-					Texture* noteBodyImg = m_C.holdBodyImgs[note.morebets];
-					Texture* noteTailImg = m_C.holdTailImgs[note.morebets];
-
-					float noteTillHeight = thisNoteWidth * m_Width / noteTailImg->GetWidth() * noteTailImg->GetHeight();
-					float noteHeadHeight = thisNoteWidth * m_Width / headImgWidth * headImgHeight;
-
-					noteBodyHeight = Max(
-						note.holdLength * size * m_Height +
-						Min(0.0f, noteFp) +
-						(note.clicked ? noteHeadHeight : 0.0f) -
-						noteTillHeight * 1.5f,
-						0.0f
-					);
-
-					if (noteBodyHeight > 0.0f) {
-
-						float tailPosBaseX = note.clicked ? noteAtlineX : headX;
-						float tailPosBaseY = note.clicked ? noteAtlineY : headY;
-						float tailOffset = (note.clicked ? noteHeadHeight / 2.0f : noteHeadHeight) + noteBodyHeight;
-						float tailX = tailPosBaseX + tailOffset * cosL2n;
-						float tailY = tailPosBaseY + tailOffset * sinL2n;
-						Vec2 noteTailPos(tailX, tailY);
-
-						float headH = thisNoteWidth * m_Width / headImgWidth * headImgHeight;
-						float x = headX - w - headH * sinDrawRad;
-						float y = headY - h + headH * cosDrawRad;
-
-						float bodyTexScaleX = thisNoteWidth * m_Width / headImgWidth;
-						float bodyTexScaleY = noteBodyHeight / noteBodyImg->GetHeight();
-						DrawTexture(
-							noteBodyImg,
-							note.clicked ? (int)(noteAtlineX - w - headH / 2 * sinDrawRad) : (int)x,
-							note.clicked ? (int)(noteAtlineY - h + headH / 2 * cosDrawRad) : (int)y,
-							bodyTexScaleX, bodyTexScaleY,
-							noteDrawRotate
-						);
-
-						float tailImgWidth = (float)noteTailImg->GetWidth();
-						float tailImgHeight = (float)noteTailImg->GetHeight();
-						float tailS = m_Width * noteSize / tailImgWidth;
-						float tailW = tailS * tailImgWidth * thisNoteWidth / noteSize / 2.0f;
-						float tailH = tailS * tailImgHeight / 2.0f * size;
-						float tailw = tailW * cosDrawRad - tailH * sinDrawRad;
-						float tailh = tailH * cosDrawRad + tailW * sinDrawRad;
-
-						float tailTexScale = thisNoteWidth * m_Width / headImgWidth;
-						DrawTexture(
-							noteTailImg,
-							(int)(noteTailPos.X - tailw), (int)(noteTailPos.Y - tailh),
-							tailTexScale, tailTexScale,
-							noteDrawRotate
-						);
-
-					}
-				}
-
-				if (drawHead && ((note.isHold && noteBodyHeight > 0.0f) || !note.isHold)) {
-					DrawTexture(
-						noteHeadImg, (int)(noteHeadPos.X - w), (int)(noteHeadPos.Y - h),
-						texScale, texScale,
-						noteDrawRotate
-					);
-
-					if (__DEBUG__) {
-
-						const char* typeStr = "";
-
-						switch (note.type) {
-						case 1:
-							typeStr = "click";
-							break;
-						case 2:
-							typeStr = "drag";
-							break;
-						case 3:
-							typeStr = "hold";
-							break;
-						case 4:
-							typeStr = "flick";
-							break;
-						}
-
-						char PosXBuf[32], PosYBuf[32];
-
-						sprintf(PosXBuf, "%.2f", note.positionX);
-						sprintf(PosYBuf, "%.2f", noteFp / (pgrh * m_Height * size));
-
-						std::string noteStr =
-							"[" + std::to_string(i) +
-							"]" + std::to_string(j) +
-							"( " + PosXBuf +
-							"," + PosYBuf +
-							" ): " + typeStr +
-							": " + std::to_string((int)note.sect);
-
-						if (note.isHold)
-							noteStr += "/ " + std::to_string((int)note.holdEndTime);
-
-						m_Framebuffer->DrawCenterTextTTF(
-							(int)(noteHeadPos.X + sin(noteDrawRotate * PI_OVER_180) * m_Width * 0.03f),
-							(int)(m_Height - noteHeadPos.Y + cos(noteDrawRotate * PI_OVER_180) * m_Width * 0.03f),
-							noteStr, i == m_Line ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : Vec4(1.0f, 0.5f), m_Width * 0.025f, -noteDrawRotate
-						);
-
-					}
-				}
+			if (m_Width > 0 && m_Height > 0) {
+				OnInput();
+				for (int i = 0; i < ticks; i++)
+					OnTick();
+				OnRender();
 			}
-		}
-
-		float effectDur = 0.5f;
-		float pgrwTimesWidthEffect = pgrw * m_Width * size;
-		float PI_OVER_180_EFFECT = PI / 180.0f;
-		size_t effectCount = m_C.chart.data.clickEffectCollection.size();
-		const auto& hitFxImgs = m_C.hitFxImgs;
-		size_t hitFxImgsCount = hitFxImgs.size();
-
-		for (size_t effectIdx = 0; effectIdx < effectCount; effectIdx++) {
-			const NoteMap& nm = m_C.chart.data.clickEffectCollection[effectIdx];
-			if (nm.sect > t) break;
-			if (nm.sect + effectDur < t) continue;
-
-			float p = (t - nm.sect) / effectDur;
-			float alpha = 1.0f - p;
-
-			size_t imgIndex = static_cast<size_t>(Max(0.0f, Min(static_cast<float>(hitFxImgsCount - 1), floor(p * hitFxImgsCount))));
-			Texture* img = hitFxImgs[imgIndex];
-			float effectSize = noteW * 1.375f * 1.12f;
-			float halfEffectSize = effectSize * 0.5f;
-
-			JudgeLine& line = m_C.chart.data.judgeLines[nm.note.line];
-			EventsValue ev = line.getState(nm.sect);
-
-			ev.x *= m_Width; ev.y *= m_Height;
-			ev.x = (ev.x - m_Width / 2) * size + m_Width / 2;
-			ev.y = (ev.y - m_Height / 2) * size + m_Height / 2;
-
-			float posX = ev.x;
-			float posY = ev.y;
-			float rotRad = ev.rotate * PI_OVER_180_EFFECT;
-			float cosRot = cos(rotRad);
-			float sinRot = sin(rotRad);
-			float offsetX = nm.note.positionX * pgrwTimesWidthEffect;
-
-			float finalX = posX + offsetX * cosRot + ox;
-			float finalY = posY + offsetX * sinRot + oy;
-			Vec2 pos(finalX, finalY);
-
-			float texScale = effectSize / img->GetWidth();
-			DrawTexture(
-				img,
-				(int)(finalX - halfEffectSize), (int)(finalY - halfEffectSize),
-				texScale
-			);
-
-			for (int parIdx = 0; parIdx < 4; parIdx++) {
-				const Vec3& parItem = nm.particles.pars[parIdx];
-
-				float s = m_Width / 4040.0f * 3.0f;
-
-				float parRad = parItem.X * PI_OVER_180_EFFECT;
-				float cosParRad = cos(parRad);
-				float sinParRad = sin(parRad);
-
-				float parCenterX = parItem.Z * s * cosParRad * size;
-				float parCenterY = parItem.Z * s * sinParRad * size;
-				float scaledParSize = parItem.Y * p * size;
-
-				float pScaledCenterX = parCenterX * (9.0f * p / (8.0f * p + 1.0f));
-				float pScaledCenterY = parCenterY * (9.0f * p / (8.0f * p + 1.0f));
-				float x1 = pScaledCenterX + finalX;
-				float y1 = m_Height - (pScaledCenterY + finalY);
 
-				m_Framebuffer->FillSizeRect((int)x1, (int)y1, (int)(parItem.Y * size * s), (int)(parItem.Y * size * s), Vec4(pcolor, alpha));
-			}
+			m_LastFrameTime = std::chrono::steady_clock::now();
+			WaitUntil(m_Scheduler.EndFrame(PlaybackClock::Now()));
 		}
+	}
 
-		float endTime = m_C.chart.data.time;
-
-		m_Framebuffer->FillRect(
-			0, 0,
-			(int)(m_Width * (Min(t, endTime) / endTime)), (int)(m_Height * 12.0f / 1080.0f),
-			Vec4(0.45f, 1.0f)
-		);
-
-		m_Framebuffer->FillRect(
-			(int)(m_Width * (Min(t, endTime) / endTime) - 0.5f), 0,
-			(int)(m_Width * (Min(t, endTime) / endTime) + 0.5f), (int)(m_Height * 12.0f / 1080.0f),
-			Vec4(1.0f, 1.0f)
-		);
-
-		m_Framebuffer->FillRect(
-			(int)(m_Width * 33.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f),
-			(int)(m_Width * 45.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f + m_Width * 39.0f / 1920.0f),
-			Vec4(1.0f)
-		);
-
-		m_Framebuffer->FillRect(
-			(int)(m_Width * 56.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f),
-			(int)(m_Width * 68.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f + m_Width * 39.0f / 1920.0f),
-			Vec4(1.0f)
-		);
-
-		if (combo >= 3) {
-			m_Framebuffer->DrawCenterTextTTF(
-				(int)(m_Width * 0.5f), (int)(m_Height * 39.0f / 1080.0f + m_Width * 60.0f / 1920.0f),
-				std::to_string(combo), Vec4(1.0f), (m_Width * 86.0f / 1920.0f), 0.0f
-			);
-
-			m_Framebuffer->DrawCenterTextTTF(
-				(int)(m_Width * 0.5f), (int)((m_Height * 39.0f / 1080.0f + m_Width * 60.0f / 1920.0f) * 84.0f / 63.0f),
-				"AUTOPLAY", Vec4(1.0f), (m_Width * 34.0f / 1920.0f), 0.0f
-			);
+	bool Application::IsInputHeld() const {
+		static const uint32_t keys[] = { PGR_KEY_W, PGR_KEY_A, PGR_KEY_S, PGR_KEY_D, PGR_KEY_F, PGR_KEY_R, PGR_BUTTON_LEFT };
+		for (uint32_t key : keys) {
+			if (m_Platform->GetKey(key) == PGR_PRESS)
+				return true;
 		}
+		return false;
+	}
 
-		float score = (float)combo / m_C.chart.data.noteCount * 1000000.0f;
-		char scoreStr[10];
-		sprintf(scoreStr, "%07d", (int)score);
-		m_Framebuffer->DrawTextTTF(
-			(int)(m_Width - (m_Width * 365.0f / 1920.0f)), (int)(m_Height * 39.0f / 1080.0f),
-			scoreStr, Vec4(1.0f), m_Width * 70.0f / 1920.0f
-		);
-
-		m_Framebuffer->DrawWTextTTF(
-			(int)(m_Width * 48.0f / 1920.0f), (int)(m_Height * 980.0f / 1080.0f),
-			m_C.chart.info.name, Vec4(1.0f), m_Width * 60.0f / 1920.0f
-		);
-
-		m_Framebuffer->DrawWTextTTF(
-			(int)(m_Width - m_Width * 35.0f / 1920.0f * m_C.chart.info.level.length()), (int)(m_Height * 980.0f / 1080.0f),
-			m_C.chart.info.level, Vec4(1.0f), m_Width * 60.0f / 1920.0f
-		);
-
-		if (IsPlaying) {
-			static float lastFPSTime = 0.0f;
-			static int frameCount = 0;
-			frameCount++;
-			float currentTime = static_cast<float>((std::chrono::steady_clock::now() - m_StartFrameTime).count() * 0.000000001f);
-			float fps = frameCount / (currentTime - lastFPSTime);
-			m_Framebuffer->DrawTextTTF(
-				0, (int)(m_Height * 12.0f / 1080.0f), "FPS: " + std::to_string((int)fps), Vec4(1.0f), m_Height * 30.0f / 1080.0f
+	// Render thread: everything it draws from is passed in.
+	void Application::DrawHud(Framebuffer* framebuffer, int fps, bool playing, const FrameTimings* profile) const {
+		PGR_PROFILE_SCOPE(Hud);
+		const int height = framebuffer->GetHeight();
+		if (playing) {
+			framebuffer->DrawTextTTF(
+				0, (int)(height * 12.0f / 1080.0f), "FPS: " + std::to_string(fps), Vec4(1.0f), height * 30.0f / 1080.0f
 			);
-			lastFPSTime = currentTime;
-			frameCount = 0;
 		}
 		else {
-			m_Framebuffer->DrawTextTTF(
-				0, (int)(m_Height * 12.0f / 1080.0f), "FPS: " + std::to_string(0), Vec4(1.0f, 0.0f, 0.0f, 1.0f), m_Height * 30.0f / 1080.0f
+			framebuffer->DrawTextTTF(
+				0, (int)(height * 12.0f / 1080.0f), "FPS: " + std::to_string(0), Vec4(1.0f, 0.0f, 0.0f, 1.0f), height * 30.0f / 1080.0f
 			);
 		}
 
-		if (m_Line != -1 && __DEBUG__) {
-			JudgeLine line = m_C.chart.data.judgeLines[m_Line];
-
-			EventsValue e = line.getState(t);
-			EventsValue ev = e;
-			ev.x *= m_Width, ev.y *= m_Height;
-			ev.x = (ev.x - m_Width / 2) * size + m_Width / 2 + ox;
-			ev.y = (ev.y - m_Height / 2) * size + m_Height / 2 + oy;
-			Vec2 linePos[2] = {
-				rotatePoint(ev.x, ev.y, m_Height * lineh * size, ev.rotate),
-				rotatePoint(ev.x, ev.y, m_Height * lineh * size, ev.rotate + 180.0f)
-			};
-
-			m_Framebuffer->DrawLine(
-				(int)linePos[0].X, (int)linePos[0].Y,
-				(int)linePos[1].X, (int)linePos[1].Y,
-				m_Height* linew* size,
-				Vec4(0.0f, 1.0f, 0.0f, 1.0f)
-			);
-
-			Vec2 lineAPos = rotatePoint(ev.x, ev.y, m_Height * 0.025f, ev.rotate + 90.0f);
-
-			m_Framebuffer->DrawLine(
-				(int)ev.x, (int)ev.y,
-				(int)lineAPos.X, (int)lineAPos.Y,
-				m_Height * linew * size, Vec4(0.0f, 1.0f, 0.0f, 1.0f)
+		if (!profile)
+			return;
+		const float lineHeight = height * 26.0f / 1080.0f;
+		for (int i = 0; i <= ProfilePhaseCount; i++) {
+			char line[64];
+			if (i < ProfilePhaseCount)
+				sprintf(line, "%-12s %6.2f ms", GetProfilePhaseName((ProfilePhase)i), profile->seconds[i] * 1000.0);
+			else
+				sprintf(line, "%-12s %6.2f ms", "total", profile->GetTotal() * 1000.0);
+			framebuffer->DrawTextTTF(
+				0, (int)(height * 50.0f / 1080.0f + lineHeight * i), line, Vec4(1.0f, 1.0f, 0.0f, 1.0f), height * 24.0f / 1080.0f
 			);
+		}
+	}
 
-			float beatt = line.sec2beat(t);
-			float lineFp = line.getFp(beatt);
-
-			JudgeLine& currentLine = m_C.chart.data.judgeLines[m_Line];
-			auto& notes = currentLine.notes;
-			size_t notesCount = notes.size();
-			float pgrwTimesWidth = pgrw * m_Width * size;
-			float PI_OVER_180 = PI / 180.0f;
-			float cosEvRotate = cos(ev.rotate * PI_OVER_180);
-			float sinEvRotate = sin(ev.rotate * PI_OVER_180);
-
-			char speedBuf[32];
-			sprintf(speedBuf, "%.2f", ev.speed);
-
-			char PosXBuf[32];
-			sprintf(PosXBuf, "%.2f", (double)e.x - (double)0.5f);
-
-			char PosYBuf[32];
-			sprintf(PosYBuf, "%.2f", (double)e.y - (double)0.5f);
-
-			std::string lStr =
-				"[" + std::to_string(m_Line) +
-				"] (" + PosXBuf +
-				", " + PosYBuf +
-				") " + std::to_string((int)ev.rotate) +
-				"d " + std::to_string((int)(ev.alpha * 100.0f)) +
-				": " + speedBuf;
-
-			m_Framebuffer->DrawCenterTextTTF(
-				(int)(ev.x + sin(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
-				(int)(m_Height - ev.y + cos(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
-				lStr,
-				Vec4(0.0f, 1.0f, 0.0f, 1.0f), m_Width * 0.04f, -ev.rotate
-			);
+	void Application::SubmitFrame() {
+		const float currentTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_StartFrameTime).count();
+		const int fps = (int)(1.0f / (currentTime - m_LastHudTime));
+		m_LastHudTime = currentTime;
+
+		// A snapshot: the main thread goes on changing these while the frame renders.
+		const float t = m_Time;
+		const Camera camera = m_C.camera;
+		const bool debug = __DEBUG__;
+		const int line = m_Line;
+		const bool playing = IsPlaying;
+		const bool showProfile = m_ShowProfile;
+		// Averaged over a second, so the numbers hold still long enough to read.
+		const FrameTimings profile = m_Profiler.GetAverage(60);
+		m_Pipeline->Submit(m_Width, m_Height, [=](Framebuffer* framebuffer) {
+			m_Renderer->Render(framebuffer, t, camera, debug, line);
+			DrawHud(framebuffer, fps, playing, showProfile ? &profile : nullptr);
+		});
+	}
 
-			std::string lineStr =
-				"[" + std::to_string(m_Line) +
-				"] (" + PosXBuf +
-				", " + PosYBuf +
-				") " + std::to_string((int)ev.rotate) +
-				"d " + std::to_string((int)(ev.alpha * 100.0f)) +
-				": " + speedBuf;
-
-			m_Framebuffer->DrawCenterTextTTF(
-				(int)(m_Width / 2.0f),
-				(int)(m_Height - m_Height * 0.03f),
-				lineStr,
-				Vec4(0.0f, 1.0f, 0.0f, 1.0f), m_Width * 0.04f, 0.0f
-			);
+	void Application::PresentFrames(int keep) {
+		while (m_Pipeline->GetInFlight() > keep) {
+			FrameTimings timings;
+			Framebuffer* framebuffer = m_Pipeline->Acquire(&timings);
+			double present;
+			{
+				PGR_TRACE_SCOPE("present", "frame");
+				const auto start = std::chrono::steady_clock::now();
+				m_Platform->Present(framebuffer);
+				present = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+			m_PresentSeconds += present;
+			m_PresentFrames++;
+			m_Pipeline->Release(framebuffer);
 
+			timings[ProfilePhase::Present] = present;
+			m_Profiler.Record(timings);
 		}
 	}
 
-	void Application::OnUpdate() {
-
-		if (m_Window->GetKey(PGR_KEY_W))
+	// Held keys, at the fixed tick rate so they move the same at any frame rate.
+	void Application::OnTick() {
+		if (m_Platform->GetKey(PGR_KEY_W))
 			m_C.camera.Pos.Y -= 2.0f;
-		if (m_Window->GetKey(PGR_KEY_S))
+		if (m_Platform->GetKey(PGR_KEY_S))
 			m_C.camera.Pos.Y += 2.0f;
-		if (m_Window->GetKey(PGR_KEY_A))
+		if (m_Platform->GetKey(PGR_KEY_A))
 			m_C.camera.Pos.X += 2.0f;
-		if (m_Window->GetKey(PGR_KEY_D))
+		if (m_Platform->GetKey(PGR_KEY_D))
 			m_C.camera.Pos.X -= 2.0f;
 
-		if (m_Window->GetWhell() < 0) {
+		if (m_Platform->GetKey(PGR_KEY_F))
+			m_Line = m_Line == (int)m_C.chart.data.judgeLines.size() - 1 ? -1 : m_Line + 1;
+		if (m_Platform->GetKey(PGR_KEY_R))
+			m_Line = m_Line == -1 ? (int)m_C.chart.data.judgeLines.size() - 1 : m_Line - 1;
+	}
+
+	// Once per frame: the wheel, clicks and toggles.
+	void Application::OnInput() {
+		if (m_Platform->GetWheel() < 0) {
 			float nSize = m_C.camera.size - m_C.camera.size * 0.01f;
-			float mx = (float)m_Window->GetMouseX() - (float)m_Width / 2.0f;
-			float my = -((float)m_Window->GetMouseY() - (float)m_Height / 2.0f);
+			float mx = (float)m_Platform->GetMouseX() - (float)m_Width / 2.0f;
+			float my = -((float)m_Platform->GetMouseY() - (float)m_Height / 2.0f);
 			m_C.camera.Pos.X = nSize / m_C.camera.size * m_C.camera.Pos.X - mx * (nSize / m_C.camera.size - 1.0f);
 			m_C.camera.Pos.Y = nSize / m_C.camera.size * m_C.camera.Pos.Y - my * (nSize / m_C.camera.size - 1.0f);
 			m_C.camera.size = nSize;
 		}
 
-		if (m_Window->GetWhell() > 0) {
+		if (m_Platform->GetWheel() > 0) {
 			float nSize = m_C.camera.size + 0.01f;
-			float mx = (float)m_Window->GetMouseX() - (float)m_Width / 2.0f;
-			float my = -((float)m_Window->GetMouseY() - (float)m_Height / 2.0f);
+			float mx = (float)m_Platform->GetMouseX() - (float)m_Width / 2.0f;
+			float my = -((float)m_Platform->GetMouseY() - (float)m_Height / 2.0f);
 			m_C.camera.Pos.X = nSize / m_C.camera.size * m_C.camera.Pos.X - mx * (nSize / m_C.camera.size - 1.0f);
 			m_C.camera.Pos.Y = nSize / m_C.camera.size * m_C.camera.Pos.Y - my * (nSize / m_C.camera.size - 1.0f);
 			m_C.camera.size = nSize;
 		}
 
-		if (m_Window->GetKey(PGR_KEY_SPACE) && !IsSpace) {
+		if (m_Platform->GetKey(PGR_KEY_SPACE) && !IsSpace) {
 			IsPlaying = !IsPlaying;
 			IsSpace = true;
 
 			if (IsPlaying) {
-				std::string str = "play music";
-				mciSendString(str.c_str(), NULL, 0, NULL);
+				const double now = PlaybackClock::Now();
+				m_Clock.Seek(m_Time, now);
+				m_Clock.Play(now);
+				if (m_PlatformMusic)
+					m_Platform->PlayMusic();
+				else {
+					m_Music.Seek(m_Time);
+					m_Music.Play();
+				}
+			}
+			else {
+				m_Clock.Pause();
+				if (m_PlatformMusic)
+					m_Platform->PauseMusic();
+				else
+					m_Music.Pause();
 			}
-			else
-				mciSendString("pause music", NULL, 0, NULL);
 
 		}
 
-		if (m_Window->GetKey(PGR_KEY_SPACE) == PGR_RELEASE) {
+		if (m_Platform->GetKey(PGR_KEY_SPACE) == PGR_RELEASE) {
 			IsSpace = false;
 		}
 
-		if (!IsPress && m_Window->GetKey(PGR_BUTTON_LEFT)) {
-			OriL = Vec2((float)(m_Window->GetMouseX()), (float)(m_Window->GetMouseY()));
+		if (m_Platform->GetKey(PGR_KEY_P) && !IsProfileKey) {
+			m_ShowProfile = !m_ShowProfile;
+			IsProfileKey = true;
+		}
+		else if (m_Platform->GetKey(PGR_KEY_P) == PGR_RELEASE)
+			IsProfileKey = false;
+
+		if (!IsPress && m_Platform->GetKey(PGR_BUTTON_LEFT)) {
+			OriL = Vec2((float)(m_Platform->GetMouseX()), (float)(m_Platform->GetMouseY()));
 			IsPress = true;
 		}
-		else if (IsPress && m_Window->GetKey(PGR_BUTTON_LEFT)) {
-			Vec2 nowL = Vec2((float)(m_Window->GetMouseX()), (float)(m_Window->GetMouseY()));
+		else if (IsPress && m_Platform->GetKey(PGR_BUTTON_LEFT)) {
+			Vec2 nowL = Vec2((float)(m_Platform->GetMouseX()), (float)(m_Platform->GetMouseY()));
 			Vec2 delta = nowL - OriL;
 			m_C.camera.Pos.X += delta.X;
 			m_C.camera.Pos.Y -= delta.Y;
@@ -1190,26 +1180,27 @@ namespace PGR {
 		else if (IsPress)
 			IsPress = false;
 
-		if (m_Window->GetKey(PGR_KEY_F))
-			m_Line = m_Line == (int)m_C.chart.data.judgeLines.size() - 1 ? -1 : m_Line + 1;
-		if (m_Window->GetKey(PGR_KEY_R))
-			m_Line = m_Line == -1 ? (int)m_C.chart.data.judgeLines.size() - 1 : m_Line - 1;
-
-		if (m_Window->GetKey(PGR_KEY_C))
+		if (m_Platform->GetKey(PGR_KEY_C))
 			__DEBUG__ = true;
-		if (m_Window->GetKey(PGR_KEY_V))
+		if (m_Platform->GetKey(PGR_KEY_V))
 			__DEBUG__ = false;
 
-
-		if (!m_Window->IsActive()) {
+		if (!m_Platform->IsActive()) {
 			IsPlaying = false;
-			mciSendString("pause music", NULL, 0, NULL);
-		}
-		else {
-			m_Framebuffer->Clear(Vec3(0.0f));
-			Render(m_C.camera.size, m_C.camera.Pos.X, m_C.camera.Pos.Y);
-			m_Window->DrawFramebuffer(m_Framebuffer);
+			m_Clock.Pause();
+			if (m_PlatformMusic)
+				m_Platform->PauseMusic();
+			else
+				m_Music.Pause();
 		}
 	}
 
-}
+	// Frame N+1 renders on the pipeline's thread while frame N is presented
+	// here, keeping depth - 1 frames behind the one on screen.
+	void Application::OnRender() {
+		if (m_Platform->IsActive())
+			SubmitFrame();
+		PresentFrames(m_Pipeline->GetDepth() - 1);
+	}
+
+}
\ No newline at end of file
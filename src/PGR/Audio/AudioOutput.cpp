@@ -0,0 +1,140 @@
+#include "AudioOutput.h"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace PGR {
+
+	NullOutput::NullOutput(const std::string& wavPath)
+		: m_WavPath(wavPath) {
+	}
+
+	NullOutput::~NullOutput() {
+		Stop();
+	}
+
+	bool NullOutput::Start(Mixer* mixer) {
+		if (!m_WavPath.empty() && !m_Writer.Open(m_WavPath, Mixer::SampleRate, Mixer::Channels))
+			return false;
+
+		m_Running = true;
+		m_Thread = std::thread([this, mixer]() {
+			std::vector<float> block(BlockFrames * Mixer::Channels);
+			const auto period = std::chrono::duration<double>((double)BlockFrames / Mixer::SampleRate);
+			auto next = std::chrono::steady_clock::now();
+			while (m_Running) {
+				mixer->Render(block.data(), BlockFrames);
+				if (m_Writer.IsOpen())
+					m_Writer.Write(block.data(), BlockFrames);
+				next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+				std::this_thread::sleep_until(next);
+			}
+		});
+		return true;
+	}
+
+	void NullOutput::Stop() {
+		m_Running = false;
+		if (m_Thread.joinable())
+			m_Thread.join();
+		m_Writer.Close();
+	}
+
+#ifdef _WIN32
+
+	// waveOut with a ring of BlockCount 16-bit blocks, refilled whenever the
+	// device signals that one has finished playing.
+	class WinMMOutput : public AudioOutput {
+	public:
+		~WinMMOutput() override {
+			Stop();
+		}
+
+		bool Start(Mixer* mixer) override {
+			WAVEFORMATEX format = {};
+			format.wFormatTag = WAVE_FORMAT_PCM;
+			format.nChannels = Mixer::Channels;
+			format.nSamplesPerSec = Mixer::SampleRate;
+			format.wBitsPerSample = 16;
+			format.nBlockAlign = (WORD)(format.nChannels * format.wBitsPerSample / 8);
+			format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+			m_Event = CreateEvent(NULL, FALSE, FALSE, NULL);
+			if (waveOutOpen(&m_Device, WAVE_MAPPER, &format, (DWORD_PTR)m_Event, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR) {
+				CloseHandle(m_Event);
+				m_Device = NULL;
+				return false;
+			}
+
+			for (int i = 0; i < BlockCount; i++) {
+				m_Data[i].resize(BlockFrames * Mixer::Channels);
+				m_Headers[i] = {};
+				m_Headers[i].lpData = (LPSTR)m_Data[i].data();
+				m_Headers[i].dwBufferLength = (DWORD)(m_Data[i].size() * sizeof(int16_t));
+				waveOutPrepareHeader(m_Device, &m_Headers[i], sizeof(WAVEHDR));
+				m_Headers[i].dwFlags |= WHDR_DONE;
+			}
+
+			m_Running = true;
+			m_Thread = std::thread([this, mixer]() {
+				std::vector<float> block(BlockFrames * Mixer::Channels);
+				while (m_Running) {
+					for (int i = 0; i < BlockCount; i++) {
+						if (!(m_Headers[i].dwFlags & WHDR_DONE))
+							continue;
+						mixer->Render(block.data(), BlockFrames);
+						for (size_t j = 0; j < block.size(); j++)
+							m_Data[i][j] = (int16_t)(std::max(-1.0f, std::min(block[j], 1.0f)) * 32767.0f);
+						m_Headers[i].dwFlags &= ~WHDR_DONE;
+						waveOutWrite(m_Device, &m_Headers[i], sizeof(WAVEHDR));
+					}
+					WaitForSingleObject(m_Event, 100);
+				}
+			});
+			return true;
+		}
+
+		void Stop() override {
+			if (!m_Device)
+				return;
+			m_Running = false;
+			SetEvent(m_Event);
+			if (m_Thread.joinable())
+				m_Thread.join();
+			waveOutReset(m_Device);
+			for (int i = 0; i < BlockCount; i++)
+				waveOutUnprepareHeader(m_Device, &m_Headers[i], sizeof(WAVEHDR));
+			waveOutClose(m_Device);
+			CloseHandle(m_Event);
+			m_Device = NULL;
+		}
+
+	private:
+		HWAVEOUT m_Device = NULL;
+		HANDLE m_Event = NULL;
+		WAVEHDR m_Headers[BlockCount];
+		std::vector<int16_t> m_Data[BlockCount];
+		std::thread m_Thread;
+		std::atomic<bool> m_Running{ false };
+	};
+
+	AudioOutput* AudioOutput::Create() {
+		return new WinMMOutput();
+	}
+
+#else
+
+	AudioOutput* AudioOutput::Create() {
+		return new NullOutput();
+	}
+
+#endif
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "PGR/Audio/Mixer.h"
+
+#include <thread>
+#include <atomic>
+#include <string>
+
+namespace PGR {
+
+	// Pulls blocks from a Mixer on its own thread and hands them to a sink.
+	class AudioOutput {
+	public:
+		static constexpr int BlockFrames = 512;
+		static constexpr int BlockCount = 4;
+
+		virtual ~AudioOutput() = default;
+
+		virtual bool Start(Mixer* mixer) = 0;
+		virtual void Stop() = 0;
+
+		// Audio queued ahead of the speaker, in seconds.
+		virtual double GetLatency() const { return (double)BlockFrames * BlockCount / Mixer::SampleRate; }
+
+		// The sound device on Windows, a NullOutput elsewhere.
+		static AudioOutput* Create();
+	};
+
+	// Headless output: mixes in real time and throws the result away, or writes
+	// it to a WAV file when a path is given.
+	class NullOutput : public AudioOutput {
+	public:
+		NullOutput(const std::string& wavPath = "");
+		~NullOutput() override;
+
+		bool Start(Mixer* mixer) override;
+		void Stop() override;
+
+	private:
+		std::string m_WavPath;
+		WavWriter m_Writer;
+		std::thread m_Thread;
+		std::atomic<bool> m_Running{ false };
+	};
+
+}
@@ -0,0 +1,110 @@
+#include "Mixdown.h"
+
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+namespace PGR {
+
+	static constexpr size_t ChunkFrames = 1 << 16;
+
+	bool MixdownToWav(
+		const std::string& path,
+		const AudioClip& song,
+		const std::vector<AudioClip>& sounds,
+		const std::vector<MixdownHit>& hits,
+		int threads,
+		MixdownStats* stats,
+		size_t begin,
+		size_t end
+	) {
+		const auto start = std::chrono::steady_clock::now();
+
+		const int channels = song.channels;
+		const int rate = song.sampleRate;
+
+		size_t maxHitFrames = 0;
+		for (const AudioClip& s : sounds)
+			maxHitFrames = std::max(maxHitFrames, s.GetFrameCount());
+
+		std::vector<int64_t> offsets(hits.size());
+		size_t total = song.GetFrameCount();
+		for (size_t i = 0; i < hits.size(); i++) {
+			offsets[i] = (int64_t)std::llround(hits[i].time * rate);
+			const int s = hits[i].sound;
+			if (s >= 0 && s < (int)sounds.size() && offsets[i] >= 0)
+				total = std::max(total, (size_t)offsets[i] + sounds[s].GetFrameCount());
+		}
+
+		if (end != (size_t)-1)
+			total = end;
+		begin = std::min(begin, total);
+
+		const size_t chunkCount = (total - begin + ChunkFrames - 1) / ChunkFrames;
+		std::vector<int16_t> pcm((total - begin) * channels);
+		std::atomic<size_t> next{ 0 };
+
+		auto worker = [&]() {
+			std::vector<float> mix(ChunkFrames * channels);
+			for (size_t c = next++; c < chunkCount; c = next++) {
+				const size_t c0 = begin + c * ChunkFrames;
+				const size_t c1 = std::min(c0 + ChunkFrames, total);
+				const size_t n = c1 - c0;
+
+				std::fill(mix.begin(), mix.end(), 0.0f);
+				if (c0 < song.GetFrameCount()) {
+					const size_t m = std::min(n, song.GetFrameCount() - c0) * channels;
+					const float* src = song.samples.data() + c0 * channels;
+					std::copy(src, src + m, mix.begin());
+				}
+
+				// First hit that can still be sounding at c0.
+				size_t h = std::lower_bound(offsets.begin(), offsets.end(), (int64_t)c0 - (int64_t)maxHitFrames) - offsets.begin();
+				for (; h < hits.size() && offsets[h] < (int64_t)c1; h++) {
+					const int s = hits[h].sound;
+					if (s < 0 || s >= (int)sounds.size())
+						continue;
+					const AudioClip& clip = sounds[s];
+					const int64_t from = std::max<int64_t>(offsets[h], (int64_t)c0);
+					const int64_t to = std::min<int64_t>(offsets[h] + (int64_t)clip.GetFrameCount(), (int64_t)c1);
+					if (from >= to)
+						continue;
+					const float* src = clip.samples.data() + (from - offsets[h]) * channels;
+					float* dst = mix.data() + (from - (int64_t)c0) * channels;
+					const size_t m = (size_t)(to - from) * channels;
+					for (size_t i = 0; i < m; i++)
+						dst[i] += src[i];
+				}
+
+				int16_t* out = pcm.data() + (c0 - begin) * channels;
+				for (size_t i = 0; i < n * channels; i++)
+					out[i] = (int16_t)(std::max(-1.0f, std::min(mix[i], 1.0f)) * 32767.0f);
+			}
+		};
+
+		threads = std::max(1, threads);
+		std::vector<std::thread> pool;
+		for (int i = 1; i < threads; i++)
+			pool.emplace_back(worker);
+		worker();
+		for (auto& t : pool)
+			t.join();
+
+		WavWriter writer;
+		if (!writer.Open(path, rate, channels))
+			return false;
+		writer.Write(pcm.data(), total - begin);
+		writer.Close();
+
+		if (stats) {
+			stats->audioSeconds = (double)(total - begin) / rate;
+			stats->wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			stats->threads = threads;
+			stats->hits = hits.size();
+		}
+		return true;
+	}
+
+}
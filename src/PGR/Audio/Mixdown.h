@@ -0,0 +1,41 @@
+#pragma once
+#include "PGR/Audio/Wav.h"
+
+#include <string>
+#include <vector>
+
+namespace PGR {
+
+	struct MixdownHit {
+		double time;
+		int sound;
+	};
+
+	struct MixdownStats {
+		double audioSeconds = 0.0;
+		double wallSeconds = 0.0;
+		int threads = 0;
+		size_t hits = 0;
+	};
+
+	// Renders `song` plus every hit at its sample-accurate offset into a 16-bit
+	// WAV. `hits` must be sorted by time and index into `sounds`; all clips must
+	// share the song's layout. The output is split into fixed chunks that are
+	// mixed in parallel and written in order.
+	//
+	// [begin, end) selects a range of song frames, padded with silence past
+	// the end; the default is everything up to the last sound. Every sample
+	// only depends on its own position, so adjacent ranges join into exactly
+	// the full mixdown.
+	bool MixdownToWav(
+		const std::string& path,
+		const AudioClip& song,
+		const std::vector<AudioClip>& sounds,
+		const std::vector<MixdownHit>& hits,
+		int threads,
+		MixdownStats* stats = nullptr,
+		size_t begin = 0,
+		size_t end = (size_t)-1
+	);
+
+}
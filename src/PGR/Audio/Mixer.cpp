@@ -0,0 +1,150 @@
+#include "Mixer.h"
+#include "MusicStream.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace PGR {
+
+	Mixer::Mixer() {
+		m_Sounds.reserve(16);
+	}
+
+	int Mixer::LoadSound(const std::string& path) {
+		AudioClip clip;
+		if (!LoadWav(path, clip, SampleRate, Channels))
+			printf("Failed to load sound: %s\n", path.c_str());
+		return AddSound(clip);
+	}
+
+	int Mixer::AddSound(const AudioClip& clip) {
+		m_Sounds.push_back(clip);
+		ConvertClip(m_Sounds.back(), SampleRate, Channels);
+		return (int)m_Sounds.size() - 1;
+	}
+
+	void Mixer::Play(int sound, float gain) {
+		Push({ sound, gain, -1, std::chrono::steady_clock::now() });
+	}
+
+	void Mixer::PlayAt(int sound, double songTime, float gain) {
+		Push({ sound, gain, (int64_t)std::llround(std::max(0.0, songTime) * SampleRate), std::chrono::steady_clock::now() });
+	}
+
+	void Mixer::Push(const Trigger& trigger) {
+		const uint32_t head = m_Head.load(std::memory_order_relaxed);
+		const uint32_t tail = m_Tail.load(std::memory_order_acquire);
+		if (head - tail >= QueueSize) {
+			m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		m_Queue[head % QueueSize] = trigger;
+		m_Head.store(head + 1, std::memory_order_release);
+	}
+
+	void Mixer::StartVoice(const Trigger& trigger) {
+		if (trigger.sound < 0 || trigger.sound >= (int)m_Sounds.size())
+			return;
+		const AudioClip* clip = &m_Sounds[trigger.sound];
+		if (clip->samples.empty())
+			return;
+
+		// Take a free voice, otherwise steal the one that has played longest.
+		Voice* voice = nullptr;
+		for (Voice& v : m_Voices) {
+			if (!v.clip) {
+				voice = &v;
+				break;
+			}
+			if (!voice || v.pos > voice->pos)
+				voice = &v;
+		}
+		if (voice->clip)
+			m_Stats.stolen++;
+
+		voice->clip = clip;
+		voice->pos = 0;
+		voice->gain = trigger.gain;
+		voice->start = trigger.frame;
+	}
+
+	void Mixer::Render(float* out, int frames) {
+		const auto start = std::chrono::steady_clock::now();
+
+		const uint32_t head = m_Head.load(std::memory_order_acquire);
+		uint32_t tail = m_Tail.load(std::memory_order_relaxed);
+		for (; tail != head; tail++) {
+			const Trigger& trigger = m_Queue[tail % QueueSize];
+			if (trigger.frame < 0) {
+				const double latency = std::chrono::duration<double>(start - trigger.time).count();
+				m_Stats.latencySum += latency;
+				m_Stats.latencyMax = std::max(m_Stats.latencyMax, latency);
+			}
+			else
+				m_Stats.scheduled++;
+			m_Stats.triggers++;
+			StartVoice(trigger);
+		}
+		m_Tail.store(tail, std::memory_order_release);
+
+		memset(out, 0, sizeof(float) * frames * Channels);
+
+		// Song frame at out[0], or -1 while the song is paused or absent.
+		const int64_t songFrame = m_Music ? m_Music->Read(out, frames) : -1;
+
+		for (Voice& voice : m_Voices) {
+			if (!voice.clip)
+				continue;
+
+			size_t offset = 0;
+			if (voice.start >= 0) {
+				if (songFrame < 0)
+					continue;
+				const int64_t at = voice.start - songFrame;
+				if (at >= frames)
+					continue;
+				if (at < 0) {
+					m_Stats.late++;
+					m_Stats.lateFramesMax = std::max(m_Stats.lateFramesMax, (uint64_t)-at);
+				}
+				else
+					offset = (size_t)at;
+				voice.start = -1;
+			}
+
+			const size_t remain = voice.clip->GetFrameCount() - voice.pos;
+			const size_t count = std::min((size_t)frames - offset, remain) * Channels;
+			const float* src = voice.clip->samples.data() + voice.pos * Channels;
+			float* dst = out + offset * Channels;
+			const float gain = voice.gain;
+			for (size_t i = 0; i < count; i++)
+				dst[i] += src[i] * gain;
+
+			voice.pos += count / Channels;
+			if (voice.pos >= voice.clip->GetFrameCount())
+				voice.clip = nullptr;
+		}
+
+		m_Stats.mixedFrames += frames;
+		m_Stats.mixSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		m_Stats.dropped = m_Dropped.load(std::memory_order_relaxed);
+	}
+
+	void Mixer::PrintStats(double outputLatency) const {
+		const double audioSeconds = (double)m_Stats.mixedFrames / SampleRate;
+		printf("Audio: mixed %.1f s in %.2f ms (%.0fx realtime)\n",
+			audioSeconds, m_Stats.mixSeconds * 1000.0,
+			m_Stats.mixSeconds > 0.0 ? audioSeconds / m_Stats.mixSeconds : 0.0);
+		printf("Audio: %llu hits, %llu dropped, %llu stolen voices\n",
+			(unsigned long long)m_Stats.triggers, (unsigned long long)m_Stats.dropped, (unsigned long long)m_Stats.stolen);
+		const uint64_t immediate = m_Stats.triggers - m_Stats.scheduled;
+		printf("Audio: trigger->mix avg %.2f ms, max %.2f ms, + %.1f ms output buffer\n",
+			immediate ? m_Stats.latencySum / immediate * 1000.0 : 0.0,
+			m_Stats.latencyMax * 1000.0, outputLatency * 1000.0);
+		printf("Audio: %llu sample-accurate hits, %llu late (max %.2f ms)\n",
+			(unsigned long long)m_Stats.scheduled, (unsigned long long)m_Stats.late,
+			m_Stats.lateFramesMax * 1000.0 / SampleRate);
+	}
+
+}
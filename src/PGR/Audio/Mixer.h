@@ -0,0 +1,87 @@
+#pragma once
+#include "PGR/Audio/Wav.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	class MusicStream;
+
+	struct MixerStats {
+		uint64_t mixedFrames = 0;
+		double mixSeconds = 0.0;
+		uint64_t triggers = 0;
+		uint64_t dropped = 0;
+		uint64_t stolen = 0;
+		uint64_t scheduled = 0;
+		uint64_t late = 0;
+		uint64_t lateFramesMax = 0;
+		double latencySum = 0.0;
+		double latencyMax = 0.0;
+	};
+
+	// Mixes short one-shot sounds for a single producer thread (the renderer)
+	// and a single consumer thread (the audio output). Play() only pushes into a
+	// lock-free ring; voices are started and mixed inside Render(). PlayAt()
+	// voices wait for the music stream to reach their song frame and start on
+	// that exact sample.
+	class Mixer {
+	public:
+		static constexpr int SampleRate = 44100;
+		static constexpr int Channels = 2;
+		static constexpr int MaxVoices = 32;
+		static constexpr uint32_t QueueSize = 256;
+
+		Mixer();
+
+		// Load time only, before the output is started.
+		int LoadSound(const std::string& path);
+		int AddSound(const AudioClip& clip);
+		const std::vector<AudioClip>& GetSounds() const { return m_Sounds; }
+		// Mixed under the hitsounds; set before the output is started.
+		void SetMusic(MusicStream* music) { m_Music = music; }
+
+		void Play(int sound, float gain = 1.0f);
+		void PlayAt(int sound, double songTime, float gain = 1.0f);
+		void Render(float* out, int frames);
+
+		const MixerStats& GetStats() const { return m_Stats; }
+		void PrintStats(double outputLatency) const;
+
+	private:
+		struct Trigger {
+			int sound;
+			float gain;
+			int64_t frame;
+			std::chrono::steady_clock::time_point time;
+		};
+
+		struct Voice {
+			const AudioClip* clip = nullptr;
+			size_t pos = 0;
+			float gain = 1.0f;
+			// Song frame to start at, -1 once started.
+			int64_t start = -1;
+		};
+
+		void Push(const Trigger& trigger);
+
+		void StartVoice(const Trigger& trigger);
+
+	private:
+		std::vector<AudioClip> m_Sounds;
+		MusicStream* m_Music = nullptr;
+		Voice m_Voices[MaxVoices];
+
+		Trigger m_Queue[QueueSize];
+		std::atomic<uint32_t> m_Head{ 0 };
+		std::atomic<uint32_t> m_Tail{ 0 };
+		std::atomic<uint64_t> m_Dropped{ 0 };
+
+		MixerStats m_Stats;
+	};
+
+}
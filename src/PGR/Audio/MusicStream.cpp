@@ -0,0 +1,348 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "MusicStream.h"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#define STB_VORBIS_HEADER_ONLY
+#include "stb_image/stb_vorbis.c"
+
+namespace PGR {
+
+	class MusicStream::Decoder {
+	public:
+		virtual ~Decoder() = default;
+
+		// Interleaved float frames in the source layout; 0 at the end.
+		virtual size_t Read(float* out, size_t frames) = 0;
+		virtual bool Seek(uint64_t frame) = 0;
+
+		int channels = 0;
+		int sampleRate = 0;
+		uint64_t frames = 0;
+	};
+
+	class WavDecoder : public MusicStream::Decoder {
+	public:
+		~WavDecoder() override {
+			if (m_File)
+				fclose(m_File);
+		}
+
+		bool Open(const std::string& path) {
+			m_File = fopen(path.c_str(), "rb");
+			if (!m_File)
+				return false;
+
+			unsigned char riff[12];
+			if (fread(riff, 1, 12, m_File) != 12 || memcmp(riff, "RIFF", 4) || memcmp(riff + 8, "WAVE", 4))
+				return false;
+
+			auto u16 = [](const unsigned char* p) { return (uint32_t)(p[0] | (p[1] << 8)); };
+			auto u32 = [](const unsigned char* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); };
+
+			unsigned char header[8];
+			while (fread(header, 1, 8, m_File) == 8) {
+				const uint32_t size = u32(header + 4);
+				if (!memcmp(header, "fmt ", 4) && size >= 16) {
+					unsigned char fmt[40] = {};
+					const size_t n = std::min<size_t>(size, sizeof(fmt));
+					if (fread(fmt, 1, n, m_File) != n)
+						return false;
+					m_Format = (int)u16(fmt);
+					channels = (int)u16(fmt + 2);
+					sampleRate = (int)u32(fmt + 4);
+					m_Bits = (int)u16(fmt + 14);
+					if (m_Format == 0xFFFE && size >= 26)
+						m_Format = (int)u16(fmt + 24);
+					fseek(m_File, (long)(size - n + (size & 1)), SEEK_CUR);
+				}
+				else if (!memcmp(header, "data", 4)) {
+					m_DataOffset = ftell(m_File);
+					m_DataSize = size;
+					break;
+				}
+				else
+					fseek(m_File, (long)(size + (size & 1)), SEEK_CUR);
+			}
+
+			if (m_DataOffset < 0 || channels <= 0 || sampleRate <= 0)
+				return false;
+			if (!(m_Format == 1 && (m_Bits == 8 || m_Bits == 16 || m_Bits == 24 || m_Bits == 32)) && !(m_Format == 3 && m_Bits == 32))
+				return false;
+
+			m_FrameBytes = (size_t)(m_Bits / 8) * channels;
+			frames = m_DataSize / m_FrameBytes;
+			return true;
+		}
+
+		size_t Read(float* out, size_t count) override {
+			count = (size_t)std::min<uint64_t>(count, frames - m_Pos);
+			m_Bytes.resize(count * m_FrameBytes);
+			const size_t got = fread(m_Bytes.data(), m_FrameBytes, count, m_File);
+			DecodePcm(m_Bytes.data(), out, got * channels, m_Format, m_Bits);
+			m_Pos += got;
+			return got;
+		}
+
+		bool Seek(uint64_t frame) override {
+			m_Pos = std::min(frame, frames);
+			return !fseek(m_File, (long)(m_DataOffset + m_Pos * m_FrameBytes), SEEK_SET);
+		}
+
+	private:
+		FILE* m_File = nullptr;
+		long m_DataOffset = -1;
+		uint64_t m_DataSize = 0;
+		size_t m_FrameBytes = 0;
+		uint64_t m_Pos = 0;
+		int m_Format = 0;
+		int m_Bits = 0;
+		std::vector<unsigned char> m_Bytes;
+	};
+
+	class OggDecoder : public MusicStream::Decoder {
+	public:
+		~OggDecoder() override {
+			if (m_Vorbis)
+				stb_vorbis_close(m_Vorbis);
+		}
+
+		bool Open(const std::string& path) {
+			int error = 0;
+			m_Vorbis = stb_vorbis_open_filename(path.c_str(), &error, nullptr);
+			if (!m_Vorbis)
+				return false;
+			const stb_vorbis_info info = stb_vorbis_get_info(m_Vorbis);
+			channels = info.channels;
+			sampleRate = (int)info.sample_rate;
+			frames = stb_vorbis_stream_length_in_samples(m_Vorbis);
+			return channels > 0 && sampleRate > 0;
+		}
+
+		size_t Read(float* out, size_t count) override {
+			return (size_t)stb_vorbis_get_samples_float_interleaved(m_Vorbis, channels, out, (int)(count * channels));
+		}
+
+		bool Seek(uint64_t frame) override {
+			return stb_vorbis_seek(m_Vorbis, (unsigned int)frame) != 0;
+		}
+
+	private:
+		stb_vorbis* m_Vorbis = nullptr;
+	};
+
+	MusicStream::MusicStream(int sampleRate, int channels)
+		: m_SampleRate(sampleRate), m_Channels(channels) {
+		m_Ring.resize((size_t)RingFrames * channels);
+	}
+
+	MusicStream::~MusicStream() {
+		Close();
+	}
+
+	bool MusicStream::Open(const std::string& path) {
+		Close();
+
+		std::string ext = path.substr(path.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+		std::unique_ptr<Decoder> decoder;
+		if (ext == "ogg") {
+			auto ogg = std::make_unique<OggDecoder>();
+			if (ogg->Open(path))
+				decoder = std::move(ogg);
+		}
+		else if (ext == "wav") {
+			auto wav = std::make_unique<WavDecoder>();
+			if (wav->Open(path))
+				decoder = std::move(wav);
+		}
+		if (!decoder)
+			return false;
+
+		m_Decoder = std::move(decoder);
+		m_Src.assign((size_t)DecodeFrames * m_Decoder->channels, 0.0f);
+		m_SrcCount = 0;
+		m_Phase = 0.0;
+		m_Step = (double)m_Decoder->sampleRate / m_SampleRate;
+
+		m_Write = 0;
+		m_Read = 0;
+		m_Epoch = 0;
+		m_EpochStart = 0;
+		m_EpochFrame = 0;
+		m_ReadEpoch = 0;
+		m_PlayFrame = 0;
+		m_Underruns = 0;
+		m_Eof = false;
+		m_SeekPending = false;
+		m_SeekRequested = false;
+		m_Quit = false;
+
+		m_Thread = std::thread(&MusicStream::DecodeLoop, this);
+		return true;
+	}
+
+	void MusicStream::Close() {
+		m_Playing = false;
+		if (m_Thread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Quit = true;
+			}
+			m_Cond.notify_one();
+			m_Thread.join();
+		}
+		m_Decoder.reset();
+	}
+
+	void MusicStream::Play() {
+		m_Playing.store(true, std::memory_order_release);
+	}
+
+	void MusicStream::Pause() {
+		m_Playing.store(false, std::memory_order_release);
+	}
+
+	void MusicStream::Seek(double seconds) {
+		if (!m_Decoder)
+			return;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_SeekFrame = (uint64_t)std::max(0.0, seconds * m_SampleRate);
+			m_SeekRequested = true;
+			m_SeekPending.store(true, std::memory_order_release);
+		}
+		m_Cond.notify_one();
+	}
+
+	double MusicStream::GetDuration() const {
+		return m_Decoder ? (double)m_Decoder->frames / m_Decoder->sampleRate : 0.0;
+	}
+
+	size_t MusicStream::Convert(float* dst, size_t frames) {
+		const int srcChannels = m_Decoder->channels;
+		size_t produced = 0;
+		while (produced < frames) {
+			size_t i0 = (size_t)m_Phase;
+			if (i0 + 1 >= m_SrcCount) {
+				// Keep the frame we're interpolating from and refill behind it.
+				const size_t keep = m_SrcCount > i0 ? m_SrcCount - i0 : 0;
+				if (keep)
+					memmove(m_Src.data(), m_Src.data() + i0 * srcChannels, sizeof(float) * keep * srcChannels);
+				m_Phase -= (double)(m_SrcCount > i0 ? i0 : m_SrcCount);
+				m_SrcCount = keep;
+				const size_t got = m_Decoder->Read(m_Src.data() + keep * srcChannels, DecodeFrames - keep);
+				if (!got)
+					break;
+				m_SrcCount += got;
+				continue;
+			}
+
+			const float f = (float)(m_Phase - i0);
+			const float* a = m_Src.data() + i0 * srcChannels;
+			const float* b = a + srcChannels;
+			for (int c = 0; c < m_Channels; c++) {
+				const int sc = std::min(c, srcChannels - 1);
+				dst[produced * m_Channels + c] = a[sc] + (b[sc] - a[sc]) * f;
+			}
+			m_Phase += m_Step;
+			produced++;
+		}
+		return produced;
+	}
+
+	void MusicStream::DecodeLoop() {
+		std::vector<float> block((size_t)DecodeFrames * m_Channels);
+		// Set between a seek and the first block decoded after it.
+		bool settling = false;
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (!m_Quit) {
+			if (m_SeekRequested) {
+				const uint64_t target = m_SeekFrame;
+				m_SeekRequested = false;
+				lock.unlock();
+
+				m_Decoder->Seek((uint64_t)((double)target * m_Decoder->sampleRate / m_SampleRate));
+				m_SrcCount = 0;
+				m_Phase = 0.0;
+				m_Eof.store(false, std::memory_order_relaxed);
+
+				m_EpochStart.store(m_Write.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				m_EpochFrame.store(target, std::memory_order_relaxed);
+				m_Epoch.fetch_add(1, std::memory_order_release);
+
+				lock.lock();
+				settling = true;
+				continue;
+			}
+
+			const uint64_t write = m_Write.load(std::memory_order_relaxed);
+			const uint64_t used = write - m_Read.load(std::memory_order_acquire);
+			if (m_Eof.load(std::memory_order_relaxed) || RingFrames - used < (uint64_t)DecodeFrames) {
+				// The audio thread never blocks on us, so poll well inside the ring's length.
+				m_Cond.wait_for(lock, std::chrono::milliseconds(5));
+				continue;
+			}
+
+			lock.unlock();
+			const size_t n = Convert(block.data(), DecodeFrames);
+			const size_t at = (size_t)(write % RingFrames);
+			const size_t first = std::min(n, (size_t)RingFrames - at);
+			memcpy(m_Ring.data() + at * m_Channels, block.data(), sizeof(float) * first * m_Channels);
+			memcpy(m_Ring.data(), block.data() + first * m_Channels, sizeof(float) * (n - first) * m_Channels);
+			m_Write.store(write + n, std::memory_order_release);
+			if (n < (size_t)DecodeFrames)
+				m_Eof.store(true, std::memory_order_release);
+			lock.lock();
+
+			// Unless a newer Seek() landed meanwhile, the reader may start again.
+			if (settling && !m_SeekRequested)
+				m_SeekPending.store(false, std::memory_order_release);
+			settling = false;
+		}
+	}
+
+	int64_t MusicStream::Read(float* out, int frames) {
+		const double now = m_Clock ? PlaybackClock::Now() : 0.0;
+
+		// Always follow a seek, even while paused, so the decoder gets its ring back.
+		const uint32_t epoch = m_Epoch.load(std::memory_order_acquire);
+		if (epoch != m_ReadEpoch) {
+			m_ReadEpoch = epoch;
+			m_Read.store(m_EpochStart.load(std::memory_order_relaxed), std::memory_order_release);
+			m_PlayFrame.store(m_EpochFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+
+		if (!m_Playing.load(std::memory_order_acquire) || m_SeekPending.load(std::memory_order_acquire))
+			return -1;
+
+		// Once the end is flagged, the write position loaded after it is final.
+		const bool eof = m_Eof.load(std::memory_order_acquire);
+		const uint64_t read = m_Read.load(std::memory_order_relaxed);
+		const uint64_t avail = m_Write.load(std::memory_order_acquire) - read;
+		const size_t n = (size_t)std::min<uint64_t>((uint64_t)frames, avail);
+		if (n < (size_t)frames && !eof)
+			m_Underruns.fetch_add(1, std::memory_order_relaxed);
+
+		const size_t at = (size_t)(read % RingFrames);
+		const size_t first = std::min(n, (size_t)RingFrames - at);
+		const float* a = m_Ring.data() + at * m_Channels;
+		for (size_t i = 0; i < first * m_Channels; i++)
+			out[i] += a[i];
+		const float* b = m_Ring.data();
+		float* rest = out + first * m_Channels;
+		for (size_t i = 0; i < (n - first) * m_Channels; i++)
+			rest[i] += b[i];
+
+		m_Read.store(read + n, std::memory_order_release);
+		const uint64_t advance = eof ? (uint64_t)frames : n;
+		const uint64_t frame = m_PlayFrame.fetch_add(advance, std::memory_order_relaxed);
+		if (m_Clock && advance)
+			m_Clock->Publish((double)frame / m_SampleRate, now);
+		return (int64_t)frame;
+	}
+
+}
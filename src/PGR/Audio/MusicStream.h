@@ -0,0 +1,93 @@
+#pragma once
+#include "PGR/Audio/Wav.h"
+#include "PGR/Audio/PlaybackClock.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <condition_variable>
+
+namespace PGR {
+
+	// Decodes a song (WAV or Ogg Vorbis) on a background thread into a fixed-size
+	// ring, already converted to the mixer layout, so memory per song does not
+	// depend on its length. Read() belongs to the audio thread; everything else
+	// to the main thread.
+	class MusicStream {
+	public:
+		static constexpr int RingFrames = 1 << 15;
+		static constexpr int DecodeFrames = 2048;
+
+		MusicStream(int sampleRate = 44100, int channels = 2);
+		~MusicStream();
+
+		bool Open(const std::string& path);
+		void Close();
+
+		void Play();
+		void Pause();
+		// Drops everything buffered and restarts decoding at `seconds`. Read()
+		// outputs silence until the first new block is in the ring.
+		void Seek(double seconds);
+		// Receives the song position of every block Read() hands out.
+		void SetClock(PlaybackClock* clock) { m_Clock = clock; }
+
+		// Adds up to `frames` frames of music to `out` and returns the song frame
+		// at out[0], or -1 while paused or seeking. Past the end of the song the
+		// position keeps advancing over silence.
+		int64_t Read(float* out, int frames);
+
+		bool IsOpen() const { return m_Decoder != nullptr; }
+		bool IsPlaying() const { return m_Playing.load(std::memory_order_relaxed); }
+		// Song position of the next frame Read() will hand out.
+		double GetTime() const { return (double)m_PlayFrame.load(std::memory_order_relaxed) / m_SampleRate; }
+		double GetDuration() const;
+		uint64_t GetUnderruns() const { return m_Underruns.load(std::memory_order_relaxed); }
+
+		class Decoder;
+
+	private:
+		void DecodeLoop();
+		size_t Convert(float* dst, size_t frames);
+
+	private:
+		const int m_SampleRate;
+		const int m_Channels;
+
+		std::unique_ptr<Decoder> m_Decoder;
+		PlaybackClock* m_Clock = nullptr;
+
+		// Resampler state, decode thread only.
+		std::vector<float> m_Src;
+		size_t m_SrcCount = 0;
+		double m_Phase = 0.0;
+		double m_Step = 1.0;
+
+		// Frame counters into the ring; the decoder owns m_Write, the reader m_Read.
+		std::vector<float> m_Ring;
+		std::atomic<uint64_t> m_Write{ 0 };
+		std::atomic<uint64_t> m_Read{ 0 };
+
+		// Each seek starts a new epoch at ring position m_EpochStart, which holds
+		// song frame m_EpochFrame. The reader skips to it when it sees the change.
+		std::atomic<uint32_t> m_Epoch{ 0 };
+		std::atomic<uint64_t> m_EpochStart{ 0 };
+		std::atomic<uint64_t> m_EpochFrame{ 0 };
+		uint32_t m_ReadEpoch = 0;
+
+		std::atomic<uint64_t> m_PlayFrame{ 0 };
+		std::atomic<uint64_t> m_Underruns{ 0 };
+		std::atomic<bool> m_Playing{ false };
+		std::atomic<bool> m_SeekPending{ false };
+		std::atomic<bool> m_Eof{ false };
+
+		std::thread m_Thread;
+		std::mutex m_Mutex;
+		std::condition_variable m_Cond;
+		uint64_t m_SeekFrame = 0;
+		bool m_SeekRequested = false;
+		bool m_Quit = false;
+	};
+
+}
@@ -0,0 +1,210 @@
+#include "PlaybackClock.h"
+#include "AudioOutput.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <algorithm>
+
+namespace PGR {
+
+	double PlaybackClock::Now() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void PlaybackClock::Publish(double position, double time) {
+		const uint32_t seq = m_Seq.load(std::memory_order_relaxed);
+		m_Seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_SamplePosition.store(position, std::memory_order_relaxed);
+		m_SampleTime.store(time, std::memory_order_relaxed);
+		m_Seq.store(seq + 2, std::memory_order_release);
+	}
+
+	bool PlaybackClock::ReadSample(double& position, double& time) const {
+		for (int tries = 0; tries < 4; tries++) {
+			const uint32_t seq = m_Seq.load(std::memory_order_acquire);
+			if (seq & 1)
+				continue;
+			position = m_SamplePosition.load(std::memory_order_relaxed);
+			time = m_SampleTime.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (m_Seq.load(std::memory_order_relaxed) == seq)
+				return time >= 0.0;
+		}
+		return false;
+	}
+
+	void PlaybackClock::Play(double now) {
+		m_Playing = true;
+		m_LastNow = now;
+	}
+
+	void PlaybackClock::Pause() {
+		m_Playing = false;
+	}
+
+	void PlaybackClock::Seek(double position, double now) {
+		m_Visual = position;
+		m_Rate = 1.0;
+		m_LastNow = now;
+		m_ResetTime = now;
+		// Nothing new is audible until the output queue has drained.
+		m_HoldUntil = now + m_Latency;
+	}
+
+	double PlaybackClock::Update(double now) {
+		if (!m_Playing)
+			return m_Visual;
+
+		const double from = std::max(m_LastNow, m_HoldUntil);
+		if (now > from)
+			m_Visual += (now - from) * m_Rate;
+		m_LastNow = now;
+		m_Stats.updates++;
+
+		double position, time;
+		if (!ReadSample(position, time) || time < m_ResetTime || now - time > StaleAfter) {
+			m_Rate = 1.0;
+			return m_Visual;
+		}
+
+		// The published block reaches the speaker m_Latency after it was rendered.
+		const double audible = position - m_Latency + (now - time);
+		const double error = audible - m_Visual;
+
+		m_Stats.samples++;
+		m_Stats.offsetSum += error;
+		m_Stats.offsetSqSum += error * error;
+		m_Stats.offsetMax = std::max(m_Stats.offsetMax, std::abs(error));
+
+		if (std::abs(error) > SnapThreshold) {
+			m_Visual = audible;
+			m_Rate = 1.0;
+			m_Stats.snaps++;
+		}
+		else
+			m_Rate = 1.0 + std::clamp(error * SlewGain, -MaxSlew, MaxSlew);
+
+		return m_Visual;
+	}
+
+	void PlaybackClock::PrintStats() const {
+		const double n = (double)std::max<uint64_t>(m_Stats.samples, 1);
+		printf("Clock: %llu frames, %llu audio-locked, %llu snaps\n",
+			(unsigned long long)m_Stats.updates, (unsigned long long)m_Stats.samples, (unsigned long long)m_Stats.snaps);
+		printf("Clock: audio - visual mean %+.2f ms, rms %.2f ms, max %.2f ms\n",
+			m_Stats.offsetSum / n * 1000.0, std::sqrt(m_Stats.offsetSqSum / n) * 1000.0, m_Stats.offsetMax * 1000.0);
+	}
+
+	struct OffsetStats {
+		uint64_t count = 0;
+		double sum = 0.0;
+		double sqSum = 0.0;
+		double max = 0.0;
+
+		void Add(double v) {
+			count++;
+			sum += v;
+			sqSum += v * v;
+			max = std::max(max, std::abs(v));
+		}
+
+		void Print(const char* name) const {
+			const double n = (double)std::max<uint64_t>(count, 1);
+			printf("  %-12s visual - audible mean %+7.2f ms, rms %6.2f ms, max %6.2f ms\n",
+				name, sum / n * 1000.0, std::sqrt(sqSum / n) * 1000.0, max * 1000.0);
+		}
+	};
+
+	void RunClockSimulation(const ClockSimConfig& config) {
+		const double rate = Mixer::SampleRate;
+		const double block = AudioOutput::BlockFrames;
+		const double latency = block * AudioOutput::BlockCount / rate;
+		// The device consumes frames at its own rate, measured on the host timer.
+		const double deviceRate = rate * (1.0 + config.drift);
+		const double deviceLatency = block * AudioOutput::BlockCount / deviceRate;
+
+		std::mt19937 rng(config.seed);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+		PlaybackClock clock;
+		clock.SetOutputLatency(latency);
+		clock.Seek(0.0, 0.0);
+		clock.Play(0.0);
+
+		// Current play segment: song time `songOrigin` started rendering at `hostOrigin`.
+		double hostOrigin = 0.0, songOrigin = 0.0;
+		uint64_t blockIndex = 0;
+		bool playing = true;
+		bool paused = false;
+
+		// The old loop: host timer since the last resume, no audio feedback.
+		double hostStart = 0.0, hostPaused = 0.0;
+
+		auto callbackTime = [&](uint64_t k) {
+			return hostOrigin + k * block / deviceRate + unit(rng) * config.callbackJitter;
+		};
+
+		double nextCallback = callbackTime(0);
+		double nextFrame = 1.0 / config.fps;
+		double nextHitch = config.hitchEvery;
+
+		OffsetStats audioStats, hostStats;
+
+		while (nextFrame < config.duration) {
+			if (playing && nextCallback <= nextFrame) {
+				clock.Publish(songOrigin + blockIndex * block / rate, nextCallback);
+				nextCallback = callbackTime(++blockIndex);
+				continue;
+			}
+
+			const double now = nextFrame;
+			nextFrame += 1.0 / config.fps + (unit(rng) * 2.0 - 1.0) * config.frameJitter;
+			if (nextFrame >= nextHitch) {
+				nextFrame += config.hitchLength;
+				nextHitch += config.hitchEvery;
+			}
+
+			if (!paused && now >= config.pauseAt && now < config.pauseAt + config.pauseLength) {
+				paused = true;
+				playing = false;
+				clock.Update(now);
+				clock.Pause();
+				hostPaused = now - hostStart;
+				continue;
+			}
+			if (paused && now >= config.pauseAt + config.pauseLength) {
+				paused = false;
+				playing = true;
+				songOrigin = clock.GetTime();
+				hostOrigin = now;
+				hostStart = now - hostPaused;
+				clock.Seek(songOrigin, now);
+				clock.Play(now);
+				blockIndex = 0;
+				nextCallback = callbackTime(0);
+				continue;
+			}
+			if (!playing)
+				continue;
+
+			const double visual = clock.Update(now);
+			const double heard = now - hostOrigin - deviceLatency;
+			if (heard < 0.0)
+				continue;
+			const double audible = songOrigin + heard * deviceRate / rate;
+			audioStats.Add(visual - audible);
+			hostStats.Add((now - hostStart) - audible);
+		}
+
+		printf("Clock sim: %.0f s at %.0f fps, drift %.0f ppm, callback jitter %.1f ms, frame jitter %.1f ms, %.0f ms hitch every %.0f s\n",
+			config.duration, config.fps, config.drift * 1e6, config.callbackJitter * 1000.0,
+			config.frameJitter * 1000.0, config.hitchLength * 1000.0, config.hitchEvery);
+		audioStats.Print("audio clock");
+		hostStats.Print("host timer");
+		clock.PrintStats();
+	}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace PGR {
+
+	struct ClockStats {
+		uint64_t updates = 0;
+		uint64_t samples = 0;
+		uint64_t snaps = 0;
+		double offsetSum = 0.0;
+		double offsetSqSum = 0.0;
+		double offsetMax = 0.0;
+	};
+
+	// Chart time with the audio output as master. The audio thread publishes
+	// which song position it is rendering and when; the main thread advances a
+	// visual clock from the host timer between those callbacks and slews its
+	// rate toward the audible position, snapping only on large jumps. With no
+	// recent audio it free-runs on the host timer. All times are passed in,
+	// so the clock runs the same against a mock timeline.
+	class PlaybackClock {
+	public:
+		// Corrections up to this are slewed, larger ones snap.
+		static constexpr double SnapThreshold = 0.1;
+		// Rate change per second of error, and its bound.
+		static constexpr double SlewGain = 2.0;
+		static constexpr double MaxSlew = 0.05;
+		// Audio older than this is ignored (song ended, device stalled, MCI).
+		static constexpr double StaleAfter = 0.25;
+
+		static double Now();
+
+		// Audio queued between Publish() and the speaker.
+		void SetOutputLatency(double seconds) { m_Latency = seconds; }
+
+		// Audio thread: the block starting at song `position` was rendered at host `time`.
+		void Publish(double position, double time);
+
+		void Play(double now);
+		void Pause();
+		// Jumps to `position` and drops audio published before `now`.
+		void Seek(double position, double now);
+
+		// Main thread, once per frame: returns the visual chart time.
+		double Update(double now);
+
+		double GetTime() const { return m_Visual; }
+		bool IsPlaying() const { return m_Playing; }
+
+		const ClockStats& GetStats() const { return m_Stats; }
+		void PrintStats() const;
+
+	private:
+		bool ReadSample(double& position, double& time) const;
+
+	private:
+		double m_Latency = 0.0;
+
+		// Seqlock: odd while the audio thread is writing.
+		std::atomic<uint32_t> m_Seq{ 0 };
+		std::atomic<double> m_SamplePosition{ 0.0 };
+		std::atomic<double> m_SampleTime{ -1.0 };
+
+		bool m_Playing = false;
+		double m_Visual = 0.0;
+		double m_Rate = 1.0;
+		double m_LastNow = 0.0;
+		double m_ResetTime = 0.0;
+		double m_HoldUntil = 0.0;
+
+		ClockStats m_Stats;
+	};
+
+	struct ClockSimConfig {
+		double duration = 120.0;
+		double fps = 60.0;
+		// Render-frame jitter (uniform +-), and a hitch every `hitchEvery` seconds.
+		double frameJitter = 0.002;
+		double hitchEvery = 5.0;
+		double hitchLength = 0.05;
+		// Device clock error against the host timer, and callback jitter.
+		double drift = 200e-6;
+		double callbackJitter = 0.004;
+		// A pause of `pauseLength` at `pauseAt`, resumed by seeking the song.
+		double pauseAt = 40.0;
+		double pauseLength = 1.5;
+		uint32_t seed = 1;
+	};
+
+	// Replays a mock audio device and render loop against PlaybackClock and
+	// prints the audible-vs-visual offset, next to the old host-timer clock.
+	void RunClockSimulation(const ClockSimConfig& config = ClockSimConfig());
+
+}
@@ -0,0 +1,216 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "Wav.h"
+
+#include <cstring>
+#include <algorithm>
+
+#define STB_VORBIS_HEADER_ONLY
+#include "stb_image/stb_vorbis.c"
+
+namespace PGR {
+
+	static uint32_t ReadU32(const unsigned char* p) {
+		return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	}
+
+	static uint16_t ReadU16(const unsigned char* p) {
+		return (uint16_t)(p[0] | (p[1] << 8));
+	}
+
+	bool LoadWav(const std::string& path, AudioClip& clip, int sampleRate, int channels) {
+		FILE* file = fopen(path.c_str(), "rb");
+		if (!file)
+			return false;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		std::vector<unsigned char> data(size > 0 ? (size_t)size : 0);
+		size_t read = fread(data.data(), 1, data.size(), file);
+		fclose(file);
+
+		if (read < 12 || memcmp(data.data(), "RIFF", 4) || memcmp(data.data() + 8, "WAVE", 4))
+			return false;
+
+		int format = 0, srcChannels = 0, srcRate = 0, bits = 0;
+		const unsigned char* pcm = nullptr;
+		size_t pcmSize = 0;
+
+		size_t pos = 12;
+		while (pos + 8 <= read) {
+			const unsigned char* chunk = data.data() + pos;
+			size_t chunkSize = ReadU32(chunk + 4);
+			size_t body = pos + 8;
+			chunkSize = std::min(chunkSize, read - body);
+
+			if (!memcmp(chunk, "fmt ", 4) && chunkSize >= 16) {
+				format = ReadU16(chunk + 8);
+				srcChannels = ReadU16(chunk + 10);
+				srcRate = (int)ReadU32(chunk + 12);
+				bits = ReadU16(chunk + 22);
+				// WAVE_FORMAT_EXTENSIBLE: the real format tag is the GUID's first word.
+				if (format == 0xFFFE && chunkSize >= 26)
+					format = ReadU16(chunk + 32);
+			}
+			else if (!memcmp(chunk, "data", 4)) {
+				pcm = data.data() + body;
+				pcmSize = chunkSize;
+			}
+
+			pos = body + chunkSize + (chunkSize & 1);
+		}
+
+		if (!pcm || srcChannels <= 0 || srcRate <= 0)
+			return false;
+		if (!(format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) && !(format == 3 && bits == 32))
+			return false;
+
+		const int bytes = bits / 8;
+		const size_t frames = pcmSize / ((size_t)bytes * srcChannels);
+
+		clip.channels = srcChannels;
+		clip.sampleRate = srcRate;
+		clip.samples.resize(frames * srcChannels);
+
+		DecodePcm(pcm, clip.samples.data(), frames * srcChannels, format, bits);
+
+		ConvertClip(clip, sampleRate, channels);
+		return true;
+	}
+
+	bool LoadOgg(const std::string& path, AudioClip& clip, int sampleRate, int channels) {
+		int srcChannels = 0, srcRate = 0;
+		short* output = nullptr;
+		const int frames = stb_vorbis_decode_filename(path.c_str(), &srcChannels, &srcRate, &output);
+		if (frames <= 0 || !output)
+			return false;
+
+		clip.channels = srcChannels;
+		clip.sampleRate = srcRate;
+		clip.samples.resize((size_t)frames * srcChannels);
+		for (size_t i = 0; i < clip.samples.size(); i++)
+			clip.samples[i] = output[i] / 32768.0f;
+		free(output);
+
+		ConvertClip(clip, sampleRate, channels);
+		return true;
+	}
+
+	bool LoadAudioFile(const std::string& path, AudioClip& clip, int sampleRate, int channels) {
+		std::string ext = path.substr(path.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+		if (ext == "ogg")
+			return LoadOgg(path, clip, sampleRate, channels);
+		return LoadWav(path, clip, sampleRate, channels);
+	}
+
+	void DecodePcm(const unsigned char* src, float* dst, size_t count, int format, int bits) {
+		const int bytes = bits / 8;
+		for (size_t i = 0; i < count; i++) {
+			const unsigned char* s = src + i * bytes;
+			float v = 0.0f;
+			if (format == 3) {
+				memcpy(&v, s, 4);
+			}
+			else switch (bits) {
+			case 8:  v = (s[0] - 128) / 128.0f; break;
+			case 16: v = (int16_t)ReadU16(s) / 32768.0f; break;
+			case 24: v = (int32_t)(((uint32_t)s[0] << 8) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 24)) / 2147483648.0f; break;
+			case 32: v = (int32_t)ReadU32(s) / 2147483648.0f; break;
+			}
+			dst[i] = v;
+		}
+	}
+
+	void ConvertClip(AudioClip& clip, int sampleRate, int channels) {
+		if (clip.sampleRate == sampleRate && clip.channels == channels)
+			return;
+
+		const size_t srcFrames = clip.GetFrameCount();
+		const double step = (double)clip.sampleRate / sampleRate;
+		const size_t dstFrames = srcFrames ? (size_t)((srcFrames - 1) / step) + 1 : 0;
+
+		std::vector<float> out(dstFrames * channels);
+		for (size_t i = 0; i < dstFrames; i++) {
+			const double src = i * step;
+			const size_t i0 = (size_t)src;
+			const size_t i1 = std::min(i0 + 1, srcFrames - 1);
+			const float f = (float)(src - i0);
+			for (int c = 0; c < channels; c++) {
+				const int sc = std::min(c, clip.channels - 1);
+				const float a = clip.samples[i0 * clip.channels + sc];
+				const float b = clip.samples[i1 * clip.channels + sc];
+				out[i * channels + c] = a + (b - a) * f;
+			}
+		}
+
+		clip.samples.swap(out);
+		clip.sampleRate = sampleRate;
+		clip.channels = channels;
+	}
+
+	WavWriter::~WavWriter() {
+		Close();
+	}
+
+	bool WavWriter::Open(const std::string& path, int sampleRate, int channels) {
+		Close();
+		m_File = fopen(path.c_str(), "wb");
+		m_SampleRate = sampleRate;
+		m_Channels = channels;
+		m_Frames = 0;
+		if (m_File)
+			WriteHeader();
+		return m_File != nullptr;
+	}
+
+	void WavWriter::Write(const float* samples, size_t frames) {
+		if (!m_File)
+			return;
+		const size_t count = frames * m_Channels;
+		m_Buffer.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			float v = std::max(-1.0f, std::min(samples[i], 1.0f));
+			m_Buffer[i] = (int16_t)(v * 32767.0f);
+		}
+		fwrite(m_Buffer.data(), sizeof(int16_t), count, m_File);
+		m_Frames += frames;
+	}
+
+	void WavWriter::Write(const int16_t* samples, size_t frames) {
+		if (!m_File)
+			return;
+		fwrite(samples, sizeof(int16_t), frames * m_Channels, m_File);
+		m_Frames += frames;
+	}
+
+	void WavWriter::Close() {
+		if (!m_File)
+			return;
+		fseek(m_File, 0, SEEK_SET);
+		WriteHeader();
+		fclose(m_File);
+		m_File = nullptr;
+	}
+
+	void WavWriter::WriteHeader() {
+		const uint32_t dataSize = (uint32_t)(m_Frames * m_Channels * sizeof(int16_t));
+		unsigned char h[44] = {};
+		auto put32 = [&](int at, uint32_t v) { for (int i = 0; i < 4; i++) h[at + i] = (unsigned char)(v >> (i * 8)); };
+		auto put16 = [&](int at, uint16_t v) { h[at] = (unsigned char)v; h[at + 1] = (unsigned char)(v >> 8); };
+		memcpy(h, "RIFF", 4);
+		put32(4, 36 + dataSize);
+		memcpy(h + 8, "WAVEfmt ", 8);
+		put32(16, 16);
+		put16(20, 1);
+		put16(22, (uint16_t)m_Channels);
+		put32(24, (uint32_t)m_SampleRate);
+		put32(28, (uint32_t)(m_SampleRate * m_Channels * sizeof(int16_t)));
+		put16(32, (uint16_t)(m_Channels * sizeof(int16_t)));
+		put16(34, 16);
+		memcpy(h + 36, "data", 4);
+		put32(40, dataSize);
+		fwrite(h, 1, sizeof(h), m_File);
+	}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+namespace PGR {
+
+	// Interleaved float PCM in [-1, 1].
+	struct AudioClip {
+		AudioClip() = default;
+		std::vector<float> samples;
+		int channels = 2;
+		int sampleRate = 44100;
+
+		size_t GetFrameCount() const { return channels ? samples.size() / channels : 0; }
+		float GetDuration() const { return sampleRate ? (float)GetFrameCount() / sampleRate : 0.0f; }
+	};
+
+	// Decodes a RIFF/WAVE file (PCM 8/16/24/32 bit or float32) and converts it
+	// to `channels` channels at `sampleRate`. Returns false if the file can't be
+	// read or uses an unsupported encoding.
+	bool LoadWav(const std::string& path, AudioClip& clip, int sampleRate = 44100, int channels = 2);
+
+	// Decodes an Ogg Vorbis file through stb_vorbis, same contract as LoadWav.
+	bool LoadOgg(const std::string& path, AudioClip& clip, int sampleRate = 44100, int channels = 2);
+
+	// Picks the decoder from the file extension.
+	bool LoadAudioFile(const std::string& path, AudioClip& clip, int sampleRate = 44100, int channels = 2);
+
+	// Converts `count` little-endian WAV samples (format 1 = PCM, 3 = float) to float.
+	void DecodePcm(const unsigned char* src, float* dst, size_t count, int format, int bits);
+
+	// Converts a clip in place to the given layout (linear resampling).
+	void ConvertClip(AudioClip& clip, int sampleRate, int channels);
+
+	// Streams interleaved float frames into a 16-bit PCM WAV file.
+	class WavWriter {
+	public:
+		WavWriter() = default;
+		~WavWriter();
+
+		bool Open(const std::string& path, int sampleRate, int channels);
+		void Write(const float* samples, size_t frames);
+		void Write(const int16_t* samples, size_t frames);
+		void Close();
+
+		bool IsOpen() const { return m_File != nullptr; }
+		size_t GetFrameCount() const { return m_Frames; }
+
+	private:
+		void WriteHeader();
+
+	private:
+		FILE* m_File = nullptr;
+		int m_SampleRate = 44100;
+		int m_Channels = 2;
+		size_t m_Frames = 0;
+		std::vector<int16_t> m_Buffer;
+	};
+
+}
@@ -0,0 +1,178 @@
+#include "FrameScheduler.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <algorithm>
+
+namespace PGR {
+
+	// A frame this long is counted as this long, so a stall (debugger, window
+	// drag) doesn't queue up a burst of ticks.
+	static constexpr double MaxFrameTime = 0.25;
+
+	FrameScheduler::FrameScheduler(double targetFps, double tickRate)
+		: m_Tick(1.0 / tickRate), m_Histogram(HistogramBins + 1, 0) {
+		SetTargetFps(targetFps);
+	}
+
+	void FrameScheduler::SetTargetFps(double fps) {
+		m_TargetFps = std::max(fps, 0.0);
+		m_Period = m_TargetFps > 0.0 ? 1.0 / m_TargetFps : 0.0;
+		m_Fresh = true;
+	}
+
+	int FrameScheduler::BeginFrame(double now) {
+		if (m_Fresh) {
+			// Run one tick, so input that ended an idle wait takes effect at once.
+			m_Fresh = false;
+			m_Deadline = now;
+			m_Accumulator = m_Tick;
+		}
+		else {
+			const double interval = now - m_LastStart;
+			m_Histogram[std::min((int)(interval / HistogramBin), HistogramBins)]++;
+			m_Intervals++;
+			if (m_Period > 0.0) {
+				const double jitter = std::abs(interval - m_Period);
+				m_Stats.jitterSum += jitter;
+				m_Stats.jitterMax = std::max(m_Stats.jitterMax, jitter);
+			}
+			m_Accumulator += std::min(interval, MaxFrameTime);
+		}
+		m_LastStart = now;
+		m_Stats.frames++;
+
+		int ticks = (int)(m_Accumulator / m_Tick);
+		m_Accumulator -= ticks * m_Tick;
+		if (ticks > MaxTicksPerFrame) {
+			m_Stats.droppedTicks += ticks - MaxTicksPerFrame;
+			ticks = MaxTicksPerFrame;
+		}
+		m_Stats.ticks += ticks;
+		return ticks;
+	}
+
+	double FrameScheduler::EndFrame(double now) {
+		if (m_Period <= 0.0)
+			return now;
+		m_Deadline += m_Period;
+		if (now > m_Deadline)
+			m_Stats.lateFrames++;
+		// More than a frame behind: start again from now instead of rushing
+		// out the missed frames back to back.
+		if (now - m_Deadline > m_Period)
+			m_Deadline = now;
+		return m_Deadline;
+	}
+
+	void FrameScheduler::Idle(double from, double to) {
+		m_Stats.idleWaits++;
+		m_Stats.idleSeconds += std::max(to - from, 0.0);
+		m_Fresh = true;
+	}
+
+	double FrameScheduler::GetPercentile(double p) const {
+		if (m_Intervals == 0)
+			return 0.0;
+		const uint64_t rank = (uint64_t)std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * m_Intervals);
+		uint64_t seen = 0;
+		for (int i = 0; i <= HistogramBins; i++) {
+			seen += m_Histogram[i];
+			if (seen >= std::max<uint64_t>(rank, 1))
+				return (i + 0.5) * HistogramBin;
+		}
+		return HistogramBins * HistogramBin;
+	}
+
+	void FrameScheduler::PrintStats() const {
+		const double n = (double)std::max<uint64_t>(m_Intervals, 1);
+		printf("Frames: %llu at %.0f fps (0: unpaced), %llu ticks (%llu dropped), %llu late, %llu idle waits (%.1f s)\n",
+			(unsigned long long)m_Stats.frames, m_TargetFps,
+			(unsigned long long)m_Stats.ticks, (unsigned long long)m_Stats.droppedTicks, (unsigned long long)m_Stats.lateFrames,
+			(unsigned long long)m_Stats.idleWaits, m_Stats.idleSeconds);
+		printf("Frames: interval p50 %.2f ms, p95 %.2f ms, p99 %.2f ms; jitter mean %.2f ms, max %.2f ms\n",
+			GetPercentile(50.0) * 1000.0, GetPercentile(95.0) * 1000.0, GetPercentile(99.0) * 1000.0,
+			m_Stats.jitterSum / n * 1000.0, m_Stats.jitterMax * 1000.0);
+	}
+
+	void WaitUntil(double until) {
+		using Clock = std::chrono::steady_clock;
+		auto now = []() { return std::chrono::duration<double>(Clock::now().time_since_epoch()).count(); };
+
+		const double sleep = until - FrameScheduler::SpinWindow - now();
+		if (sleep > 0.0)
+			std::this_thread::sleep_for(std::chrono::duration<double>(sleep));
+		while (now() < until)
+			std::this_thread::yield();
+	}
+
+	void RunPacingSimulation(const PacingSimConfig& config) {
+		printf("Pacing sim: %.0f s at %.0f fps, render %.1f +- %.1f ms, %.0f ms hitch every %.0f s, sleep granularity %.1f ms, "
+			"paused %.0f s with input every %.1f s\n",
+			config.duration, config.targetFps, config.renderTime * 1000.0, config.renderJitter * 1000.0,
+			config.hitchLength * 1000.0, config.hitchEvery, config.sleepGranularity * 1000.0, config.pauseLength, config.pauseEventEvery);
+
+		// `spin` as WaitUntil does, or plain sleeps; `idle` waits for input while paused.
+		auto run = [&](const char* name, double fps, bool spin, bool idle) {
+			std::mt19937 rng(config.seed);
+			std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+			FrameScheduler scheduler(fps);
+			double t = 0.0, busy = 0.0;
+			double nextHitch = config.hitchEvery;
+			double nextEvent = config.pauseAt;
+			const double pauseEnd = config.pauseAt + config.pauseLength;
+
+			while (t < config.duration) {
+				const bool paused = t >= config.pauseAt && t < pauseEnd;
+				if (paused && idle) {
+					bool event = false;
+					if (t >= nextEvent) {
+						event = true;
+						nextEvent += config.pauseEventEvery;
+					}
+					if (!event) {
+						// Woken by the next input, the end of the pause, or the heartbeat.
+						const double wake = std::min({ nextEvent, pauseEnd, t + FrameScheduler::IdleTimeout });
+						scheduler.Idle(t, wake);
+						t = wake;
+						continue;
+					}
+				}
+
+				scheduler.BeginFrame(t);
+				double cost = config.renderTime + (unit(rng) * 2.0 - 1.0) * config.renderJitter;
+				if (t + cost >= nextHitch) {
+					cost += config.hitchLength;
+					nextHitch += config.hitchEvery;
+				}
+				t += cost;
+				busy += cost;
+
+				const double next = scheduler.EndFrame(t);
+				const double sleepUntil = spin ? next - FrameScheduler::SpinWindow : next;
+				if (sleepUntil > t)
+					t = sleepUntil + unit(rng) * config.sleepGranularity;
+				if (next > t) {
+					busy += next - t;
+					t = next;
+				}
+			}
+
+			const FrameSchedulerStats& stats = scheduler.GetStats();
+			const double n = (double)std::max<uint64_t>(stats.frames, 1);
+			printf("  %-12s %6llu frames, p50 %6.2f ms, p99 %6.2f ms, max %6.2f ms, jitter %5.2f ms, %4llu late, busy %5.1f%%\n",
+				name, (unsigned long long)stats.frames, scheduler.GetPercentile(50.0) * 1000.0, scheduler.GetPercentile(99.0) * 1000.0,
+				scheduler.GetPercentile(100.0) * 1000.0, stats.jitterSum / n * 1000.0, (unsigned long long)stats.lateFrames,
+				busy / t * 100.0);
+		};
+
+		run("scheduler", config.targetFps, true, true);
+		run("sleep only", config.targetFps, false, true);
+		run("unpaced", 0.0, false, false);
+	}
+
+}
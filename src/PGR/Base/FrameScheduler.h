@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	struct FrameSchedulerStats {
+		uint64_t frames = 0;
+		uint64_t ticks = 0;
+		// Ticks skipped after a frame too long to catch up in MaxTicksPerFrame.
+		uint64_t droppedTicks = 0;
+		// Frames that ended after the next one should have started.
+		uint64_t lateFrames = 0;
+		// |interval - 1/targetFps| over paced frames.
+		double jitterSum = 0.0;
+		double jitterMax = 0.0;
+		uint64_t idleWaits = 0;
+		double idleSeconds = 0.0;
+	};
+
+	// Paces the viewer's main loop. Input and camera movement run in fixed
+	// ticks of 1/tickRate, so they behave the same at any frame rate; each
+	// presented frame then samples chart time once from the PlaybackClock.
+	// Frames start on deadlines 1/targetFps apart that advance by whole
+	// frames, so one slow frame doesn't push back the ones after it. While
+	// nothing changes the loop waits for input instead (Idle()). All times are
+	// passed in, so the scheduler runs the same against a mock clock.
+	class FrameScheduler {
+	public:
+		// More ticks than this in one frame are dropped rather than run.
+		static constexpr int MaxTicksPerFrame = 5;
+		// The end of a wait is spun rather than slept, to hide the OS's sleep granularity.
+		static constexpr double SpinWindow = 0.002;
+		// An idle loop wakes at least this often even without input.
+		static constexpr double IdleTimeout = 0.5;
+		// Frame intervals are binned this finely for the percentiles, up to 250 ms.
+		static constexpr double HistogramBin = 0.0001;
+		static constexpr int HistogramBins = 2500;
+
+		// `targetFps` 0 runs unpaced.
+		FrameScheduler(double targetFps = 60.0, double tickRate = 60.0);
+
+		void SetTargetFps(double fps);
+		double GetTargetFps() const { return m_TargetFps; }
+		double GetTickLength() const { return m_Tick; }
+
+		// Starts a frame at `now`; returns how many fixed ticks to run before drawing it.
+		int BeginFrame(double now);
+		// Ends the frame at `now`; returns when the next one should start.
+		double EndFrame(double now);
+		// The loop waited for input from `from` to `to` instead of drawing. The
+		// next frame starts a fresh interval with a single tick.
+		void Idle(double from, double to);
+
+		// Frame interval (start to start) at percentile `p` in [0, 100].
+		double GetPercentile(double p) const;
+		const FrameSchedulerStats& GetStats() const { return m_Stats; }
+		void PrintStats() const;
+
+	private:
+		double m_TargetFps;
+		double m_Period;
+		double m_Tick;
+
+		bool m_Fresh = true;
+		double m_LastStart = 0.0;
+		double m_Deadline = 0.0;
+		double m_Accumulator = 0.0;
+
+		FrameSchedulerStats m_Stats;
+		std::vector<uint32_t> m_Histogram;
+		uint64_t m_Intervals = 0;
+	};
+
+	// Blocks until `until` on the PlaybackClock::Now() timeline: sleeps for
+	// all but the last SpinWindow, then spins.
+	void WaitUntil(double until);
+
+	struct PacingSimConfig {
+		double duration = 60.0;
+		double targetFps = 60.0;
+		// Render cost: a base plus uniform jitter, and a hitch every `hitchEvery` seconds.
+		double renderTime = 0.006;
+		double renderJitter = 0.003;
+		double hitchEvery = 5.0;
+		double hitchLength = 0.05;
+		// An OS sleep wakes up to this late.
+		double sleepGranularity = 0.0016;
+		// Paused with nothing changing from `pauseAt` for `pauseLength`, with
+		// one input event every `pauseEventEvery` seconds.
+		double pauseAt = 20.0;
+		double pauseLength = 20.0;
+		double pauseEventEvery = 2.0;
+		uint32_t seed = 1;
+	};
+
+	// Replays a mock render loop against FrameScheduler and prints its frame
+	// pacing and busy time, next to an unpaced loop and a sleep-only wait.
+	void RunPacingSimulation(const PacingSimConfig& config = PacingSimConfig());
+
+}
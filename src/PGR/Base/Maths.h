@@ -100,6 +100,13 @@ namespace PGR {
     unsigned char Float2UChar(const float f);
     float UChar2Float(const unsigned char c);
 
+    // Float2UChar clamped to [0, 1] first, for colours headed to an output.
+    inline unsigned char ColorToByte(const float f) {
+        if (f <= 0.0f) return 0;
+        if (f >= 1.0f) return 255;
+        return (unsigned char)(f * 255.0f + 0.5f);
+    }
+
     float Max(const float right, const float left);
     float Min(const float right, const float left);
 }
\ No newline at end of file
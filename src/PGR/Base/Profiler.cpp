@@ -0,0 +1,133 @@
+#include "Profiler.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace PGR {
+
+	static thread_local FrameTimings* s_Target = nullptr;
+	// The innermost open scope, which a nested one hands its time to.
+	static thread_local ProfileScope* s_Current = nullptr;
+
+	const char* GetProfilePhaseName(ProfilePhase phase) {
+		switch (phase) {
+		case ProfilePhase::Background: return "background";
+		case ProfilePhase::JudgeLines: return "judge_lines";
+		case ProfilePhase::Notes:      return "notes";
+		case ProfilePhase::HoldBodies: return "hold_bodies";
+		case ProfilePhase::HitEffects: return "hit_effects";
+		case ProfilePhase::Particles:  return "particles";
+		case ProfilePhase::Hud:        return "hud";
+		case ProfilePhase::Present:    return "present";
+		default:                       return "unknown";
+		}
+	}
+
+	double FrameTimings::GetTotal() const {
+		double total = 0.0;
+		for (double s : seconds)
+			total += s;
+		return total;
+	}
+
+	void SetProfileTarget(FrameTimings* timings) {
+		s_Target = timings;
+		s_Current = nullptr;
+	}
+
+	ProfileScope::ProfileScope(ProfilePhase phase)
+		: m_Target(s_Target), m_Phase(phase), m_Traced(Trace::IsEnabled()) {
+		if (!m_Target && !m_Traced)
+			return;
+		m_Parent = s_Current;
+		s_Current = this;
+		m_Start = std::chrono::steady_clock::now();
+	}
+
+	ProfileScope::~ProfileScope() {
+		if (!m_Target && !m_Traced)
+			return;
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		const double elapsed = std::chrono::duration<double>(end - m_Start).count();
+		if (m_Target) {
+			// Exclusive time: what nested scopes took is theirs.
+			(*m_Target)[m_Phase] += elapsed - m_Children;
+		}
+		if (m_Parent)
+			m_Parent->m_Children += elapsed;
+		s_Current = m_Parent;
+
+		if (m_Traced)
+			Trace::Complete(GetProfilePhaseName(m_Phase), "frame", Trace::ToTime(m_Start), Trace::ToTime(end));
+	}
+
+	FrameProfiler::FrameProfiler()
+		: m_Ring(Capacity) {
+	}
+
+	FrameProfiler::~FrameProfiler() {
+		if (m_Csv)
+			fclose(m_Csv);
+	}
+
+	bool FrameProfiler::OpenCsv(const std::string& path) {
+		if (m_Csv)
+			fclose(m_Csv);
+		m_Csv = fopen(path.c_str(), "w");
+		if (!m_Csv)
+			return false;
+		fputs("frame", m_Csv);
+		for (int i = 0; i < ProfilePhaseCount; i++)
+			fprintf(m_Csv, ",%s_ms", GetProfilePhaseName((ProfilePhase)i));
+		fputs(",total_ms\n", m_Csv);
+		return true;
+	}
+
+	void FrameProfiler::Record(const FrameTimings& timings) {
+		m_Ring[m_Next] = timings;
+		m_Next = (m_Next + 1) % Capacity;
+
+		for (int i = 0; i < ProfilePhaseCount; i++) {
+			m_Sum.seconds[i] += timings.seconds[i];
+			m_Max.seconds[i] = std::max(m_Max.seconds[i], timings.seconds[i]);
+		}
+		const double total = timings.GetTotal();
+		m_TotalMax = std::max(m_TotalMax, total);
+
+		if (m_Csv) {
+			fprintf(m_Csv, "%llu", (unsigned long long)m_Frames);
+			for (double s : timings.seconds)
+				fprintf(m_Csv, ",%.4f", s * 1000.0);
+			fprintf(m_Csv, ",%.4f\n", total * 1000.0);
+		}
+		m_Frames++;
+	}
+
+	FrameTimings FrameProfiler::GetAverage(int frames) const {
+		FrameTimings average;
+		const int n = (int)std::min<uint64_t>(std::clamp(frames, 0, Capacity), m_Frames);
+		if (n == 0)
+			return average;
+		for (int k = 1; k <= n; k++) {
+			const FrameTimings& timings = m_Ring[(m_Next - k + Capacity) % Capacity];
+			for (int i = 0; i < ProfilePhaseCount; i++)
+				average.seconds[i] += timings.seconds[i];
+		}
+		for (double& s : average.seconds)
+			s /= n;
+		return average;
+	}
+
+	void FrameProfiler::PrintStats() const {
+		const double n = (double)std::max<uint64_t>(m_Frames, 1);
+		const double total = m_Sum.GetTotal();
+		printf("Profile: %llu frames, %.3f ms/frame mean, %.3f ms max\n",
+			(unsigned long long)m_Frames, total * 1000.0 / n, m_TotalMax * 1000.0);
+		for (int i = 0; i < ProfilePhaseCount; i++) {
+			printf("  %-12s %8.3f ms mean %8.3f ms max %5.1f%%\n", GetProfilePhaseName((ProfilePhase)i),
+				m_Sum.seconds[i] * 1000.0 / n, m_Max.seconds[i] * 1000.0,
+				total > 0.0 ? m_Sum.seconds[i] / total * 100.0 : 0.0);
+		}
+	}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	// What a frame's time goes to. Scopes nest: a hold body drawn inside the
+	// notes loop counts as HoldBodies only, so the phases add up to the frame.
+	enum class ProfilePhase {
+		Background,
+		JudgeLines,
+		Notes,
+		HoldBodies,
+		HitEffects,
+		Particles,
+		Hud,
+		Present,
+		Count
+	};
+
+	constexpr int ProfilePhaseCount = (int)ProfilePhase::Count;
+
+	const char* GetProfilePhaseName(ProfilePhase phase);
+
+	struct FrameTimings {
+		double seconds[ProfilePhaseCount] = {};
+
+		double& operator[](ProfilePhase phase) { return seconds[(int)phase]; }
+		double operator[](ProfilePhase phase) const { return seconds[(int)phase]; }
+		double GetTotal() const;
+	};
+
+	// Scopes on this thread add to `timings` until it is reset; with none set
+	// (and no trace running) they don't read the clock at all. Each render
+	// thread sets its own. While a trace runs each scope is also a trace event.
+	void SetProfileTarget(FrameTimings* timings);
+
+	class ProfileScope {
+	public:
+		explicit ProfileScope(ProfilePhase phase);
+		~ProfileScope();
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		FrameTimings* m_Target;
+		ProfilePhase m_Phase;
+		bool m_Traced;
+		ProfileScope* m_Parent = nullptr;
+		double m_Children = 0.0;
+		std::chrono::steady_clock::time_point m_Start;
+	};
+
+	// PGR_PROFILE_SCOPE(Notes) times the rest of the enclosing block. Built
+	// without PGR_PROFILER (cmake -DPGR_PROFILER=OFF) it expands to nothing.
+#ifdef PGR_PROFILER
+#define PGR_PROFILE_CONCAT_(a, b) a##b
+#define PGR_PROFILE_CONCAT(a, b) PGR_PROFILE_CONCAT_(a, b)
+#define PGR_PROFILE_SCOPE(phase) ::PGR::ProfileScope PGR_PROFILE_CONCAT(profileScope, __LINE__)(::PGR::ProfilePhase::phase)
+#else
+#define PGR_PROFILE_SCOPE(phase)
+#endif
+
+	// The last Capacity frames' timings for the overlay, running totals for
+	// the summary, and optionally one CSV row per frame.
+	class FrameProfiler {
+	public:
+		static constexpr int Capacity = 240;
+
+		FrameProfiler();
+		~FrameProfiler();
+
+		bool OpenCsv(const std::string& path);
+		void Record(const FrameTimings& timings);
+
+		uint64_t GetFrames() const { return m_Frames; }
+		// Mean of the last `frames` recorded, at most Capacity.
+		FrameTimings GetAverage(int frames = Capacity) const;
+		void PrintStats() const;
+
+	private:
+		std::vector<FrameTimings> m_Ring;
+		int m_Next = 0;
+		uint64_t m_Frames = 0;
+		FrameTimings m_Sum;
+		FrameTimings m_Max;
+		double m_TotalMax = 0.0;
+		FILE* m_Csv = nullptr;
+	};
+
+}
@@ -0,0 +1,147 @@
+#include "Trace.h"
+
+#include <mutex>
+#include <vector>
+#include <cstdio>
+
+namespace PGR {
+
+	namespace Trace {
+
+		std::atomic<bool> s_Enabled{ false };
+
+		struct Event {
+			const char* name;
+			const char* category;
+			int64_t start;
+			int64_t end;
+			int64_t arg;
+		};
+
+		// Filled by its thread only: an event is written, then published by
+		// bumping `count`. A full chunk links a new one and moves on.
+		struct Chunk {
+			static constexpr uint32_t Capacity = 4096;
+			Event events[Capacity];
+			std::atomic<uint32_t> count{ 0 };
+			std::atomic<Chunk*> next{ nullptr };
+		};
+
+		struct ThreadBuffer {
+			int tid = 0;
+			std::atomic<const char*> name{ nullptr };
+			Chunk* head = nullptr;
+			Chunk* tail = nullptr;
+		};
+
+		static std::mutex s_Mutex;
+		static std::vector<ThreadBuffer*> s_Buffers;
+		static std::string s_Path;
+		static int64_t s_Origin = 0;
+		// Bumped by every Start(), so a thread's buffer from an earlier trace isn't reused.
+		static std::atomic<uint32_t> s_Generation{ 0 };
+
+		static thread_local ThreadBuffer* t_Buffer = nullptr;
+		static thread_local uint32_t t_Generation = 0;
+
+		// Locks once per thread and trace, to register the thread's buffer.
+		static ThreadBuffer* GetBuffer() {
+			const uint32_t generation = s_Generation.load(std::memory_order_acquire);
+			if (t_Buffer && t_Generation == generation)
+				return t_Buffer;
+
+			ThreadBuffer* buffer = new ThreadBuffer();
+			buffer->head = buffer->tail = new Chunk();
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			buffer->tid = (int)s_Buffers.size() + 1;
+			s_Buffers.push_back(buffer);
+			t_Buffer = buffer;
+			t_Generation = generation;
+			return buffer;
+		}
+
+		bool Start(const std::string& path) {
+			FILE* file = fopen(path.c_str(), "w");
+			if (!file)
+				return false;
+			fclose(file);
+
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			s_Path = path;
+			s_Origin = Now();
+			s_Generation++;
+			s_Enabled = true;
+			return true;
+		}
+
+		void SetThreadName(const char* name) {
+			if (IsEnabled())
+				GetBuffer()->name = name;
+		}
+
+		void Complete(const char* name, const char* category, int64_t start, int64_t end, int64_t arg) {
+			if (!IsEnabled())
+				return;
+			ThreadBuffer* buffer = GetBuffer();
+			Chunk* chunk = buffer->tail;
+			uint32_t n = chunk->count.load(std::memory_order_relaxed);
+			if (n == Chunk::Capacity) {
+				Chunk* next = new Chunk();
+				chunk->next.store(next, std::memory_order_release);
+				buffer->tail = chunk = next;
+				n = 0;
+			}
+			chunk->events[n] = { name, category, start, end, arg };
+			chunk->count.store(n + 1, std::memory_order_release);
+		}
+
+		void Stop() {
+			if (!s_Enabled.exchange(false))
+				return;
+
+			std::lock_guard<std::mutex> lock(s_Mutex);
+			FILE* file = fopen(s_Path.c_str(), "w");
+			uint64_t events = 0;
+			if (file) {
+				fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+				fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"PGR\"}}");
+				for (ThreadBuffer* buffer : s_Buffers) {
+					const char* name = buffer->name.load(std::memory_order_acquire);
+					if (name) {
+						fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", buffer->tid, name);
+						fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}", buffer->tid, buffer->tid);
+					}
+					for (Chunk* chunk = buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+						const uint32_t count = chunk->count.load(std::memory_order_acquire);
+						for (uint32_t i = 0; i < count; i++) {
+							const Event& e = chunk->events[i];
+							fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+								e.name, e.category, buffer->tid, (e.start - s_Origin) / 1000.0, (e.end - e.start) / 1000.0);
+							if (e.arg >= 0)
+								fprintf(file, ",\"args\":{\"n\":%lld}", (long long)e.arg);
+							fputc('}', file);
+						}
+						events += count;
+					}
+				}
+				fputs("\n]}\n", file);
+				fclose(file);
+				printf("Trace: %llu events on %zu threads written to %s\n", (unsigned long long)events, s_Buffers.size(), s_Path.c_str());
+			}
+			else
+				printf("Failed to write trace %s\n", s_Path.c_str());
+
+			for (ThreadBuffer* buffer : s_Buffers) {
+				for (Chunk* chunk = buffer->head; chunk;) {
+					Chunk* next = chunk->next.load(std::memory_order_relaxed);
+					delete chunk;
+					chunk = next;
+				}
+				delete buffer;
+			}
+			s_Buffers.clear();
+		}
+
+	}
+
+}
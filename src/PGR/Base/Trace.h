@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+namespace PGR {
+
+	// A timeline of load steps, frame phases and worker threads in Chrome's
+	// trace-event format, for Perfetto (ui.perfetto.dev) or about:tracing.
+	// Each thread appends to a buffer of its own without locking; the buffers
+	// are written out by Trace::Stop(), once the threads that filled them are
+	// done. While no trace is running a scope is one relaxed load.
+	namespace Trace {
+
+		extern std::atomic<bool> s_Enabled;
+
+		inline bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+		// Event times: steady_clock, in nanoseconds.
+		inline int64_t ToTime(std::chrono::steady_clock::time_point t) {
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+		}
+		inline int64_t Now() { return ToTime(std::chrono::steady_clock::now()); }
+
+		bool Start(const std::string& path);
+		// Writes every event recorded so far and frees the buffers.
+		void Stop();
+
+		// Labels the calling thread's track; `name` must outlive the trace.
+		void SetThreadName(const char* name);
+		// A span from `start` to `end` (Now() / ToTime() values) on the calling thread.
+		// `name` and `category` must outlive the trace; `arg` < 0 is left out.
+		void Complete(const char* name, const char* category, int64_t start, int64_t end, int64_t arg = -1);
+
+	}
+
+	class TraceScope {
+	public:
+		TraceScope(const char* name, const char* category, int64_t arg = -1)
+			: m_Name(name), m_Category(category), m_Arg(arg), m_Start(Trace::IsEnabled() ? Trace::Now() : -1) {
+		}
+
+		~TraceScope() {
+			if (m_Start >= 0)
+				Trace::Complete(m_Name, m_Category, m_Start, Trace::Now(), m_Arg);
+		}
+
+		TraceScope(const TraceScope&) = delete;
+		TraceScope& operator=(const TraceScope&) = delete;
+
+	private:
+		const char* m_Name;
+		const char* m_Category;
+		int64_t m_Arg;
+		int64_t m_Start;
+	};
+
+#define PGR_TRACE_CONCAT_(a, b) a##b
+#define PGR_TRACE_CONCAT(a, b) PGR_TRACE_CONCAT_(a, b)
+	// PGR_TRACE_SCOPE("Parse chart", "load") spans the rest of the block;
+	// PGR_TRACE_SCOPE_ARG adds a number (frame, line) to the event.
+#define PGR_TRACE_SCOPE(name, category) ::PGR::TraceScope PGR_TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#define PGR_TRACE_SCOPE_ARG(name, category, arg) ::PGR::TraceScope PGR_TRACE_CONCAT(traceScope, __LINE__)(name, category, (int64_t)(arg))
+
+}
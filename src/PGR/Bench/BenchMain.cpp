@@ -0,0 +1,515 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "PGR/Bench/Benchmark.h"
+#include "PGR/Bench/StressSweep.h"
+#include "PGR/Chart/ChartLoader.h"
+#include "PGR/Chart/ChartGenerator.h"
+#include "PGR/Renderer/ChartRenderer.h"
+#include "PGR/Window/Framebuffer.h"
+#include "PGR/Export/FrameWriter.h"
+#include "PGR/Export/Qoi.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#include <stb_image/stb_image_write.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <unistd.h>
+#define _chdir chdir
+#endif
+
+using namespace PGR;
+
+// pgr_bench: timings of the rasterizer, chart evaluation, texture and load
+// kernels, and whole frames, runnable anywhere pgr_core builds.
+//
+//   pgr_bench [--json out.json] [--filter text] [--samples N] [--min-time ms]
+//             [--size WxH] [--chart info.txt]... [--resources dir] [--label text]
+//             [--sweep] [--generate chart.json] [--no-atlas] [stress chart options]
+//
+// The bundled charts under resources/chart are loaded when their chart file
+// is there; --chart adds others. Frames are rendered from the first chart
+// that loads, or from a synthetic chart if none does.
+//
+// --no-atlas leaves the skin's textures unpacked, to compare against the atlas.
+//
+// --sweep instead scales synthetic charts along one dimension at a time (see
+// StressSweep.h); --generate writes one such chart and exits. Both, and the
+// stand-in chart, start from the stress chart options:
+//   --lines N --notes N (per line) --duration s --bpm N
+//   --move/--rotate/--alpha/--speed N (events per second per line)
+//   --holds ratio --chords ratio --speed-pattern constant|ramp|pulse|negative --seed N
+
+namespace {
+
+	struct BenchChart {
+		std::string name;
+		std::string chartPath;
+		std::string picturePath;
+		std::string json;
+	};
+
+	bool ReadFile(const std::string& path, std::string& text) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	// The Chart: and Picture: entries of an info.txt, next to it.
+	BenchChart ReadChartInfo(const std::filesystem::path& infoPath) {
+		BenchChart chart;
+		chart.name = infoPath.parent_path().filename().u8string();
+		std::ifstream file(infoPath);
+		std::string line;
+		while (std::getline(file, line)) {
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (line.find("Chart:") == 0)
+				chart.chartPath = (infoPath.parent_path() / std::filesystem::u8path(line.substr(7))).u8string();
+			else if (line.find("Picture:") == 0)
+				chart.picturePath = (infoPath.parent_path() / std::filesystem::u8path(line.substr(9))).u8string();
+		}
+		return chart;
+	}
+
+	const char* NullDevice() {
+#ifdef _WIN32
+		return "NUL";
+#else
+		return "/dev/null";
+#endif
+	}
+
+	const char* FormatName(FramebufferFormat format) {
+		return GetFramebufferFormatName(format);
+	}
+
+	// Rasterizer, texture, chart, frame, present and export kernels; the
+	// default run. Returns false if a kernel's output fails its check.
+	bool RunKernels(BenchRunner& runner, C* c, const Respack& respack, Texture* hitFxSheet,
+		std::vector<BenchChart>& charts, const StressChartConfig& stress, int width, int height) {
+		bool ok = true;
+		ChartRenderer scratch(*c);
+		const FramebufferFormat formats[] = { FramebufferFormat::Float, FramebufferFormat::BGRX8 };
+
+		// Rasterizer primitives.
+		for (FramebufferFormat format : formats) {
+			const std::string prefix = std::string("Framebuffer/") + FormatName(format) + "/";
+			Framebuffer* fb = Framebuffer::Create(width, height, format);
+			fb->LoadFontTTF("font.ttf");
+			const double pixels = (double)width * height;
+
+			runner.Run(prefix + "Clear", [&]() { fb->Clear(Vec3(0.0f)); }, pixels, "px");
+			runner.Run(prefix + "SetColor opaque 256x256", [&]() {
+				for (int y = 0; y < 256; y++)
+					for (int x = 0; x < 256; x++)
+						fb->SetColor(x, y, Vec4(0.8f, 0.4f, 0.2f, 1.0f));
+			}, 65536.0, "px");
+			runner.Run(prefix + "SetColor blend 256x256", [&]() {
+				for (int y = 0; y < 256; y++)
+					for (int x = 0; x < 256; x++)
+						fb->SetColor(x, y, Vec4(0.8f, 0.4f, 0.2f, 0.5f));
+			}, 65536.0, "px");
+			runner.Run(prefix + "FillRect full screen 20%", [&]() {
+				fb->FillRect(0, 0, width, height, Vec4(0.0f, 0.0f, 0.0f, 0.2f));
+			}, pixels, "px");
+			runner.Run(prefix + "DrawLine judge line", [&]() {
+				fb->DrawLine(0, height / 3, width, height * 2 / 3, height * linew, Vec4(pcolor, palpha));
+			});
+			runner.Run(prefix + "DrawTextTTF score", [&]() {
+				fb->DrawTextTTF(width - width * 365 / 1920, height * 39 / 1080, "0123456", Vec4(1.0f), width * 70.0f / 1920.0f);
+			}, 7.0, "glyph");
+			runner.Run(prefix + "DrawCenterTextTTF rotated", [&]() {
+				fb->DrawCenterTextTTF(width / 2, height / 2, "[3] (0.12, -0.25) 30d 100: 1.00", Vec4(1.0f), width * 0.04f, 30.0f);
+			}, 31.0, "glyph");
+
+			// Notes at the sizes and angles the field shows them; hit effects plain
+			// and tinted.
+			Texture* note = c->noteImgs.click;
+			const float noteScale = noteSize * width / note->GetWidth();
+			const float scales[] = { 0.5f, 1.0f, 2.0f };
+			const float angles[] = { 0.0f, 30.0f, 90.0f };
+			for (float scale : scales) {
+				for (float angle : angles) {
+					char name[96];
+					snprintf(name, sizeof(name), "%sDrawTexture note x%.1f %.0fdeg", prefix.c_str(), scale, angle);
+					const float s = noteScale * scale;
+					runner.Run(name, [&]() {
+						scratch.DrawTexture(fb, note, width / 2, height / 2, s, s, angle);
+					}, (double)note->GetWidth() * note->GetHeight() * s * s, "px");
+				}
+			}
+			Texture* effect = c->hitFxImgs[c->hitFxImgs.size() / 2];
+			const float effectScale = noteSize * width * 1.375f * 1.12f / effect->GetWidth();
+			const double effectPixels = (double)effect->GetWidth() * effect->GetHeight() * effectScale * effectScale;
+			double plain = 0.0;
+			if (BenchResult* result = runner.Run(prefix + "DrawTexture hit effect", [&]() {
+				scratch.DrawTexture(fb, effect, width / 2, height / 2, effectScale, effectScale, 0.0f);
+			}, effectPixels, "px"))
+				plain = result->median;
+			BenchResult* tinted = runner.Run(prefix + "DrawTexture hit effect tinted", [&]() {
+				scratch.DrawTexture(fb, effect, width / 2, height / 2, effectScale, effectScale, 0.0f, Vec4(pcolor, 1.0f));
+			}, effectPixels, "px");
+			// What tinting at draw time costs over drawing the frame as it is.
+			if (tinted && plain > 0.0) {
+				const double overhead = tinted->median / plain - 1.0;
+				tinted->counters.push_back({ "tint_overhead", overhead });
+				printf("  tint: %+.1f%%, %+.2f ns/px\n", overhead * 100.0, (tinted->median - plain) * 1e9 / effectPixels);
+			}
+
+			delete fb;
+		}
+
+		// Texture preparation, as done at load.
+		const int frameW = hitFxSheet->GetWidth() / std::max(1, (int)respack.hitFx.X);
+		const int frameH = hitFxSheet->GetHeight() / std::max(1, (int)respack.hitFx.Y);
+		runner.Run("Texture/ClipBlockImg hitFX frame", [&]() {
+			delete hitFxSheet->ClipBlockImg(0, 0, frameW, frameH);
+		}, (double)frameW * frameH, "px");
+		Texture* frame = hitFxSheet->ClipBlockImg(0, 0, frameW, frameH);
+		runner.Run("Texture/ColorTexture hitFX frame", [&]() {
+			delete frame->ColorTexture(Vec4(pcolor, 1.0f));
+		}, (double)frameW * frameH, "px");
+		delete frame;
+
+		// Chart loading, and the first chart that loads for the rest.
+		bool loaded = false;
+		auto load = [&](const BenchChart& chart) {
+			const std::string name = "ChartLoad/" + chart.name;
+			ChartData probe;
+			if (!LoadChartData(chart.json, probe)) {
+				runner.Skip(name, "not a chart");
+				return;
+			}
+			runner.Run(name, [&]() {
+				ChartData data;
+				LoadChartData(chart.json, data);
+			}, (double)probe.noteCount, "note");
+
+			if (loaded)
+				return;
+			loaded = true;
+			c->chart.data = probe;
+			c->chart.image = new Texture(chart.picturePath);
+			c->chart.info.name = std::filesystem::u8path(chart.name).wstring();
+			c->chart.info.level = L"Lv.?";
+			printf("\nFrames from %s: %zu lines, %d notes, %.1f s\n\n", chart.name.c_str(),
+				probe.judgeLines.size(), probe.noteCount, probe.time);
+		};
+		for (BenchChart& chart : charts) {
+			if (!ReadFile(chart.chartPath, chart.json)) {
+				runner.Skip("ChartLoad/" + chart.name, "no chart file " + std::filesystem::u8path(chart.chartPath).filename().u8string());
+				continue;
+			}
+			load(chart);
+		}
+
+		// The bundled charts ship without their chart files, so without a
+		// --chart a generated chart, the same on every run, stands in, over
+		// the first bundled picture.
+		if (!loaded) {
+			BenchChart synthetic;
+			synthetic.name = "synthetic";
+			synthetic.json = GenerateStressChart(stress);
+			for (const BenchChart& chart : charts) {
+				if (std::filesystem::exists(std::filesystem::u8path(chart.picturePath))) {
+					synthetic.picturePath = chart.picturePath;
+					break;
+				}
+			}
+			load(synthetic);
+		}
+
+		if (!loaded) {
+			const char* reason = "no chart loaded";
+			runner.Skip("Texture/GetBlurImg background", reason);
+			runner.Skip("Chart/findEvent", reason);
+			runner.Skip("Chart/getState all lines", reason);
+			runner.Skip("Render", reason);
+		}
+		else {
+			const ChartData& data = c->chart.data;
+			runner.Run("Texture/GetBlurImg background", [&]() {
+				delete c->chart.image->GetBlurImg(0.0f);
+			}, (double)c->chart.image->GetWidth() * c->chart.image->GetHeight(), "px");
+			c->chart.blurImage = c->chart.image->GetBlurImg(0.0f);
+
+			// The line with the most move events, probed across the whole chart.
+			size_t busiest = 0;
+			for (size_t i = 0; i < data.judgeLines.size(); i++) {
+				if (data.judgeLines[i].moveEvents.size() > data.judgeLines[busiest].moveEvents.size())
+					busiest = i;
+			}
+			const JudgeLine& line = data.judgeLines[busiest];
+			const int probes = 256;
+			const float endBeat = line.sec2beat(data.time);
+			char name[96];
+			snprintf(name, sizeof(name), "Chart/findEvent %zu move events", line.moveEvents.size());
+			volatile int sink = 0;
+			runner.Run(name, [&]() {
+				for (int i = 0; i < probes; i++)
+					sink = sink + findEvent(endBeat * i / probes, line.moveEvents);
+			}, probes, "lookup");
+			runner.Run("Chart/getState all lines", [&]() {
+				float sum = 0.0f;
+				for (int i = 0; i < 16; i++) {
+					for (const JudgeLine& l : data.judgeLines)
+						sum += l.getState(data.time * i / 16.0f).x;
+				}
+				sink = sink + (int)sum;
+			}, 16.0 * data.judgeLines.size(), "state");
+
+			// Whole frames, cleared and drawn, at fixed points of the chart.
+			const float points[] = { 0.25f, 0.5f, 0.75f };
+			std::vector<uint32_t> floatFrame;
+			for (FramebufferFormat format : formats) {
+				Framebuffer* fb = Framebuffer::Create(width, height, format);
+				fb->LoadFontTTF("font.ttf");
+				ChartRenderer renderer(*c);
+				for (float point : points) {
+					const float t = data.time * point;
+					snprintf(name, sizeof(name), "Render/%s/%dx%d t=%.0f%%", FormatName(format), width, height, point * 100.0f);
+					runner.Run(name, [&]() {
+						fb->Clear(Vec3(0.0f));
+						renderer.Render(fb, t, c->camera);
+					}, 1.0, "frame");
+				}
+
+				// Getting a frame out, from the middle of the chart: into the
+				// window's 32bpp DIB, and as RGB24, QOI and PNG for export.
+				fb->Clear(Vec3(0.0f));
+				renderer.Render(fb, data.time * 0.5f, c->camera);
+				const std::string prefix = std::string("/") + FormatName(format) + "/";
+				const double pixels = (double)width * height;
+
+				std::vector<uint32_t> dib((size_t)width * height), reference(dib.size());
+				auto perPixel = [&]() {
+					for (int y = 0; y < height; y++) {
+						for (int x = 0; x < width; x++) {
+							const Vec3 color = fb->GetColor(x, height - 1 - y);
+							reference[(size_t)y * width + x] = 0xff000000 | ((uint32_t)ColorToByte(color.X) << 16) | ((uint32_t)ColorToByte(color.Y) << 8) | ColorToByte(color.Z);
+						}
+					}
+				};
+				// The window's conversion before the pack, for comparison.
+				if (format == FramebufferFormat::Float)
+					runner.Run("Present" + prefix + "per-pixel GetColor", perPixel, pixels, "px");
+				runner.Run("Present" + prefix + "CopyToBGRX", [&]() {
+					fb->CopyToBGRX(dib.data(), width, width, height);
+				}, pixels, "px");
+				fb->CopyToBGRX(dib.data(), width, width, height);
+				if (format == FramebufferFormat::Float) {
+					perPixel();
+					if (dib != reference) {
+						puts("  CopyToBGRX differs from the per-pixel conversion");
+						ok = false;
+					}
+					floatFrame = dib;
+				}
+				else if (floatFrame.size() == dib.size() && runner.IsSelected("Present" + prefix + "CopyToBGRX")) {
+					// How far 8-bit blending strays from the float render.
+					int drift = 0;
+					for (size_t p = 0; p < dib.size(); p++) {
+						for (int shift = 0; shift < 24; shift += 8)
+							drift = std::max(drift, std::abs((int)((dib[p] >> shift) & 0xff) - (int)((floatFrame[p] >> shift) & 0xff)));
+					}
+					printf("  %s frame differs from the float one by up to %d/255\n", FormatName(format), drift);
+				}
+
+				FrameWriter writer;
+				if (!writer.Open(NullDevice(), FrameFormat::RGB24, width, height, 60)) {
+					printf("Failed to open %s\n", NullDevice());
+					ok = false;
+					delete fb;
+					continue;
+				}
+				std::vector<unsigned char> rgb(writer.GetFrameSize()), qoi, decoded;
+				runner.Run("Export" + prefix + "RGB24 convert", [&]() {
+					writer.Convert(fb, rgb.data());
+				}, pixels, "px");
+				writer.Convert(fb, rgb.data());
+
+				auto qoiSize = [&](BenchResult* result) {
+					if (result)
+						result->counters.push_back({ "bytes", (double)qoi.size() });
+				};
+				qoiSize(runner.Run("Export" + prefix + "QoiEncode", [&]() {
+					qoi.clear();
+					QoiEncode(fb, qoi);
+				}, pixels, "px"));
+				// What export captures used to do after the RGB24 convert.
+				qoiSize(runner.Run("Export" + prefix + "QoiEncode from RGB24", [&]() {
+					qoi.clear();
+					QoiEncode(rgb.data(), width, height, qoi);
+				}, pixels, "px"));
+				qoi.clear();
+				QoiEncode(fb, qoi);
+				int decodedWidth = 0, decodedHeight = 0;
+				qoiSize(runner.Run("Export" + prefix + "QoiDecode", [&]() {
+					QoiDecode(qoi.data(), qoi.size(), decoded, decodedWidth, decodedHeight);
+				}, pixels, "px"));
+				if (!QoiDecode(qoi.data(), qoi.size(), decoded, decodedWidth, decodedHeight) || decoded != rgb) {
+					printf("  The %s frame doesn't survive a QOI round trip\n", FormatName(format));
+					ok = false;
+				}
+
+				uint64_t pngBytes = 0;
+				BenchResult* png = runner.Run("Export" + prefix + "PNG encode", [&]() {
+					pngBytes = 0;
+					stbi_write_png_to_func([](void* context, void*, int size) { *(uint64_t*)context += size; },
+						&pngBytes, width, height, 3, rgb.data(), width * 3);
+				}, pixels, "px");
+				if (png)
+					png->counters.push_back({ "bytes", (double)pngBytes });
+				delete fb;
+			}
+		}
+		return ok;
+	}
+
+}
+
+int main(int argc, char** argv) {
+	BenchConfig config;
+	std::string jsonPath;
+	std::string label = "pgr_bench";
+	std::string resources = "../../resources";
+	std::vector<std::filesystem::path> chartInfos;
+	int width = 1280, height = 720;
+	StressChartConfig stress;
+	bool sweep = false;
+	bool atlas = true;
+	std::string generatePath;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--json" && i + 1 < argc)
+			jsonPath = std::filesystem::absolute(argv[++i]).u8string();
+		else if (arg == "--filter" && i + 1 < argc)
+			config.filter = argv[++i];
+		else if (arg == "--samples" && i + 1 < argc)
+			config.samples = std::max(1, atoi(argv[++i]));
+		else if (arg == "--min-time" && i + 1 < argc)
+			config.minSampleSeconds = std::max(0.0, atof(argv[++i]) / 1000.0);
+		else if (arg == "--size" && i + 1 < argc)
+			sscanf(argv[++i], "%dx%d", &width, &height);
+		else if (arg == "--chart" && i + 1 < argc)
+			chartInfos.push_back(std::filesystem::absolute(argv[++i]));
+		else if (arg == "--resources" && i + 1 < argc)
+			resources = argv[++i];
+		else if (arg == "--label" && i + 1 < argc)
+			label = argv[++i];
+		else if (arg == "--sweep")
+			sweep = true;
+		else if (arg == "--no-atlas")
+			atlas = false;
+		else if (arg == "--generate" && i + 1 < argc)
+			generatePath = argv[++i];
+		else if (arg == "--lines" && i + 1 < argc)
+			stress.lines = std::max(1, atoi(argv[++i]));
+		else if (arg == "--notes" && i + 1 < argc)
+			stress.notesPerLine = std::max(0, atoi(argv[++i]));
+		else if (arg == "--duration" && i + 1 < argc)
+			stress.duration = std::max(1.0f, (float)atof(argv[++i]));
+		else if (arg == "--bpm" && i + 1 < argc)
+			stress.bpm = std::max(1.0f, (float)atof(argv[++i]));
+		else if (arg == "--move" && i + 1 < argc)
+			stress.moveDensity = (float)atof(argv[++i]);
+		else if (arg == "--rotate" && i + 1 < argc)
+			stress.rotateDensity = (float)atof(argv[++i]);
+		else if (arg == "--alpha" && i + 1 < argc)
+			stress.alphaDensity = (float)atof(argv[++i]);
+		else if (arg == "--speed" && i + 1 < argc)
+			stress.speedDensity = (float)atof(argv[++i]);
+		else if (arg == "--holds" && i + 1 < argc)
+			stress.holdRatio = (float)atof(argv[++i]);
+		else if (arg == "--chords" && i + 1 < argc)
+			stress.chordRatio = (float)atof(argv[++i]);
+		else if (arg == "--speed-pattern" && i + 1 < argc) {
+			if (!ParseSpeedPattern(argv[++i], stress.speedPattern)) {
+				printf("Unknown speed pattern %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (arg == "--seed" && i + 1 < argc)
+			stress.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else {
+			printf("Unknown argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (!generatePath.empty()) {
+		const std::string json = GenerateStressChart(stress);
+		FILE* file = fopen(generatePath.c_str(), "wb");
+		if (!file || fwrite(json.data(), 1, json.size(), file) != json.size()) {
+			printf("Failed to write %s\n", generatePath.c_str());
+			if (file)
+				fclose(file);
+			return 1;
+		}
+		fclose(file);
+		printf("%d lines x %d notes, %.0f s, written to %s (%zu KB)\n", stress.lines, stress.notesPerLine,
+			stress.duration, generatePath.c_str(), json.size() / 1024);
+		return 0;
+	}
+
+	// Skin textures load from the working directory, as in the viewer.
+	if (_chdir(resources.c_str())) {
+		printf("No resources directory at %s\n", resources.c_str());
+		return 1;
+	}
+
+	std::vector<BenchChart> charts;
+	std::error_code error;
+	std::vector<std::filesystem::path> bundled;
+	for (const auto& entry : std::filesystem::directory_iterator("chart", error)) {
+		if (std::filesystem::exists(entry.path() / "info.txt"))
+			bundled.push_back(entry.path() / "info.txt");
+	}
+	std::sort(bundled.begin(), bundled.end());
+	bundled.insert(bundled.end(), chartInfos.begin(), chartInfos.end());
+	for (const std::filesystem::path& info : bundled)
+		charts.push_back(ReadChartInfo(info));
+
+	puts("Loading skin...");
+	C* c = new C();
+	Respack respack;
+	std::string respackJson;
+	if (!ReadFile("respack.json", respackJson) || !ParseRespack(respackJson, respack)) {
+		puts("No respack.json in the resources directory");
+		return 1;
+	}
+	// An unpacked copy of the sheet, for the clip benchmarks.
+	Texture* hitFxSheet = new Texture("hitFx.png");
+	ClipHoldImgs(*c, respack);
+	ClipHitFxImgs(*c, respack);
+	PackSkin(*c, atlas);
+	puts("");
+
+	BenchRunner runner(config);
+	bool ok = true;
+	if (sweep)
+		RunStressSweep(runner, *c, stress, width, height);
+	else
+		ok = RunKernels(runner, c, respack, hitFxSheet, charts, stress, width, height);
+
+	if (!jsonPath.empty()) {
+		if (runner.WriteJson(jsonPath, label))
+			printf("\n%zu results written to %s\n", runner.GetResults().size(), jsonPath.c_str());
+		else {
+			printf("\nFailed to write %s\n", jsonPath.c_str());
+			return 1;
+		}
+	}
+	return ok ? 0 : 1;
+}
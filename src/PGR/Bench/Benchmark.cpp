@@ -0,0 +1,154 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+namespace PGR {
+
+	using Clock = std::chrono::steady_clock;
+
+	double Median(std::vector<double>& values) {
+		if (values.empty())
+			return 0.0;
+		const size_t mid = values.size() / 2;
+		std::nth_element(values.begin(), values.begin() + mid, values.end());
+		const double upper = values[mid];
+		if (values.size() % 2)
+			return upper;
+		const double lower = *std::max_element(values.begin(), values.begin() + mid);
+		return (lower + upper) * 0.5;
+	}
+
+	// 1234.5 ns -> "1.23 us".
+	static std::string FormatTime(double seconds) {
+		char text[32];
+		if (seconds < 1e-6)
+			snprintf(text, sizeof(text), "%.1f ns", seconds * 1e9);
+		else if (seconds < 1e-3)
+			snprintf(text, sizeof(text), "%.2f us", seconds * 1e6);
+		else if (seconds < 1.0)
+			snprintf(text, sizeof(text), "%.2f ms", seconds * 1e3);
+		else
+			snprintf(text, sizeof(text), "%.2f s", seconds);
+		return text;
+	}
+
+	static std::string EscapeJson(const std::string& text) {
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	BenchRunner::BenchRunner(const BenchConfig& config)
+		: m_Config(config) {
+		printf("%-44s %10s %7s %10s %12s  %s\n", "Benchmark", "Median", "MAD", "Min", "Iterations", "Throughput");
+	}
+
+	bool BenchRunner::IsSelected(const std::string& name) const {
+		return m_Config.filter.empty() || name.find(m_Config.filter) != std::string::npos;
+	}
+
+	BenchResult* BenchRunner::Run(const std::string& name, const std::function<void()>& body, double items, const std::string& itemUnit) {
+		if (!IsSelected(name))
+			return nullptr;
+
+		auto sample = [&](uint64_t iterations) {
+			const Clock::time_point start = Clock::now();
+			for (uint64_t i = 0; i < iterations; i++)
+				body();
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		};
+
+		// Grow the batch until one sample lasts minSampleSeconds, at most 100x a step.
+		uint64_t iterations = 1;
+		double elapsed = sample(iterations);
+		while (elapsed < m_Config.minSampleSeconds && iterations < (1ULL << 32)) {
+			const double scale = elapsed > 0.0 ? m_Config.minSampleSeconds / elapsed * 1.2 : 100.0;
+			iterations = std::max(iterations + 1, (uint64_t)(iterations * std::min(scale, 100.0)));
+			elapsed = sample(iterations);
+		}
+
+		for (int i = 0; i < m_Config.warmupSamples; i++)
+			sample(iterations);
+
+		std::vector<double> times;
+		for (int i = 0; i < std::max(m_Config.samples, 1); i++)
+			times.push_back(sample(iterations) / iterations);
+
+		BenchResult result;
+		result.name = name;
+		result.iterations = iterations;
+		result.samples = (int)times.size();
+		result.min = *std::min_element(times.begin(), times.end());
+		result.max = *std::max_element(times.begin(), times.end());
+		result.median = Median(times);
+		std::vector<double> deviations;
+		for (double t : times)
+			deviations.push_back(std::abs(t - result.median));
+		result.mad = Median(deviations);
+		result.items = items;
+		result.itemUnit = itemUnit;
+
+		char throughput[64] = "";
+		if (items > 0.0 && result.median > 0.0) {
+			const double rate = items / result.median;
+			if (rate >= 1e6)
+				snprintf(throughput, sizeof(throughput), "%.2f M%s/s", rate / 1e6, itemUnit.c_str());
+			else
+				snprintf(throughput, sizeof(throughput), "%.1f %s/s", rate, itemUnit.c_str());
+		}
+		printf("%-44s %10s %6.1f%% %10s %6llu x %3d  %s\n", name.c_str(), FormatTime(result.median).c_str(),
+			result.median > 0.0 ? result.mad / result.median * 100.0 : 0.0, FormatTime(result.min).c_str(),
+			(unsigned long long)iterations, result.samples, throughput);
+		fflush(stdout);
+		m_Results.push_back(result);
+		return &m_Results.back();
+	}
+
+	void BenchRunner::Skip(const std::string& name, const std::string& reason) {
+		if (!IsSelected(name))
+			return;
+		printf("%-44s skipped: %s\n", name.c_str(), reason.c_str());
+		BenchResult result;
+		result.name = name;
+		result.skipped = reason;
+		m_Results.push_back(result);
+	}
+
+	bool BenchRunner::WriteJson(const std::string& path, const std::string& label) const {
+		FILE* file = fopen(path.c_str(), "w");
+		if (!file)
+			return false;
+		fprintf(file, "{\n  \"label\": \"%s\",\n  \"min_sample_seconds\": %g,\n  \"warmup_samples\": %d,\n  \"samples\": %d,\n  \"benchmarks\": [",
+			EscapeJson(label).c_str(), m_Config.minSampleSeconds, m_Config.warmupSamples, m_Config.samples);
+		for (size_t i = 0; i < m_Results.size(); i++) {
+			const BenchResult& r = m_Results[i];
+			fprintf(file, "%s\n    {\"name\": \"%s\"", i ? "," : "", EscapeJson(r.name).c_str());
+			if (!r.skipped.empty())
+				fprintf(file, ", \"skipped\": \"%s\"}", EscapeJson(r.skipped).c_str());
+			else {
+				fprintf(file, ", \"median_ns\": %.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f, \"iterations\": %llu, \"samples\": %d",
+					r.median * 1e9, r.mad * 1e9, r.min * 1e9, r.max * 1e9, (unsigned long long)r.iterations, r.samples);
+				if (r.items > 0.0)
+					fprintf(file, ", \"items\": %g, \"item_unit\": \"%s\"", r.items, EscapeJson(r.itemUnit).c_str());
+				if (!r.counters.empty()) {
+					fputs(", \"counters\": {", file);
+					for (size_t j = 0; j < r.counters.size(); j++)
+						fprintf(file, "%s\"%s\": %.17g", j ? ", " : "", EscapeJson(r.counters[j].first).c_str(), r.counters[j].second);
+					fputc('}', file);
+				}
+				fputc('}', file);
+			}
+		}
+		fputs("\n  ]\n}\n", file);
+		fclose(file);
+		return true;
+	}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace PGR {
+
+	struct BenchConfig {
+		// Each sample runs the body enough times to last at least this long,
+		// so clock resolution and call overhead stay out of the numbers.
+		double minSampleSeconds = 0.01;
+		// Untimed samples first, for caches, page faults and clock ramp-up.
+		int warmupSamples = 3;
+		int samples = 21;
+		// Only benchmarks whose name contains this run.
+		std::string filter;
+	};
+
+	struct BenchResult {
+		std::string name;
+		// Iterations per sample, and the per-iteration time of the samples.
+		uint64_t iterations = 0;
+		int samples = 0;
+		double median = 0.0;
+		// Median absolute deviation from the median: a spread that one
+		// descheduled sample can't move.
+		double mad = 0.0;
+		double min = 0.0;
+		double max = 0.0;
+		// Work per iteration (pixels, events, bytes), for a rate; 0 for none.
+		double items = 0.0;
+		std::string itemUnit;
+		// Why it didn't run, if it didn't.
+		std::string skipped;
+		// Extra numbers about what was measured (sizes, counts), for the JSON.
+		std::vector<std::pair<std::string, double>> counters;
+	};
+
+	// Runs and records benchmarks: warm-up, then `samples` timed samples of
+	// a calibrated batch, reduced to median and MAD per iteration.
+	class BenchRunner {
+	public:
+		BenchRunner(const BenchConfig& config = BenchConfig());
+
+		bool IsSelected(const std::string& name) const;
+		// Times `body`; `items` of `itemUnit` per call give a throughput.
+		// Returns the result, or nullptr if the filter left it out. It stays
+		// valid, and in place, for the runner's lifetime: later runs don't move it.
+		BenchResult* Run(const std::string& name, const std::function<void()>& body, double items = 0.0, const std::string& itemUnit = "");
+		// Records a benchmark that couldn't run here, so results stay comparable.
+		void Skip(const std::string& name, const std::string& reason);
+
+		const std::deque<BenchResult>& GetResults() const { return m_Results; }
+
+		// One object per benchmark, times in nanoseconds, plus the settings.
+		bool WriteJson(const std::string& path, const std::string& label) const;
+
+	private:
+		BenchConfig m_Config;
+		std::deque<BenchResult> m_Results;
+	};
+
+	// Median of `values` (reordered).
+	double Median(std::vector<double>& values);
+
+}
@@ -0,0 +1,158 @@
+#include "StressSweep.h"
+#include "PGR/Chart/ChartLoader.h"
+#include "PGR/Renderer/ChartRenderer.h"
+#include "PGR/Window/Framebuffer.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <functional>
+
+namespace PGR {
+
+	struct SweepPoint {
+		std::string name;
+		StressChartConfig config;
+	};
+
+	struct SweepRow {
+		std::string name;
+		int notes = 0;
+		size_t events = 0;
+		size_t jsonBytes = 0;
+		size_t dataBytes = 0;
+		double load = -1.0;
+		double frame = -1.0;
+	};
+
+	template<typename T>
+	static size_t GetVectorBytes(const std::vector<T>& v) {
+		return v.capacity() * sizeof(T);
+	}
+
+	size_t GetChartDataBytes(const ChartData& data) {
+		size_t bytes = sizeof(ChartData) + GetVectorBytes(data.judgeLines)
+			+ GetVectorBytes(data.clickEffectCollection) + GetVectorBytes(data.hitsounds);
+		for (const JudgeLine& line : data.judgeLines) {
+			bytes += GetVectorBytes(line.moveEvents) + GetVectorBytes(line.rotateEvents)
+				+ GetVectorBytes(line.disappearEvents) + GetVectorBytes(line.speedEvents)
+				+ GetVectorBytes(line.notesAbove) + GetVectorBytes(line.notesBelow) + GetVectorBytes(line.notes);
+		}
+		return bytes;
+	}
+
+	static std::vector<SweepPoint> GetSweepPoints(const StressChartConfig& base) {
+		std::vector<SweepPoint> points;
+		auto add = [&](const char* dimension, double value, const std::function<void(StressChartConfig&)>& set) {
+			char name[64];
+			snprintf(name, sizeof(name), "%s=%g", dimension, value);
+			SweepPoint point = { name, base };
+			set(point.config);
+			points.push_back(point);
+		};
+
+		// Storyboard charts: hundreds of lines.
+		for (int lines : { 1, 16, 64, 300 })
+			add("lines", lines, [&](StressChartConfig& c) { c.lines = lines; });
+		// Marathons: thousands of notes.
+		for (int notes : { 25, 250, 2500 })
+			add("notes", notes, [&](StressChartConfig& c) { c.notesPerLine = notes; });
+		// Lines animated by many short events, one type at a time.
+		for (float density : { 1.0f, 10.0f, 100.0f }) {
+			add("move", density, [&](StressChartConfig& c) { c.moveDensity = density; });
+			add("rotate", density, [&](StressChartConfig& c) { c.rotateDensity = density; });
+			add("alpha", density, [&](StressChartConfig& c) { c.alphaDensity = density; });
+			add("speed", density, [&](StressChartConfig& c) { c.speedDensity = density; });
+		}
+		for (float ratio : { 0.0f, 0.5f, 1.0f })
+			add("holds", ratio, [&](StressChartConfig& c) { c.holdRatio = ratio; });
+		for (float ratio : { 0.0f, 0.5f, 1.0f })
+			add("chords", ratio, [&](StressChartConfig& c) { c.chordRatio = ratio; });
+		for (SpeedPattern pattern : { SpeedPattern::Constant, SpeedPattern::Ramp, SpeedPattern::Pulse, SpeedPattern::Negative }) {
+			SweepPoint point = { std::string("pattern=") + GetSpeedPatternName(pattern), base };
+			point.config.speedPattern = pattern;
+			points.push_back(point);
+		}
+		return points;
+	}
+
+	void RunStressSweep(BenchRunner& runner, C& c, const StressChartConfig& base, int width, int height) {
+		printf("Base: %d lines x %d notes, %.0f s at %.0f BPM; events/s move %g, rotate %g, alpha %g, speed %g; "
+			"holds %g, chords %g, %s speed, seed %u\n\n",
+			base.lines, base.notesPerLine, base.duration, base.bpm, base.moveDensity, base.rotateDensity,
+			base.alphaDensity, base.speedDensity, base.holdRatio, base.chordRatio,
+			GetSpeedPatternName(base.speedPattern), base.seed);
+
+		// No background picture: frames time the chart, not a full-screen blit.
+		c.chart.image = new Texture(Vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		c.chart.blurImage = new Texture(Vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		c.chart.info.name = L"Stress";
+		c.chart.info.level = L"SP Lv.?";
+
+		Framebuffer* fb = Framebuffer::Create(width, height);
+		fb->LoadFontTTF("font.ttf");
+		std::vector<SweepRow> rows;
+
+		for (const SweepPoint& point : GetSweepPoints(base)) {
+			const std::string prefix = "Sweep/" + point.name + "/";
+			if (!runner.IsSelected(prefix + "Load") && !runner.IsSelected(prefix + "Frames"))
+				continue;
+
+			SweepRow row;
+			row.name = point.name;
+			const std::string json = GenerateStressChart(point.config);
+			ChartData data;
+			LoadChartData(json, data);
+			row.notes = data.noteCount;
+			for (const JudgeLine& line : data.judgeLines)
+				row.events += line.moveEvents.size() + line.rotateEvents.size() + line.disappearEvents.size() + line.speedEvents.size();
+			row.jsonBytes = json.size();
+			row.dataBytes = GetChartDataBytes(data);
+
+			auto addCounters = [&](BenchResult* result) {
+				result->counters.push_back({ "notes", (double)row.notes });
+				result->counters.push_back({ "events", (double)row.events });
+				result->counters.push_back({ "hit_effects", (double)data.clickEffectCollection.size() });
+				result->counters.push_back({ "json_bytes", (double)row.jsonBytes });
+				result->counters.push_back({ "chart_bytes", (double)row.dataBytes });
+			};
+
+			if (BenchResult* result = runner.Run(prefix + "Load", [&]() {
+				ChartData loaded;
+				LoadChartData(json, loaded);
+			}, row.notes, "note")) {
+				addCounters(result);
+				row.load = result->median;
+			}
+
+			// Every call draws the same frames spread over the chart, so each
+			// sample does the same work whatever the batch size.
+			c.chart.data = data;
+			ChartRenderer renderer(c);
+			const int frames = 16;
+			if (BenchResult* result = runner.Run(prefix + "Frames", [&]() {
+				for (int frame = 0; frame < frames; frame++) {
+					fb->Clear(Vec3(0.0f));
+					renderer.Render(fb, point.config.duration * (frame + 0.5f) / frames, c.camera);
+				}
+			}, frames, "frame")) {
+				addCounters(result);
+				row.frame = result->median / frames;
+			}
+			rows.push_back(row);
+		}
+		delete fb;
+
+		printf("\n%-18s %8s %9s %10s %10s %10s %10s\n", "Sweep", "Notes", "Events", "JSON KB", "Data KB", "Load ms", "Frame ms");
+		for (const SweepRow& row : rows) {
+			char load[16] = "-", frame[16] = "-";
+			if (row.load >= 0.0)
+				snprintf(load, sizeof(load), "%.2f", row.load * 1e3);
+			if (row.frame >= 0.0)
+				snprintf(frame, sizeof(frame), "%.2f", row.frame * 1e3);
+			printf("%-18s %8d %9zu %10zu %10zu %10s %10s\n", row.name.c_str(), row.notes, row.events,
+				row.jsonBytes / 1024, row.dataBytes / 1024, load, frame);
+		}
+	}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "PGR/Bench/Benchmark.h"
+#include "PGR/Chart/Chart.h"
+#include "PGR/Chart/ChartGenerator.h"
+
+namespace PGR {
+
+	// Bytes a loaded chart holds on to: lines with their events and notes,
+	// the baked hit effects and the hitsounds.
+	size_t GetChartDataBytes(const ChartData& data);
+
+	// Moves synthetic charts away from `base` one dimension at a time (lines,
+	// notes per line, each event type's density, hold and chord ratio, speed
+	// pattern) and times the load and the frames of each. Results are named
+	// Sweep/<dimension>=<value>/Load and .../Frames (16 frames across the
+	// chart per iteration), with note, event and size counters; a table of
+	// all points, with the time per frame, follows. `c` must hold a packed skin.
+	void RunStressSweep(BenchRunner& runner, C& c, const StressChartConfig& base, int width, int height);
+
+}
@@ -0,0 +1,34 @@
+#include "Chart.h"
+
+namespace PGR {
+
+	float linear(float t, float st, float et, float sv, float ev) {
+		return sv + (t - st) / (et - st) * (ev - sv);
+	}
+
+	Vec2 rotatePoint(float x, float y, float r, float deg) {
+		return Vec2(
+			x + r * cos(deg * PI / 180.0f),
+			y + r * sin(deg * PI / 180.0f)
+		);
+	}
+
+	float getPosYEvent(float t, const std::vector<JudgeLineMoveEvent>& es) {
+		const int i = findEvent(t, es);
+		if (i == -1)
+			return 0.0f;
+		const JudgeLineMoveEvent& e = es[i];
+
+		return linear(t, e.startTime, e.endTime, e.start2, e.end2);
+	}
+
+	float getSpeedValue(float t, const std::vector<SpeedEvent>& es) {
+		const int i = findEvent(t, es);
+		if (i == -1)
+			return 0.0f;
+		const SpeedEvent& e = es[i];
+
+		return e.value;
+	}
+
+}
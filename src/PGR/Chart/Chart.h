@@ -0,0 +1,312 @@
+#pragma once
+
+#include "PGR/Base/Maths.h"
+#include "PGR/Renderer/Texture.h"
+#include "PGR/Renderer/Atlas.h"
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+#include "cJSON/cJSON.h"
+
+namespace PGR {
+
+	constexpr float pgrw = 0.05625f;
+	constexpr float pgrh = 0.6f;
+	constexpr float pgrbeat = 60.0f / 32.0f;
+
+	constexpr float linew = 0.0075f;
+	constexpr float lineh = 5.76f;
+	constexpr Vec3 pcolor = Vec3((float)0xff / 0xff, (float)0xec / 0xff, (float)0x9f / 0xff);
+	constexpr float palpha = (float)0xe1 / 0xff;
+
+	constexpr float noteSize = 0.1134375f;
+	constexpr float effectDur = 0.5f;
+
+	struct NoteImgs {
+		Texture* click = new Texture("click.png");
+		Texture* drag = new Texture("drag.png");
+		Texture* hold = new Texture("hold.png");
+		Texture* flick = new Texture("flick.png");
+
+		Texture* holdBody = nullptr;
+		Texture* holdHead = nullptr;
+		Texture* holdTail = nullptr;
+
+		Texture* clickMH = new Texture("clickMH.png");
+		Texture* dragMH = new Texture("dragMH.png");
+		Texture* holdMH = new Texture("holdMH.png");
+		Texture* flickMH = new Texture("flickMH.png");
+
+		Texture* holdMHBody = nullptr;
+		Texture* holdMHHead = nullptr;
+		Texture* holdMHTail = nullptr;
+
+		Texture* hitFx = new Texture("hitFx.png");
+	};
+
+	enum NoteType {
+		tap = 1,
+		drag,
+		hold,
+		flick
+	};
+
+	struct HitSounds {
+		int click = -1;
+		int drag = -1;
+		int flick = -1;
+
+		int Get(int type) const {
+			return type == NoteType::drag ? drag : type == NoteType::flick ? flick : click;
+		}
+	};
+
+	struct Respack {
+		Respack() = default;
+
+		Vec2 hitFx;
+		Vec2 holdAtlas;
+		Vec2 holdAtlasMH;
+	};
+
+	struct ChartInfo {
+		ChartInfo() = default;
+		std::wstring level;
+		std::wstring name;
+		std::wstring song;
+		std::wstring picture;
+		std::wstring chart;
+	};
+
+	struct JudgeLineMoveEvent {
+		JudgeLineMoveEvent() = default;
+		float startTime, endTime;
+		float start, end;
+		float start2, end2;
+	};
+
+	struct JudgeLineRotateEvent {
+		JudgeLineRotateEvent() = default;
+		float startTime, endTime;
+		float start, end;
+	};
+
+	struct JudgeLineDisappearEvent {
+		JudgeLineDisappearEvent() = default;
+		float startTime, endTime;
+		float start, end;
+	};
+
+	struct SpeedEvent {
+		SpeedEvent() = default;
+		float startTime, endTime;
+		float value;
+		float floorPosition;
+	};
+
+	float linear(float t, float st, float et, float sv, float ev);
+
+	Vec2 rotatePoint(float x, float y, float r, float deg);
+
+	struct EventsValue {
+		EventsValue() = default;
+		float rotate = 0.0f;
+		float x = 0.0f;
+		float y = 0.0f;
+		float alpha = 1.0f;
+		float speed = 0.0f;
+	};
+
+	struct Note {
+		Note() = default;
+		int type = 0;
+		float time = 0.0f;
+		float floorPosition = 0.0f;
+		float holdTime = 0.0f;
+		float speed = 0.0f;
+		float positionX = 0.0f;
+		bool isAbove = false;
+		float sect = 0.0f;
+		float secht = 0.0f;
+		float holdEndTime = 0.0f;
+		float holdLength = 0.0f;
+		bool isHold = false;
+		int morebets = false;
+		int line = 0;
+		Vec2 getclickEffect(float w, float h, EventsValue ev) {
+			Vec2 pos = rotatePoint(
+				ev.x * w, ev.y * h,
+				positionX * pgrw * w,
+				ev.rotate
+			);
+			return pos;
+		}
+	};
+
+	template<typename T>
+	int findEvent(float t, const std::vector<T>& es) {
+		size_t l = 0; size_t r = es.size() - 1;
+		while (l <= r) {
+			size_t m = (l + r) / 2;
+			const T& e = es[m];
+
+			if (e.startTime <= t && t <= e.endTime)
+				return (int)m;
+			else if (t < e.startTime)
+				r = m - 1;
+			else
+				l = m + 1;
+		}
+		return -1;
+	}
+	template<typename T>
+	float getEventValue(float t, const std::vector<T>& es) {
+		const int i = findEvent(t, es);
+		if (i == -1)
+			return 0.0f;
+
+		const T& e = es[i];
+
+		return linear(t, e.startTime, e.endTime, e.start, e.end);
+	}
+
+	float getPosYEvent(float t, const std::vector<JudgeLineMoveEvent>& es);
+
+	float getSpeedValue(float t, const std::vector<SpeedEvent>& es);
+
+	// Everything a hit effect needs per frame, baked at load time. The line
+	// state at the hit time never changes, so only the camera transform and
+	// the particle animation are left for Render. Particles are derived from
+	// the chart seed and the effect's index in clickEffectCollection.
+	struct HitEffect {
+		HitEffect() = default;
+		HitEffect(float sect, const EventsValue& ev, float positionX)
+			: sect(sect), x(ev.x), y(ev.y), positionX(positionX) {
+			cosRotate = cos(ev.rotate * PI / 180.0f);
+			sinRotate = sin(ev.rotate * PI / 180.0f);
+		}
+		float sect = 0.0f;
+		float x = 0.0f, y = 0.0f;
+		float cosRotate = 1.0f, sinRotate = 0.0f;
+		float positionX = 0.0f;
+	};
+
+	struct HitsoundEvent {
+		float time = 0.0f;
+		int type = 0;
+	};
+
+
+	struct JudgeLine {
+		JudgeLine() = default;
+
+		float bpm = 0.0f;
+		std::vector<JudgeLineMoveEvent> moveEvents;
+		std::vector<JudgeLineRotateEvent> rotateEvents;
+		std::vector<JudgeLineDisappearEvent> disappearEvents;
+		std::vector<SpeedEvent> speedEvents;
+
+		std::vector<Note> notesAbove;
+		std::vector<Note> notesBelow;
+
+		std::vector<Note> notes;
+
+		float sec2beat(float t) const {
+			return t / (pgrbeat / bpm);
+		}
+
+		float beat2sec(float t) const {
+			return t * (pgrbeat / bpm);
+		}
+
+		void initSpeedEvents() {
+			float fp = 0.0f;
+
+			for (auto& e : speedEvents) {
+				e.floorPosition = fp;
+				fp += (e.endTime - e.startTime) * e.value;
+			}
+		}
+
+		void mergeNotes() {
+			for (auto& n : notesAbove) {
+				n.isAbove = true;
+				this->notes.push_back(n);
+			}
+			for (auto& n : notesBelow) {
+				n.isAbove = false;
+				this->notes.push_back(n);
+			}
+		}
+
+		float getFp(float t) const {
+			int i = findEvent(t, speedEvents);
+			if (i == -1)
+				return 0.0f;
+
+			SpeedEvent e = speedEvents[i];
+			return e.floorPosition + (t - e.startTime) * e.value;
+		}
+
+		void initNoteFp() {
+			for (auto& n : notes)
+				n.floorPosition = getFp(n.time);
+		}
+
+		EventsValue getState(float t) const {
+			float beatt = sec2beat(t);
+			float rotate = getEventValue(beatt, rotateEvents);
+			float x = getEventValue(beatt, moveEvents);
+			float y = getPosYEvent(beatt, moveEvents);
+			float alpha = getEventValue(beatt, disappearEvents);
+			float speed = getSpeedValue(beatt, speedEvents);
+			return { rotate, x, y, alpha, speed };
+		}
+
+	};
+
+	struct ChartData {
+		std::vector<JudgeLine> judgeLines;
+		std::vector<HitEffect> clickEffectCollection;
+		// Every note's hitsound, sorted by time.
+		std::vector<HitsoundEvent> hitsounds;
+		int noteCount = 0;
+		uint32_t seed = 0;
+		float time = 0.0f;
+	};
+
+	struct Chart {
+		Chart() = default;
+
+		ChartInfo info;
+		Texture* image = nullptr;
+		Texture* blurImage = nullptr;
+		cJSON* json = nullptr;
+		ChartData data;
+		std::string path;
+		std::string wPath;
+
+	};
+
+	struct Camera {
+		Camera() = default;
+		Vec2 Pos = { 0.0f, 0.0f };
+		float size = 1.0f;
+	};
+
+	struct C {
+		NoteImgs noteImgs;
+		std::vector<Texture*> hitFxImgs;
+		HitSounds hitSounds;
+		Chart chart;
+		Texture* noteHeadImgs[4][2] = { 0 };
+		Texture* holdBodyImgs[2] = { 0 };
+		Texture* holdTailImgs[2] = { 0 };
+		Atlas* atlas = nullptr;
+		Camera camera;
+	};
+
+}
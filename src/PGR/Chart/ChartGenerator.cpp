@@ -0,0 +1,210 @@
+#include "ChartGenerator.h"
+#include "PGR/Chart/Chart.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "cJSON/cJSON.h"
+
+namespace PGR {
+
+	// Official charts open every event list long before the chart starts and
+	// close it long after it ends.
+	static constexpr double EventsStart = -999999.0;
+	static constexpr double EventsEnd = 1000000000.0;
+
+	// splitmix64: small, fast, and the same sequence on every platform,
+	// which std's distributions don't promise.
+	class ChartRandom {
+	public:
+		ChartRandom(uint64_t seed) : m_State(seed) {}
+
+		uint64_t Next() {
+			uint64_t z = (m_State += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);
+		}
+
+		// [a, b)
+		double Uniform(double a, double b) {
+			return a + (b - a) * (double)(Next() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		bool Chance(double p) { return Uniform(0.0, 1.0) < p; }
+
+	private:
+		uint64_t m_State;
+	};
+
+	const char* GetSpeedPatternName(SpeedPattern pattern) {
+		switch (pattern) {
+		case SpeedPattern::Ramp: return "ramp";
+		case SpeedPattern::Pulse: return "pulse";
+		case SpeedPattern::Negative: return "negative";
+		default: return "constant";
+		}
+	}
+
+	bool ParseSpeedPattern(const std::string& name, SpeedPattern& pattern) {
+		const SpeedPattern patterns[] = { SpeedPattern::Constant, SpeedPattern::Ramp, SpeedPattern::Pulse, SpeedPattern::Negative };
+		for (SpeedPattern p : patterns) {
+			if (name == GetSpeedPatternName(p)) {
+				pattern = p;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Boundaries of `count` back-to-back events: the first opens at
+	// `start`, the rest split the chart evenly, the last never closes.
+	// Not rounded to whole times: past one event per 1/32 beat that would
+	// give empty events, which interpolate to NaN.
+	static std::vector<double> GetEventBounds(int count, double start, double chartEnd) {
+		std::vector<double> bounds = { start };
+		for (int i = 1; i < count; i++)
+			bounds.push_back(chartEnd * i / count);
+		bounds.push_back(EventsEnd);
+		return bounds;
+	}
+
+	static int GetEventCount(float density, float duration) {
+		return std::max(1, (int)std::lround(density * duration));
+	}
+
+	static cJSON* AddEvent(cJSON* array, double startTime, double endTime) {
+		cJSON* event = cJSON_CreateObject();
+		cJSON_AddNumberToObject(event, "startTime", startTime);
+		cJSON_AddNumberToObject(event, "endTime", endTime);
+		cJSON_AddItemToArray(array, event);
+		return event;
+	}
+
+	// Values that drift by up to `step` per event within [lo, hi]. The
+	// events join up: each starts where the previous one ended, and the
+	// first and last hold still. Move events walk x and y independently.
+	static std::vector<double> GetWalk(int count, ChartRandom& random, double lo, double hi, double step) {
+		std::vector<double> values = { random.Uniform(lo, hi) };
+		for (int i = 1; i < count; i++)
+			values.push_back(std::clamp(values.back() + random.Uniform(-step, step), lo, hi));
+		return values;
+	}
+
+	static void AddWalkEvents(cJSON* array, int count, double chartEnd, ChartRandom& random,
+		double lo, double hi, double step, bool move = false) {
+		const std::vector<double> bounds = GetEventBounds(count, EventsStart, chartEnd);
+		const std::vector<double> values = GetWalk(count, random, lo, hi, step);
+		const std::vector<double> values2 = move ? GetWalk(count, random, lo, hi, step) : std::vector<double>();
+
+		for (int i = 0; i < count; i++) {
+			cJSON* event = AddEvent(array, bounds[i], bounds[i + 1]);
+			const int from = std::max(i - 1, 0);
+			const int to = i == 0 || i == count - 1 ? from : i;
+			cJSON_AddNumberToObject(event, "start", values[from]);
+			cJSON_AddNumberToObject(event, "end", values[to]);
+			if (move) {
+				cJSON_AddNumberToObject(event, "start2", values2[from]);
+				cJSON_AddNumberToObject(event, "end2", values2[to]);
+			}
+		}
+	}
+
+	static double GetSpeedValue(SpeedPattern pattern, int index, int count, ChartRandom& random) {
+		switch (pattern) {
+		case SpeedPattern::Ramp: {
+			const double phase = count > 1 ? (double)index / (count - 1) : 0.0;
+			return 0.5 + 2.5 * (1.0 - std::abs(2.0 * phase - 1.0));
+		}
+		case SpeedPattern::Pulse: {
+			const double r = random.Uniform(0.0, 1.0);
+			return r < 0.15 ? 4.0 : r < 0.25 ? 0.05 : 1.0;
+		}
+		case SpeedPattern::Negative:
+			return random.Uniform(-2.0, 2.0);
+		default:
+			return 1.0;
+		}
+	}
+
+	std::string GenerateStressChart(const StressChartConfig& config) {
+		ChartRandom random(config.seed);
+		// Chart times are in 1/32 beats.
+		const double secondsPerTime = pgrbeat / config.bpm;
+		const double chartEnd = std::round(config.duration / secondsPerTime);
+		// Notes keep a second clear at either end.
+		const double noteStart = std::min(1.0 / secondsPerTime, chartEnd * 0.25);
+		const double noteSpan = chartEnd - 2.0 * noteStart;
+		std::vector<double> noteTimes;
+
+		cJSON* root = cJSON_CreateObject();
+		cJSON_AddNumberToObject(root, "formatVersion", 3);
+		cJSON_AddNumberToObject(root, "offset", 0);
+		cJSON* lines = cJSON_AddArrayToObject(root, "judgeLineList");
+
+		for (int l = 0; l < config.lines; l++) {
+			cJSON* line = cJSON_CreateObject();
+			cJSON_AddItemToArray(lines, line);
+			cJSON_AddNumberToObject(line, "bpm", config.bpm);
+
+			// Speed events are steps from time 0, with floor positions in
+			// seconds, as official charts store them.
+			const int speedCount = GetEventCount(config.speedDensity, config.duration);
+			const std::vector<double> speedBounds = GetEventBounds(speedCount, 0.0, chartEnd);
+			std::vector<double> speeds, floorPositions;
+			double fp = 0.0;
+			cJSON* speedEvents = cJSON_AddArrayToObject(line, "speedEvents");
+			for (int i = 0; i < speedCount; i++) {
+				speeds.push_back(GetSpeedValue(config.speedPattern, i, speedCount, random));
+				floorPositions.push_back(fp);
+				cJSON* event = AddEvent(speedEvents, speedBounds[i], speedBounds[i + 1]);
+				cJSON_AddNumberToObject(event, "value", speeds[i]);
+				cJSON_AddNumberToObject(event, "floorPosition", fp);
+				fp += (speedBounds[i + 1] - speedBounds[i]) * secondsPerTime * speeds[i];
+			}
+			auto getSpeedIndex = [&](double t) {
+				return (int)(std::upper_bound(speedBounds.begin() + 1, speedBounds.end() - 1, t) - speedBounds.begin() - 1);
+			};
+
+			cJSON* notesAbove = cJSON_AddArrayToObject(line, "notesAbove");
+			cJSON* notesBelow = cJSON_AddArrayToObject(line, "notesBelow");
+			for (int i = 0; i < config.notesPerLine; i++) {
+				double time = noteStart + noteSpan * (i + random.Uniform(0.0, 1.0)) / config.notesPerLine;
+				if (!noteTimes.empty() && random.Chance(config.chordRatio))
+					time = noteTimes[random.Next() % noteTimes.size()];
+				time = std::round(time);
+				noteTimes.push_back(time);
+
+				const bool hold = random.Chance(config.holdRatio);
+				const double r = random.Uniform(0.0, 1.0);
+				const int type = hold ? 3 : r < 0.5 ? 1 : r < 0.75 ? 2 : 4;
+				const int s = getSpeedIndex(time);
+
+				cJSON* note = cJSON_CreateObject();
+				cJSON_AddNumberToObject(note, "type", type);
+				cJSON_AddNumberToObject(note, "time", time);
+				cJSON_AddNumberToObject(note, "positionX", std::round(random.Uniform(-4.0, 4.0) * 1000.0) / 1000.0);
+				cJSON_AddNumberToObject(note, "holdTime", hold ? std::round(random.Uniform(0.25, 2.0) / secondsPerTime) : 0.0);
+				// A hold's body is drawn at its own speed, kept positive here.
+				cJSON_AddNumberToObject(note, "speed", hold ? std::max(std::abs(speeds[s]), 0.25) : 1.0);
+				cJSON_AddNumberToObject(note, "floorPosition", floorPositions[s] + (time - speedBounds[s]) * secondsPerTime * speeds[s]);
+				cJSON_AddItemToArray(random.Chance(0.8) ? notesAbove : notesBelow, note);
+			}
+
+			AddWalkEvents(cJSON_AddArrayToObject(line, "judgeLineDisappearEvents"),
+				GetEventCount(config.alphaDensity, config.duration), chartEnd, random, 0.2, 1.0, 0.4);
+			AddWalkEvents(cJSON_AddArrayToObject(line, "judgeLineMoveEvents"),
+				GetEventCount(config.moveDensity, config.duration), chartEnd, random, 0.05, 0.95, 0.2, true);
+			AddWalkEvents(cJSON_AddArrayToObject(line, "judgeLineRotateEvents"),
+				GetEventCount(config.rotateDensity, config.duration), chartEnd, random, -180.0, 180.0, 30.0);
+		}
+
+		char* text = cJSON_PrintUnformatted(root);
+		cJSON_Delete(root);
+		std::string json = text;
+		cJSON_free(text);
+		return json;
+	}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace PGR {
+
+	// How a line's speed events change over the chart.
+	enum class SpeedPattern {
+		Constant,	// 1.0 throughout
+		Ramp,		// sweeps between 0.5 and 3.0 and back
+		Pulse,		// mostly 1.0 with short 4x bursts and near stops
+		Negative	// random in [-2, 2]: notes run backwards part of the time
+	};
+
+	const char* GetSpeedPatternName(SpeedPattern pattern);
+	bool ParseSpeedPattern(const std::string& name, SpeedPattern& pattern);
+
+	// A synthetic chart for scaling studies. Densities are events per second
+	// of chart, per line and per event type.
+	struct StressChartConfig {
+		int lines = 4;
+		int notesPerLine = 100;
+		float duration = 120.0f;
+		float bpm = 120.0f;
+		float moveDensity = 0.5f;
+		float rotateDensity = 0.5f;
+		float alphaDensity = 0.5f;
+		float speedDensity = 0.25f;
+		// Share of notes that are holds.
+		float holdRatio = 0.1f;
+		// Share of notes placed at the time of an earlier note, on any line:
+		// chords, drawn with the simultaneous-hit highlight.
+		float chordRatio = 0.1f;
+		SpeedPattern speedPattern = SpeedPattern::Constant;
+		uint32_t seed = 1;
+	};
+
+	// Official-format (formatVersion 3) chart JSON. Every line has at least one
+	// event of each type, and together they cover all time from the chart's
+	// start on, as in official charts. The same config always gives the same text.
+	std::string GenerateStressChart(const StressChartConfig& config);
+
+}
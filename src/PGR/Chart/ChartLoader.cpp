@@ -0,0 +1,295 @@
+#include "ChartLoader.h"
+#include "PGR/Base/Trace.h"
+
+#include <map>
+#include <algorithm>
+
+#include "cJSON/cJSON.h"
+
+namespace PGR {
+
+	bool ParseRespack(const std::string& json, Respack& respack) {
+		cJSON* root = cJSON_Parse(json.c_str());
+		if (!root)
+			return false;
+
+		cJSON* array = cJSON_GetObjectItem(root, "hitFX");
+		respack.hitFx.X = (float)cJSON_GetArrayItem(array, 0)->valueint;
+		respack.hitFx.Y = (float)cJSON_GetArrayItem(array, 1)->valueint;
+
+		array = cJSON_GetObjectItem(root, "holdAtlas");
+		respack.holdAtlas.X = (float)cJSON_GetArrayItem(array, 0)->valueint;
+		respack.holdAtlas.Y = (float)cJSON_GetArrayItem(array, 1)->valueint;
+
+		array = cJSON_GetObjectItem(root, "holdAtlasMH");
+		respack.holdAtlasMH.X = (float)cJSON_GetArrayItem(array, 0)->valueint;
+		respack.holdAtlasMH.Y = (float)cJSON_GetArrayItem(array, 1)->valueint;
+
+		cJSON_Delete(root);
+		return true;
+	}
+
+	bool LoadChartData(const std::string& json, ChartData& data) {
+		cJSON* root;
+		{
+			PGR_TRACE_SCOPE("Parse chart", "load");
+			root = cJSON_Parse(json.c_str());
+		}
+		if (!root || !cJSON_GetObjectItem(root, "judgeLineList")) {
+			cJSON_Delete(root);
+			return false;
+		}
+
+		// FNV-1a of the chart text: the same chart always gets the same particles.
+		data.seed = 2166136261U;
+		for (unsigned char c : json)
+			data.seed = (data.seed ^ c) * 16777619U;
+
+		std::map<float, int> noteSectCounter;
+
+		cJSON* arrayExt = cJSON_GetObjectItem(root, "judgeLineList");
+
+		// Arrays are walked as the linked lists they are; indexing one is linear.
+		int i = 0;
+		for (cJSON* line = arrayExt->child; line; line = line->next, i++) {
+			PGR_TRACE_SCOPE_ARG("Convert line", "load", i);
+			JudgeLine jline;
+			jline.bpm = (float)cJSON_GetObjectItem(line, "bpm")->valuedouble;
+			cJSON* arrayInt = cJSON_GetObjectItem(line, "judgeLineMoveEvents");
+			for (cJSON* obj = arrayInt ? arrayInt->child : nullptr; obj; obj = obj->next) {
+				JudgeLineMoveEvent e;
+				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
+				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
+				e.start = (float)cJSON_GetObjectItem(obj, "start")->valuedouble;
+				e.end = (float)cJSON_GetObjectItem(obj, "end")->valuedouble;
+				e.start2 = (float)cJSON_GetObjectItem(obj, "start2")->valuedouble;
+				e.end2 = (float)cJSON_GetObjectItem(obj, "end2")->valuedouble;
+				jline.moveEvents.push_back(e);
+				float t = !obj->next ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
+				if (t > data.time) {
+					data.time = t;
+				}
+			}
+			arrayInt = cJSON_GetObjectItem(line, "judgeLineRotateEvents");
+			for (cJSON* obj = arrayInt ? arrayInt->child : nullptr; obj; obj = obj->next) {
+				JudgeLineRotateEvent e;
+				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
+				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
+				e.start = (float)cJSON_GetObjectItem(obj, "start")->valuedouble;
+				e.end = (float)cJSON_GetObjectItem(obj, "end")->valuedouble;
+				jline.rotateEvents.push_back(e);
+				float t = !obj->next ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
+				if (t > data.time) {
+					data.time = t;
+				}
+			}
+			arrayInt = cJSON_GetObjectItem(line, "judgeLineDisappearEvents");
+			for (cJSON* obj = arrayInt ? arrayInt->child : nullptr; obj; obj = obj->next) {
+				JudgeLineDisappearEvent e;
+				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
+				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
+				e.start = (float)cJSON_GetObjectItem(obj, "start")->valuedouble;
+				e.end = (float)cJSON_GetObjectItem(obj, "end")->valuedouble;
+				jline.disappearEvents.push_back(e);
+				float t = !obj->next ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
+				if (t > data.time) {
+					data.time = t;
+				}
+			}
+			arrayInt = cJSON_GetObjectItem(line, "speedEvents");
+			for (cJSON* obj = arrayInt ? arrayInt->child : nullptr; obj; obj = obj->next) {
+				SpeedEvent e;
+				e.startTime = (float)cJSON_GetObjectItem(obj, "startTime")->valuedouble;
+				e.endTime = (float)cJSON_GetObjectItem(obj, "endTime")->valuedouble;
+				e.value = (float)cJSON_GetObjectItem(obj, "value")->valuedouble;
+				jline.speedEvents.push_back(e);
+				float t = !obj->next ? jline.beat2sec(e.startTime) : jline.beat2sec(e.endTime);
+				if (t > data.time) {
+					data.time = t;
+				}
+			}
+			arrayInt = cJSON_GetObjectItem(line, "notesAbove");
+			for (cJSON* obj = arrayInt ? arrayInt->child : nullptr; obj; obj = obj->next) {
+				Note n;
+				n.type = (int)cJSON_GetObjectItem(obj, "type")->valueint;
+				n.time = (float)cJSON_GetObjectItem(obj, "time")->valuedouble;
+				n.floorPosition = (float)cJSON_GetObjectItem(obj, "floorPosition")->valuedouble;
+				n.holdTime = (float)cJSON_GetObjectItem(obj, "holdTime")->valuedouble;
+				n.speed = (float)cJSON_GetObjectItem(obj, "speed")->valuedouble;
+				n.positionX = (float)cJSON_GetObjectItem(obj, "positionX")->valuedouble;
+				jline.notesAbove.push_back(n);
+				float t = n.type != 3 ? jline.beat2sec(n.time) : jline.beat2sec(n.holdTime);
+				if (t > data.time) {
+					data.time = t;
+				}
+			}
+			arrayInt = cJSON_GetObjectItem(line, "notesBelow");
+			for (cJSON* obj = arrayInt ? arrayInt->child : nullptr; obj; obj = obj->next) {
+				Note n;
+				n.type = (int)cJSON_GetObjectItem(obj, "type")->valueint;
+				n.time = (float)cJSON_GetObjectItem(obj, "time")->valuedouble;
+				n.floorPosition = (float)cJSON_GetObjectItem(obj, "floorPosition")->valuedouble;
+				n.holdTime = (float)cJSON_GetObjectItem(obj, "holdTime")->valuedouble;
+				n.speed = (float)cJSON_GetObjectItem(obj, "speed")->valuedouble;
+				n.positionX = (float)cJSON_GetObjectItem(obj, "positionX")->valuedouble;
+				jline.notesBelow.push_back(n);
+				float t = n.type != 3 ? jline.beat2sec(n.time) : jline.beat2sec(n.holdTime);
+				if (t > data.time) {
+					data.time = t;
+				}
+			}
+
+			{
+				PGR_TRACE_SCOPE("Sort line", "load");
+				std::sort(jline.notesAbove.begin(), jline.notesAbove.end(), [](Note a, Note b) { return a.time < b.time; });
+				std::sort(jline.notesBelow.begin(), jline.notesBelow.end(), [](Note a, Note b) { return a.time < b.time; });
+				std::sort(jline.speedEvents.begin(), jline.speedEvents.end(), [](SpeedEvent a, SpeedEvent b) { return a.startTime < b.startTime; });
+				std::sort(jline.moveEvents.begin(), jline.moveEvents.end(), [](JudgeLineMoveEvent a, JudgeLineMoveEvent b) { return a.startTime < b.startTime; });
+				std::sort(jline.rotateEvents.begin(), jline.rotateEvents.end(), [](JudgeLineRotateEvent a, JudgeLineRotateEvent b) { return a.startTime < b.startTime; });
+				std::sort(jline.disappearEvents.begin(), jline.disappearEvents.end(), [](JudgeLineDisappearEvent a, JudgeLineDisappearEvent b) { return a.startTime < b.startTime; });
+			}
+
+			{
+				PGR_TRACE_SCOPE("Prepare line", "load");
+				jline.initSpeedEvents();
+				jline.mergeNotes();
+				jline.initNoteFp();
+			}
+
+			for (auto& n : jline.notes) {
+				n.sect = jline.beat2sec(n.time);
+				n.secht = jline.beat2sec(n.holdTime);
+				n.holdEndTime = n.sect + n.secht;
+				n.holdLength = n.secht * n.speed * pgrh;
+				n.isHold = n.type == 3;
+				n.line = i;
+				if (noteSectCounter.find(n.sect) == noteSectCounter.end()) {
+					noteSectCounter[n.sect] = 0;
+				}
+
+				noteSectCounter[n.sect]++;
+
+			}
+
+			jline.notesAbove.clear();
+			jline.notesBelow.clear();
+
+			data.judgeLines.push_back(jline);
+
+			data.noteCount += (int)jline.notes.size();
+
+		}
+
+		{
+			PGR_TRACE_SCOPE("Generate effects", "load");
+			for (auto& line : data.judgeLines) {
+				for (auto& n : line.notes) {
+					n.morebets = noteSectCounter[n.sect] > 1;
+					data.hitsounds.push_back({ n.sect, n.type });
+					data.clickEffectCollection.push_back(HitEffect(n.sect, line.getState(n.sect), n.positionX));
+					if (n.isHold) {
+						float dt = 30 / line.bpm;
+						float st = n.sect + dt;
+						while (st < n.holdEndTime) {
+							data.clickEffectCollection.push_back(HitEffect(st, line.getState(st), n.positionX));
+							st += dt;
+						}
+					}
+				}
+			}
+		}
+
+		{
+			PGR_TRACE_SCOPE("Sort effects", "load");
+			std::stable_sort(
+				data.clickEffectCollection.begin(),
+				data.clickEffectCollection.end(),
+				[](const HitEffect& a, const HitEffect& b) { return a.sect < b.sect; }
+			);
+
+			std::stable_sort(
+				data.hitsounds.begin(),
+				data.hitsounds.end(),
+				[](const HitsoundEvent& a, const HitsoundEvent& b) { return a.time < b.time; }
+			);
+		}
+
+		cJSON_Delete(root);
+		return true;
+	}
+
+	void ClipHoldImgs(C& c, const Respack& respack) {
+		Texture* hold = c.noteImgs.hold;
+		c.noteImgs.holdHead = hold->ClipImg(0, (int)respack.holdAtlas.X);
+		c.noteImgs.holdBody = hold->ClipImg((int)respack.holdAtlas.X, hold->GetHeight() - (int)respack.holdAtlas.Y);
+		c.noteImgs.holdTail = hold->ClipImg(hold->GetHeight() - (int)respack.holdAtlas.Y, hold->GetHeight());
+
+		Texture* holdMH = c.noteImgs.holdMH;
+		c.noteImgs.holdMHHead = holdMH->ClipImg(0, (int)respack.holdAtlasMH.X);
+		c.noteImgs.holdMHBody = holdMH->ClipImg((int)respack.holdAtlasMH.X, holdMH->GetHeight() - (int)respack.holdAtlasMH.Y);
+		c.noteImgs.holdMHTail = holdMH->ClipImg(holdMH->GetHeight() - (int)respack.holdAtlasMH.Y, holdMH->GetHeight());
+	}
+
+	size_t ClipHitFxImgs(C& c, const Respack& respack) {
+		size_t fxBytes = 0;
+		for (int j = (int)respack.hitFx.Y - 1; j >= 0; j--) {
+			for (int i = 0; i < (int)respack.hitFx.X; i++) {
+				PGR_TRACE_SCOPE_ARG("Clip hitFX frame", "load", c.hitFxImgs.size());
+				c.hitFxImgs.push_back(
+					c.noteImgs.hitFx->ClipBlockImg(
+						(int)((i / respack.hitFx.X) * c.noteImgs.hitFx->GetWidth()),
+						(int)((j / respack.hitFx.Y) * c.noteImgs.hitFx->GetHeight()),
+						(int)(((i + 1) / respack.hitFx.X) * c.noteImgs.hitFx->GetWidth()),
+						(int)(((j + 1) / respack.hitFx.Y) * c.noteImgs.hitFx->GetHeight())
+					)
+				);
+				fxBytes += (size_t)c.hitFxImgs.back()->GetWidth() * c.hitFxImgs.back()->GetHeight() * sizeof(Vec4);
+			}
+		}
+		return fxBytes;
+	}
+
+	void PackSkin(C& c, bool atlas) {
+		// The full hold and hitFX sheets were only needed for clipping.
+		delete c.noteImgs.hold;
+		delete c.noteImgs.holdMH;
+		delete c.noteImgs.hitFx;
+		c.noteImgs.hold = nullptr;
+		c.noteImgs.holdMH = nullptr;
+		c.noteImgs.hitFx = nullptr;
+
+		if (atlas) {
+			c.atlas = new Atlas();
+			c.atlas->Add(&c.noteImgs.click);
+			c.atlas->Add(&c.noteImgs.drag);
+			c.atlas->Add(&c.noteImgs.flick);
+			c.atlas->Add(&c.noteImgs.holdHead);
+			c.atlas->Add(&c.noteImgs.holdBody);
+			c.atlas->Add(&c.noteImgs.holdTail);
+			c.atlas->Add(&c.noteImgs.clickMH);
+			c.atlas->Add(&c.noteImgs.dragMH);
+			c.atlas->Add(&c.noteImgs.flickMH);
+			c.atlas->Add(&c.noteImgs.holdMHHead);
+			c.atlas->Add(&c.noteImgs.holdMHBody);
+			c.atlas->Add(&c.noteImgs.holdMHTail);
+			for (auto& img : c.hitFxImgs)
+				c.atlas->Add(&img);
+			c.atlas->Pack();
+		}
+
+		c.holdBodyImgs[0] = c.noteImgs.holdBody;
+		c.holdBodyImgs[1] = c.noteImgs.holdMHBody;
+		c.holdTailImgs[0] = c.noteImgs.holdTail;
+		c.holdTailImgs[1] = c.noteImgs.holdMHTail;
+
+		c.noteHeadImgs[0][0] = c.noteImgs.click;
+		c.noteHeadImgs[0][1] = c.noteImgs.clickMH;
+		c.noteHeadImgs[1][0] = c.noteImgs.drag;
+		c.noteHeadImgs[1][1] = c.noteImgs.dragMH;
+		c.noteHeadImgs[2][0] = c.noteImgs.holdHead;
+		c.noteHeadImgs[2][1] = c.noteImgs.holdMHHead;
+		c.noteHeadImgs[3][0] = c.noteImgs.flick;
+		c.noteHeadImgs[3][1] = c.noteImgs.flickMH;
+	}
+
+}
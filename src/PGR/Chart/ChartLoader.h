@@ -0,0 +1,24 @@
+#pragma once
+#include "PGR/Chart/Chart.h"
+
+#include <string>
+
+namespace PGR {
+
+	// respack.json: the hitFX sheet's grid and the hold sheets' head and tail lengths.
+	bool ParseRespack(const std::string& json, Respack& respack);
+
+	// Converts official-format chart JSON into `data`: lines with their
+	// events and notes sorted and merged, note times and floor positions,
+	// hitsounds, and the baked hit effects. `data` should be empty.
+	bool LoadChartData(const std::string& json, ChartData& data);
+
+	// The skin, as the renderer draws it: hold sheets cut into head, body and
+	// tail, the hitFX sheet into frames (returning their size in bytes), and
+	// everything packed into an atlas with the lookup tables filled in.
+	// Without `atlas` every texture keeps its own buffer, for comparison.
+	void ClipHoldImgs(C& c, const Respack& respack);
+	size_t ClipHitFxImgs(C& c, const Respack& respack);
+	void PackSkin(C& c, bool atlas = true);
+
+}
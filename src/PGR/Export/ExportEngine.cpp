@@ -0,0 +1,194 @@
+#include "ExportEngine.h"
+#include "PGR/Export/Segment.h"
+#include "PGR/Renderer/ChartRenderer.h"
+#include "PGR/Base/Trace.h"
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <condition_variable>
+
+namespace PGR {
+
+	using Clock = std::chrono::steady_clock;
+
+	static double Seconds(Clock::time_point from, Clock::time_point to) {
+		return std::chrono::duration<double>(to - from).count();
+	}
+
+	bool ExportFrames(
+		const C& c,
+		const Camera& camera,
+		FrameWriter& writer,
+		const ExportSettings& settings,
+		ExportStats* stats
+	) {
+		const Clock::time_point start = Clock::now();
+
+		const int frames = settings.frames;
+		const int threads = std::max(1, std::min(settings.threads, std::max(frames, 1)));
+		const int slots = std::max(threads, settings.slots > 0 ? settings.slots : threads * 2);
+		const size_t frameSize = writer.GetFrameSize();
+
+		// Formats like QOI are encoded by the workers, and the slots hold files.
+		const bool encode = writer.EncodesFrames();
+		// Slot i % slots holds frame i between its render and its write.
+		std::vector<std::vector<unsigned char>> buffers(slots, std::vector<unsigned char>(frameSize));
+		std::vector<char> ready(slots, 0);
+		std::vector<char> repeat(slots, 0);
+		// The last rendered frame, for repeats; swapped with its slot's buffer.
+		std::vector<unsigned char> last(frameSize);
+
+		std::mutex mutex;
+		std::condition_variable slotFree, slotReady;
+		int next = 0;
+		int written = 0;
+		bool failed = false;
+
+		ExportStats total;
+		if (settings.hashFrames)
+			total.frameHashes.resize(frames);
+
+		auto worker = [&]() {
+			Trace::SetThreadName("Export worker");
+			Framebuffer* framebuffer = Framebuffer::Create(writer.GetWidth(), writer.GetHeight(), settings.framebufferFormat);
+			framebuffer->LoadFontTTF(settings.font);
+			ChartRenderer renderer(c);
+			// The RGB24 frame behind an encoded one, only for its hash.
+			std::vector<unsigned char> rgb;
+
+			double render = 0.0, convert = 0.0, stall = 0.0, keys = 0.0;
+			// This worker's last key, reused when it takes consecutive frames.
+			int keyFrame = -2;
+			uint64_t key = 0;
+			auto timeOf = [&](int frame) { return (float)((double)(settings.firstFrame + frame) / settings.fps); };
+			for (;;) {
+				int frame;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					const Clock::time_point waitStart = Clock::now();
+					slotFree.wait(lock, [&]() { return failed || next >= frames || next < written + slots; });
+					stall += Seconds(waitStart, Clock::now());
+					if (failed || next >= frames)
+						break;
+					frame = next++;
+				}
+
+				bool same = false;
+				if (settings.elideRepeats && frame > 0) {
+					PGR_TRACE_SCOPE_ARG("Frame key", "export", frame);
+					const Clock::time_point keyStart = Clock::now();
+					const uint64_t previous = keyFrame == frame - 1 ? key : renderer.GetFrameKey(writer.GetWidth(), writer.GetHeight(), timeOf(frame - 1), camera);
+					key = renderer.GetFrameKey(writer.GetWidth(), writer.GetHeight(), timeOf(frame), camera);
+					keyFrame = frame;
+					same = key == previous;
+					keys += Seconds(keyStart, Clock::now());
+				}
+
+				if (!same) {
+					PGR_TRACE_SCOPE_ARG("Frame", "export", frame);
+					const Clock::time_point renderStart = Clock::now();
+					framebuffer->Clear(Vec3(0.0f));
+					renderer.Render(framebuffer, timeOf(frame), camera);
+					const Clock::time_point convertStart = Clock::now();
+					std::vector<unsigned char>& buffer = buffers[frame % slots];
+					if (encode) {
+						writer.Encode(framebuffer, buffer);
+						// Hashes stay those of the RGB24 frame, as for the other image formats.
+						if (settings.hashFrames) {
+							rgb.resize(frameSize);
+							writer.Convert(framebuffer, rgb.data());
+							total.frameHashes[frame] = HashFrame(rgb.data(), frameSize);
+						}
+					}
+					else {
+						writer.Convert(framebuffer, buffer.data());
+						if (settings.hashFrames)
+							total.frameHashes[frame] = HashFrame(buffer.data(), frameSize);
+					}
+					const Clock::time_point convertEnd = Clock::now();
+					Trace::Complete(encode ? "Encode" : "Convert", "export", Trace::ToTime(convertStart), Trace::ToTime(convertEnd), frame);
+					render += Seconds(renderStart, convertStart);
+					convert += Seconds(convertStart, convertEnd);
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					ready[frame % slots] = 1;
+					repeat[frame % slots] = same;
+				}
+				slotReady.notify_one();
+			}
+
+			delete framebuffer;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			total.renderSeconds += render;
+			total.convertSeconds += convert;
+			total.stallSeconds += stall;
+		};
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i < threads; i++)
+			workers.emplace_back(worker);
+
+		bool ok = true;
+		while (written < frames) {
+			const int slot = written % slots;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				const Clock::time_point waitStart = Clock::now();
+				slotReady.wait(lock, [&]() { return ready[slot] != 0; });
+				total.waitSeconds += Seconds(waitStart, Clock::now());
+			}
+
+			// Nobody claims the frame that reuses this slot until `written` moves on.
+			PGR_TRACE_SCOPE_ARG("Write", "export", written);
+			const Clock::time_point writeStart = Clock::now();
+			if (repeat[slot]) {
+				ok = writer.WriteRepeat(last.data());
+				if (settings.hashFrames)
+					total.frameHashes[written] = total.frameHashes[written - 1];
+				total.elidedFrames++;
+			}
+			else if (encode)
+				ok = writer.WriteEncoded(buffers[slot]);
+			else {
+				ok = writer.WriteFrame(buffers[slot].data());
+				buffers[slot].swap(last);
+			}
+			total.writeSeconds += Seconds(writeStart, Clock::now());
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				ready[slot] = 0;
+				if (ok)
+					written++;
+				else
+					failed = true;
+			}
+			slotFree.notify_all();
+			if (!ok)
+				break;
+
+			if (settings.progressEvery > 0 && written % settings.progressEvery == 0)
+				printf("  %d / %d frames\n", written, frames);
+		}
+
+		for (std::thread& t : workers)
+			t.join();
+
+		if (stats) {
+			*stats = total;
+			stats->frames = written;
+			stats->threads = threads;
+			stats->slots = slots;
+			stats->wallSeconds = Seconds(start, Clock::now());
+		}
+		return ok;
+	}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "PGR/Chart/Chart.h"
+#include "PGR/Export/FrameWriter.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	struct ExportSettings {
+		// Renders frames [firstFrame, firstFrame + frames).
+		int firstFrame = 0;
+		int frames = 0;
+		int fps = 60;
+		int threads = 1;
+		// Converted frames held at once; 0 picks two per thread.
+		int slots = 0;
+		std::string font = "font.ttf";
+		// Print progress every this many frames, 0 for none.
+		int progressEvery = 0;
+		// Fill ExportStats::frameHashes with HashFrame() of every output frame.
+		bool hashFrames = false;
+		// Skip rendering frames whose ChartRenderer::GetFrameKey() matches the
+		// previous frame's, and write the previous output again.
+		bool elideRepeats = true;
+		FramebufferFormat framebufferFormat = FramebufferFormat::Float;
+	};
+
+	struct ExportStats {
+		int frames = 0;
+		int threads = 0;
+		int slots = 0;
+		double wallSeconds = 0.0;
+		// Summed over workers.
+		double renderSeconds = 0.0;
+		// Conversion, or the whole encode for formats the workers encode.
+		double convertSeconds = 0.0;
+		// Workers waiting for a free slot, i.e. for the output to catch up.
+		double stallSeconds = 0.0;
+		// Calling thread: writing, and waiting for the next frame in order.
+		double writeSeconds = 0.0;
+		double waitSeconds = 0.0;
+		// Frames written as repeats without rendering, and the time spent
+		// computing frame keys to find them (summed over workers).
+		int elidedFrames = 0;
+		double keySeconds = 0.0;
+		std::vector<uint64_t> frameHashes;
+	};
+
+	// Renders the frames of `settings` at t = i / fps and writes them in
+	// order. Each worker thread owns a ChartRenderer and a Framebuffer; the
+	// chart and its textures are shared read-only. Workers claim the next frame
+	// index, render it, convert (or, for QOI, encode) it into one of `slots`
+	// output buffers, and the calling thread writes the buffers back in frame
+	// order. A frame is only claimed once its buffer has been written, so
+	// memory stays at `slots` frames however far ahead fast workers get. A frame that draws the same
+	// as the one before it is only marked as a repeat, and the calling thread
+	// writes the previous output again. The first frame is always rendered,
+	// so a segment never depends on frames outside it. Returns false if the
+	// writer fails; the remaining workers stop at their next claim.
+	bool ExportFrames(
+		const C& c,
+		const Camera& camera,
+		FrameWriter& writer,
+		const ExportSettings& settings,
+		ExportStats* stats = nullptr
+	);
+
+}
@@ -0,0 +1,261 @@
+#include "FrameWriter.h"
+#include "PGR/Export/Qoi.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define dup _dup
+#define dup2 _dup2
+#define fileno _fileno
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#include <csignal>
+#endif
+
+namespace PGR {
+
+	bool ParseFrameFormat(const std::string& name, FrameFormat& format) {
+		if (name == "y4m")
+			format = FrameFormat::Y4M;
+		else if (name == "rgb24" || name == "rgb")
+			format = FrameFormat::RGB24;
+		else if (name == "bgr0" || name == "bgrx")
+			format = FrameFormat::BGRX;
+		else if (name == "png")
+			format = FrameFormat::PNG;
+		else if (name == "jpg" || name == "jpeg")
+			format = FrameFormat::JPG;
+		else if (name == "qoi")
+			format = FrameFormat::QOI;
+		else
+			return false;
+		return true;
+	}
+
+	const char* GetFrameFormatName(FrameFormat format) {
+		switch (format) {
+		case FrameFormat::Y4M: return "y4m";
+		case FrameFormat::RGB24: return "rgb24";
+		case FrameFormat::BGRX: return "bgr0";
+		case FrameFormat::PNG: return "png";
+		case FrameFormat::JPG: return "jpg";
+		case FrameFormat::QOI: return "qoi";
+		}
+		return "";
+	}
+
+	FrameWriter::~FrameWriter() {
+		Close();
+	}
+
+	bool FrameWriter::Open(const std::string& path, FrameFormat format, int width, int height, int fps, int encoders) {
+		Close();
+		if (width <= 0 || height <= 0 || fps <= 0)
+			return false;
+
+		if (IsImageFormat(format)) {
+			const ImageFormat image = format == FrameFormat::PNG ? ImageFormat::PNG : format == FrameFormat::JPG ? ImageFormat::JPG : ImageFormat::QOI;
+			if (path == "-" || !m_Images.Open(path, image, width, height, encoders))
+				return false;
+		}
+		else if (path == "-") {
+			fflush(stdout);
+			const int fd = dup(fileno(stdout));
+			if (fd < 0)
+				return false;
+			m_File = fdopen(fd, "wb");
+			if (!m_File)
+				return false;
+			dup2(fileno(stderr), fileno(stdout));
+#ifdef _WIN32
+			_setmode(fd, _O_BINARY);
+#else
+			// A closed pipe should fail the write, not kill the process.
+			signal(SIGPIPE, SIG_IGN);
+#endif
+		}
+		else {
+			m_File = fopen(path.c_str(), "wb");
+			if (!m_File)
+				return false;
+		}
+
+		m_Format = format;
+		m_Width = width;
+		m_Height = height;
+		m_Frames = 0;
+		m_Bytes = 0;
+
+		m_Frame.resize(GetFrameSize());
+		if (m_Format == FrameFormat::Y4M) {
+			// C420jpeg: chroma sited between the four luma samples it covers.
+			const int n = fprintf(m_File, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+			if (n < 0) {
+				Close();
+				return false;
+			}
+			m_Bytes += n;
+		}
+
+		return true;
+	}
+
+	bool FrameWriter::Close() {
+		bool ok = m_Images.Close();
+		if (m_File) {
+			ok = fclose(m_File) == 0 && ok;
+			m_File = nullptr;
+		}
+		return ok;
+	}
+
+	size_t FrameWriter::GetFrameSize() const {
+		if (m_Format == FrameFormat::Y4M)
+			return (size_t)m_Width * m_Height + 2 * (size_t)((m_Width + 1) / 2) * ((m_Height + 1) / 2);
+		if (m_Format == FrameFormat::BGRX)
+			return (size_t)m_Width * m_Height * 4;
+		return (size_t)m_Width * m_Height * 3;
+	}
+
+	bool FrameWriter::Write(const Framebuffer* framebuffer) {
+		if (!IsOpen() || framebuffer->GetWidth() != m_Width || framebuffer->GetHeight() != m_Height)
+			return false;
+		if (EncodesFrames()) {
+			Encode(framebuffer, m_Frame);
+			return WriteEncoded(m_Frame);
+		}
+		m_Frame.resize(GetFrameSize());
+		Convert(framebuffer, m_Frame.data());
+		return WriteFrame(m_Frame.data());
+	}
+
+	void FrameWriter::Convert(const Framebuffer* framebuffer, unsigned char* dst) const {
+		if (m_Format == FrameFormat::Y4M)
+			ConvertYuv420(framebuffer, dst);
+		else if (m_Format == FrameFormat::BGRX)
+			framebuffer->CopyToBGRX((uint32_t*)dst, m_Width, m_Width, m_Height);
+		else
+			ConvertRgb(framebuffer, dst);
+	}
+
+	bool FrameWriter::WriteFrame(const unsigned char* frame) {
+		if (IsImageFormat(m_Format)) {
+			if (!m_Images.Submit(m_FirstFrame + (int)m_Frames, frame))
+				return false;
+			m_Frames++;
+			return true;
+		}
+		if (!m_File)
+			return false;
+		if (m_Format == FrameFormat::Y4M) {
+			if (fputs("FRAME\n", m_File) < 0)
+				return false;
+			m_Bytes += 6;
+		}
+		const size_t size = GetFrameSize();
+		if (fwrite(frame, 1, size, m_File) != size)
+			return false;
+		m_Bytes += size;
+		m_Frames++;
+		return true;
+	}
+
+	void FrameWriter::Encode(const Framebuffer* framebuffer, std::vector<unsigned char>& dst) const {
+		dst.clear();
+		QoiEncode(framebuffer, dst);
+	}
+
+	bool FrameWriter::WriteEncoded(std::vector<unsigned char>& image) {
+		if (!EncodesFrames() || !m_Images.SubmitEncoded(m_FirstFrame + (int)m_Frames, image))
+			return false;
+		m_Frames++;
+		return true;
+	}
+
+	bool FrameWriter::WriteRepeat(const unsigned char* previous) {
+		if (IsImageFormat(m_Format)) {
+			if (!m_Images.Repeat(m_FirstFrame + (int)m_Frames))
+				return false;
+			m_Frames++;
+			return true;
+		}
+		return WriteFrame(previous);
+	}
+
+	// The framebuffer is bottom-up; both outputs are top-down.
+	void FrameWriter::ConvertRgb(const Framebuffer* framebuffer, unsigned char* dst) const {
+		if (framebuffer->GetFormat() == FramebufferFormat::BGRX8) {
+			for (int y = 0; y < m_Height; y++) {
+				const uint32_t* row = framebuffer->GetPixels() + (size_t)y * framebuffer->GetStride();
+				for (int x = 0; x < m_Width; x++) {
+					*dst++ = (unsigned char)(row[x] >> 16);
+					*dst++ = (unsigned char)(row[x] >> 8);
+					*dst++ = (unsigned char)row[x];
+				}
+			}
+			return;
+		}
+
+		const Vec3* colors = framebuffer->GetColorBuffer();
+		for (int y = 0; y < m_Height; y++) {
+			const Vec3* row = colors + (size_t)(m_Height - 1 - y) * m_Width;
+			for (int x = 0; x < m_Width; x++) {
+				*dst++ = ColorToByte(row[x].X);
+				*dst++ = ColorToByte(row[x].Y);
+				*dst++ = ColorToByte(row[x].Z);
+			}
+		}
+	}
+
+	void FrameWriter::ConvertYuv420(const Framebuffer* framebuffer, unsigned char* dst) const {
+		if (framebuffer->GetFormat() == FramebufferFormat::Float) {
+			ConvertYuv420(framebuffer->GetColorBuffer(), dst);
+			return;
+		}
+
+		// Back to bottom-up floats; Y4M from a BGRX8 framebuffer is a slow path.
+		thread_local std::vector<Vec3> colors;
+		colors.resize((size_t)m_Width * m_Height);
+		for (int y = 0; y < m_Height; y++) {
+			for (int x = 0; x < m_Width; x++)
+				colors[(size_t)y * m_Width + x] = framebuffer->GetColor(x, y);
+		}
+		ConvertYuv420(colors.data(), dst);
+	}
+
+	void FrameWriter::ConvertYuv420(const Vec3* colors, unsigned char* dst) const {
+		const int cw = (m_Width + 1) / 2;
+		const int ch = (m_Height + 1) / 2;
+		unsigned char* yPlane = dst;
+		unsigned char* uPlane = yPlane + (size_t)m_Width * m_Height;
+		unsigned char* vPlane = uPlane + (size_t)cw * ch;
+
+		for (int y = 0; y < m_Height; y++) {
+			const Vec3* row = colors + (size_t)(m_Height - 1 - y) * m_Width;
+			unsigned char* luma = yPlane + (size_t)y * m_Width;
+			for (int x = 0; x < m_Width; x++) {
+				const Vec3 c = Clamp(row[x], 0.0f, 1.0f);
+				luma[x] = (unsigned char)(16.0f + 219.0f * (0.299f * c.X + 0.587f * c.Y + 0.114f * c.Z) + 0.5f);
+			}
+		}
+
+		// Each chroma sample averages a 2x2 block; odd edges reuse the last row/column.
+		for (int y = 0; y < ch; y++) {
+			const int y0 = m_Height - 1 - 2 * y;
+			const int y1 = y0 > 0 ? y0 - 1 : y0;
+			const Vec3* row0 = colors + (size_t)y0 * m_Width;
+			const Vec3* row1 = colors + (size_t)y1 * m_Width;
+			for (int x = 0; x < cw; x++) {
+				const int x0 = 2 * x;
+				const int x1 = x0 + 1 < m_Width ? x0 + 1 : x0;
+				const Vec3 c = (Clamp(row0[x0], 0.0f, 1.0f) + Clamp(row0[x1], 0.0f, 1.0f) + Clamp(row1[x0], 0.0f, 1.0f) + Clamp(row1[x1], 0.0f, 1.0f)) * 0.25f;
+				const float u = -0.168736f * c.X - 0.331264f * c.Y + 0.5f * c.Z;
+				const float v = 0.5f * c.X - 0.418688f * c.Y - 0.081312f * c.Z;
+				uPlane[(size_t)y * cw + x] = (unsigned char)(128.0f + 224.0f * u + 0.5f);
+				vPlane[(size_t)y * cw + x] = (unsigned char)(128.0f + 224.0f * v + 0.5f);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "PGR/Window/Framebuffer.h"
+#include "PGR/Export/ImageSequenceWriter.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+namespace PGR {
+
+	enum class FrameFormat {
+		// YUV4MPEG2, 4:2:0, BT.601 limited range.
+		Y4M,
+		// Headerless top-down RGB24.
+		RGB24,
+		// Headerless top-down BGRX8 (`-pix_fmt bgr0`): a row copy from a BGRX8
+		// framebuffer, the SSE2 pack otherwise.
+		BGRX,
+		// Numbered image files, encoded on ImageSequenceWriter's pool.
+		PNG,
+		JPG,
+		QOI
+	};
+
+	// Parses "y4m" / "rgb24" / "bgr0" / "png" / "jpg" / "qoi"; returns false for anything else.
+	bool ParseFrameFormat(const std::string& name, FrameFormat& format);
+	const char* GetFrameFormatName(FrameFormat format);
+	inline bool IsImageFormat(FrameFormat format) { return format == FrameFormat::PNG || format == FrameFormat::JPG || format == FrameFormat::QOI; }
+
+	// Streams framebuffers to a file, or to stdout for "-", in a layout an
+	// external encoder reads directly (e.g. `ffmpeg -i - out.mp4` for Y4M, or
+	// `-f rawvideo -pix_fmt rgb24 -s WxH -r FPS -i -` for RGB24). For PNG/JPG/QOI
+	// the path is an ImageSequenceWriter pattern or directory instead, and
+	// frames are converted to RGB24 and handed to its encoder threads. QOI is
+	// the exception: it encodes straight from the framebuffer, about as fast
+	// as the conversion would be, so frames are encoded where they're rendered
+	// (Encode()) and the pool only writes the files.
+	class FrameWriter {
+	public:
+		FrameWriter() = default;
+		~FrameWriter();
+
+		// Writing to "-" keeps the real stdout for frames and points fd 1 at
+		// stderr, so nothing else printed afterwards can corrupt the stream.
+		bool Open(const std::string& path, FrameFormat format, int width, int height, int fps, int encoders = 1);
+		// Returns false if queued images failed to encode or write.
+		bool Close();
+
+		// Number of the first image file (image formats only).
+		void SetFirstFrame(int frame) { m_FirstFrame = frame; }
+
+		// The framebuffer must match the size given to Open(). Returns false
+		// once the output is gone (disk full, encoder exited).
+		bool Write(const Framebuffer* framebuffer);
+
+		// The two halves of Write(): Convert() only reads the writer's layout
+		// and may run on any thread; WriteFrame() takes GetFrameSize() bytes.
+		size_t GetFrameSize() const;
+		void Convert(const Framebuffer* framebuffer, unsigned char* dst) const;
+		bool WriteFrame(const unsigned char* frame);
+		// Writes the previous frame again. `previous` is its converted data,
+		// written out in full by formats with no way to mark a repeat; image
+		// sequences link the previous file instead.
+		bool WriteRepeat(const unsigned char* previous);
+
+		// Formats written with Encode() and WriteEncoded() instead of
+		// Convert() and WriteFrame(). Convert() still gives their RGB24.
+		bool EncodesFrames() const { return m_Format == FrameFormat::QOI; }
+		// The framebuffer as a complete image file; may run on any thread.
+		void Encode(const Framebuffer* framebuffer, std::vector<unsigned char>& dst) const;
+		// Takes Encode()'s output, swapping `image` with a recycled buffer.
+		bool WriteEncoded(std::vector<unsigned char>& image);
+
+		bool IsOpen() const { return m_File != nullptr || m_Images.IsOpen(); }
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+		uint64_t GetFrameCount() const { return m_Frames; }
+		uint64_t GetBytesWritten() const { return m_Bytes + m_Images.GetBytesWritten(); }
+		const ImageSequenceWriter& GetImages() const { return m_Images; }
+
+	private:
+		void ConvertRgb(const Framebuffer* framebuffer, unsigned char* dst) const;
+		void ConvertYuv420(const Framebuffer* framebuffer, unsigned char* dst) const;
+		void ConvertYuv420(const Vec3* colors, unsigned char* dst) const;
+
+	private:
+		FILE* m_File = nullptr;
+		FrameFormat m_Format = FrameFormat::Y4M;
+		int m_Width = 0;
+		int m_Height = 0;
+		uint64_t m_Frames = 0;
+		uint64_t m_Bytes = 0;
+		int m_FirstFrame = 0;
+		ImageSequenceWriter m_Images;
+		std::vector<unsigned char> m_Frame;
+	};
+
+}
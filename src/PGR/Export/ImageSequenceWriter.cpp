@@ -0,0 +1,236 @@
+#include "ImageSequenceWriter.h"
+#include "PGR/Export/Qoi.h"
+#include "PGR/Base/Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include <stb_image/stb_image_write.h>
+
+namespace PGR {
+
+	const char* GetImageExtension(ImageFormat format) {
+		switch (format) {
+		case ImageFormat::PNG: return "png";
+		case ImageFormat::JPG: return "jpg";
+		case ImageFormat::QOI: return "qoi";
+		}
+		return "";
+	}
+
+	ImageSequenceWriter::~ImageSequenceWriter() {
+		Close();
+	}
+
+	bool ImageSequenceWriter::Open(const std::string& pattern, ImageFormat format, int width, int height, int encoders, int quality) {
+		Close();
+		if (width <= 0 || height <= 0)
+			return false;
+
+		m_Pattern = pattern;
+		if (!m_Pattern.empty()) {
+			const bool directory = m_Pattern.find('%') == std::string::npos;
+			const std::filesystem::path dir = directory ? std::filesystem::path(m_Pattern) : std::filesystem::path(m_Pattern).parent_path();
+			std::error_code error;
+			if (!dir.empty())
+				std::filesystem::create_directories(dir, error);
+			if (error)
+				return false;
+			if (directory)
+				m_Pattern = (dir / (std::string("%06d.") + GetImageExtension(format))).string();
+		}
+
+		m_Format = format;
+		m_Width = width;
+		m_Height = height;
+		m_Quality = quality;
+		m_Quit = false;
+		m_Failed = false;
+		m_Images = 0;
+		m_Bytes = 0;
+		m_Repeats.clear();
+		m_RepeatCount = 0;
+		m_EncodeMicros = 0;
+		m_BlockedSeconds = 0.0;
+
+		encoders = encoders > 0 ? encoders : 1;
+		m_Buffers.assign((size_t)encoders * BuffersPerEncoder, std::vector<unsigned char>((size_t)width * height * 3));
+		m_Free.clear();
+		for (std::vector<unsigned char>& buffer : m_Buffers)
+			m_Free.push_back(&buffer);
+
+		for (int i = 0; i < encoders; i++)
+			m_Encoders.emplace_back(&ImageSequenceWriter::EncodeLoop, this);
+		return true;
+	}
+
+	bool ImageSequenceWriter::Close() {
+		if (m_Encoders.empty())
+			return true;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Quit = true;
+		}
+		m_Work.notify_all();
+		for (std::thread& t : m_Encoders)
+			t.join();
+		m_Encoders.clear();
+
+		// In order, so a repeat of a repeat finds its source already there.
+		for (int number : m_Repeats) {
+			const std::string path = GetPath(number), source = GetPath(number - 1);
+			std::error_code error;
+			std::filesystem::remove(path, error);
+			std::filesystem::create_hard_link(source, path, error);
+			if (error && !std::filesystem::copy_file(source, path, error))
+				m_Failed = true;
+		}
+		m_Repeats.clear();
+		m_Queue.clear();
+		m_Free.clear();
+		m_Buffers.clear();
+		return !m_Failed;
+	}
+
+	std::vector<unsigned char>* ImageSequenceWriter::AcquireBuffer() {
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_Free.empty()) {
+			const auto start = std::chrono::steady_clock::now();
+			m_Recycled.wait(lock, [&]() { return !m_Free.empty(); });
+			m_BlockedSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+		std::vector<unsigned char>* buffer = m_Free.back();
+		m_Free.pop_back();
+		return buffer;
+	}
+
+	bool ImageSequenceWriter::Submit(int number, const unsigned char* rgb) {
+		if (m_Encoders.empty() || m_Failed)
+			return false;
+
+		std::vector<unsigned char>* buffer = AcquireBuffer();
+		// A buffer that last held an encoded image may have any size.
+		buffer->resize((size_t)m_Width * m_Height * 3);
+		memcpy(buffer->data(), rgb, buffer->size());
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.push_back({ number, buffer, false });
+		}
+		m_Work.notify_one();
+		return true;
+	}
+
+	bool ImageSequenceWriter::SubmitEncoded(int number, std::vector<unsigned char>& image) {
+		if (m_Encoders.empty() || m_Failed)
+			return false;
+
+		std::vector<unsigned char>* buffer = AcquireBuffer();
+		buffer->swap(image);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.push_back({ number, buffer, true });
+		}
+		m_Work.notify_one();
+		return true;
+	}
+
+	bool ImageSequenceWriter::Repeat(int number) {
+		if (m_Encoders.empty() || m_Failed)
+			return false;
+		if (!m_Pattern.empty())
+			m_Repeats.push_back(number);
+		m_RepeatCount++;
+		return true;
+	}
+
+	std::string ImageSequenceWriter::GetPath(int number) const {
+		char path[1024];
+		snprintf(path, sizeof(path), m_Pattern.c_str(), number);
+		return path;
+	}
+
+	double ImageSequenceWriter::GetEncodeSeconds() const {
+		return m_EncodeMicros.load(std::memory_order_relaxed) / 1e6;
+	}
+
+	void ImageSequenceWriter::EncodeLoop() {
+		Trace::SetThreadName("Encoder");
+		for (;;) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Work.wait(lock, [&]() { return m_Quit || !m_Queue.empty(); });
+				// Drain the queue before quitting.
+				if (m_Queue.empty())
+					return;
+				job = m_Queue.front();
+				m_Queue.pop_front();
+			}
+
+			PGR_TRACE_SCOPE_ARG("Encode", "export", job.number);
+			const auto start = std::chrono::steady_clock::now();
+			if (!Encode(job))
+				m_Failed = true;
+			const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			m_EncodeMicros += (uint64_t)micros;
+			m_Images++;
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Free.push_back(job.buffer);
+			}
+			m_Recycled.notify_one();
+		}
+	}
+
+	struct EncodeTarget {
+		FILE* file;
+		uint64_t bytes;
+		bool failed;
+	};
+
+	static void WriteEncoded(void* context, void* data, int size) {
+		EncodeTarget* target = (EncodeTarget*)context;
+		target->bytes += size;
+		if (target->file && fwrite(data, 1, size, target->file) != (size_t)size)
+			target->failed = true;
+	}
+
+	bool ImageSequenceWriter::Encode(const Job& job) {
+		EncodeTarget target = { nullptr, 0, false };
+		if (!m_Pattern.empty()) {
+			// Unlink first: the old file may be a hard link left by Repeat().
+			const std::string path = GetPath(job.number);
+			remove(path.c_str());
+			target.file = fopen(path.c_str(), "wb");
+			if (!target.file)
+				return false;
+		}
+
+		const unsigned char* rgb = job.buffer->data();
+		int ok = 1;
+		if (job.encoded)
+			WriteEncoded(&target, job.buffer->data(), (int)job.buffer->size());
+		else if (m_Format == ImageFormat::PNG)
+			ok = stbi_write_png_to_func(WriteEncoded, &target, m_Width, m_Height, 3, rgb, m_Width * 3);
+		else if (m_Format == ImageFormat::JPG)
+			ok = stbi_write_jpg_to_func(WriteEncoded, &target, m_Width, m_Height, 3, rgb, m_Quality);
+		else {
+			// The encoder's own scratch buffer, reused across images.
+			thread_local std::vector<unsigned char> qoi;
+			qoi.clear();
+			QoiEncode(rgb, m_Width, m_Height, qoi);
+			WriteEncoded(&target, qoi.data(), (int)qoi.size());
+		}
+
+		if (target.file && fclose(target.file) != 0)
+			target.failed = true;
+		m_Bytes += target.bytes;
+		return ok && !target.failed;
+	}
+
+}
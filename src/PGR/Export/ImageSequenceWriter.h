@@ -0,0 +1,102 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+namespace PGR {
+
+	enum class ImageFormat {
+		PNG,
+		JPG,
+		QOI
+	};
+
+	const char* GetImageExtension(ImageFormat format);
+
+	// Writes numbered PNG/JPG/QOI files from top-down RGB24 frames on a pool of
+	// encoder threads. Submit() copies the frame into one of a fixed set of
+	// recycled buffers and queues it, so the caller never waits on compression,
+	// only on a free buffer when the encoders fall behind (back-pressure).
+	// SubmitEncoded() queues an image the caller already encoded; the pool
+	// then only writes it.
+	class ImageSequenceWriter {
+	public:
+		// Buffers per encoder thread: one being encoded, one queued.
+		static constexpr int BuffersPerEncoder = 2;
+
+		ImageSequenceWriter() = default;
+		~ImageSequenceWriter();
+
+		// `pattern` is a printf pattern for the frame number ("out/%06d.png");
+		// without a '%' it names a directory that gets 000000.png, ... An empty
+		// pattern encodes and drops the result, for benchmarks. Missing directories
+		// are created.
+		bool Open(const std::string& pattern, ImageFormat format, int width, int height, int encoders, int quality = 90);
+		// Waits for every queued image; false if any of them failed.
+		bool Close();
+
+		// Returns false once an image has failed to write.
+		bool Submit(int number, const unsigned char* rgb);
+		// The whole file's bytes, in this writer's format. `image` is swapped
+		// with a recycled buffer instead of copied, and comes back with any size.
+		bool SubmitEncoded(int number, std::vector<unsigned char>& image);
+		// Image `number` is the same as `number - 1`: it becomes a hard link
+		// (or a copy) of it at Close(), once the encoders are done.
+		bool Repeat(int number);
+
+		bool IsOpen() const { return !m_Encoders.empty(); }
+		int GetEncoderCount() const { return (int)m_Encoders.size(); }
+		uint64_t GetImageCount() const { return m_Images.load(std::memory_order_relaxed); }
+		uint64_t GetRepeatCount() const { return m_RepeatCount; }
+		uint64_t GetBytesWritten() const { return m_Bytes.load(std::memory_order_relaxed); }
+		// Summed over encoders; for pre-encoded images, only the writing.
+		double GetEncodeSeconds() const;
+		// Time Submit() spent waiting for a free buffer.
+		double GetBlockedSeconds() const { return m_BlockedSeconds; }
+
+	private:
+		struct Job {
+			int number;
+			std::vector<unsigned char>* buffer;
+			// The buffer holds the encoded file rather than RGB24.
+			bool encoded;
+		};
+
+		std::vector<unsigned char>* AcquireBuffer();
+		void EncodeLoop();
+		bool Encode(const Job& job);
+		std::string GetPath(int number) const;
+
+	private:
+		std::string m_Pattern;
+		ImageFormat m_Format = ImageFormat::PNG;
+		int m_Width = 0;
+		int m_Height = 0;
+		int m_Quality = 90;
+
+		std::vector<std::vector<unsigned char>> m_Buffers;
+		std::vector<std::vector<unsigned char>*> m_Free;
+		std::deque<Job> m_Queue;
+		std::vector<std::thread> m_Encoders;
+		std::vector<int> m_Repeats;
+		uint64_t m_RepeatCount = 0;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Work;
+		std::condition_variable m_Recycled;
+		bool m_Quit = false;
+
+		std::atomic<bool> m_Failed{ false };
+		std::atomic<uint64_t> m_Images{ 0 };
+		std::atomic<uint64_t> m_Bytes{ 0 };
+		std::atomic<uint64_t> m_EncodeMicros{ 0 };
+		double m_BlockedSeconds = 0.0;
+	};
+
+}
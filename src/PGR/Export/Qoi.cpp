@@ -0,0 +1,299 @@
+#include "Qoi.h"
+#include "PGR/Export/FrameWriter.h"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include <stb_image/stb_image_write.h>
+
+namespace PGR {
+
+	static constexpr unsigned char QoiOpIndex = 0x00;
+	static constexpr unsigned char QoiOpDiff = 0x40;
+	static constexpr unsigned char QoiOpLuma = 0x80;
+	static constexpr unsigned char QoiOpRun = 0xc0;
+	static constexpr unsigned char QoiOpRgb = 0xfe;
+	static constexpr unsigned char QoiOpRgba = 0xff;
+	static constexpr unsigned char QoiMask = 0xc0;
+	static constexpr int QoiHeaderSize = 14;
+	static const unsigned char QoiEnd[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	static int QoiHash(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+		return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+	}
+
+	static uint32_t QoiPack(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	static void WriteBE32(unsigned char* p, uint32_t v) {
+		p[0] = (unsigned char)(v >> 24);
+		p[1] = (unsigned char)(v >> 16);
+		p[2] = (unsigned char)(v >> 8);
+		p[3] = (unsigned char)v;
+	}
+
+	static uint32_t ReadBE32(const unsigned char* p) {
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+	}
+
+	// Writes into space reserved for the worst case (a literal per pixel), so
+	// the per-pixel path has no bounds checks or reallocation.
+	class QoiEncoder {
+	public:
+		QoiEncoder(std::vector<unsigned char>& out, int width, int height)
+			: m_Out(out), m_Begin(out.size()) {
+			out.resize(m_Begin + QoiHeaderSize + (size_t)width * height * 4 + sizeof(QoiEnd));
+			m_P = out.data() + m_Begin;
+			memcpy(m_P, "qoif", 4);
+			WriteBE32(m_P + 4, (uint32_t)width);
+			WriteBE32(m_P + 8, (uint32_t)height);
+			m_P[12] = 3;
+			m_P[13] = 0;
+			m_P += QoiHeaderSize;
+			memset(m_Index, 0, sizeof(m_Index));
+		}
+
+		void Push(unsigned char r, unsigned char g, unsigned char b) {
+			if (r == m_R && g == m_G && b == m_B) {
+				if (++m_Run == 62) {
+					*m_P++ = QoiOpRun | (m_Run - 1);
+					m_Run = 0;
+				}
+				return;
+			}
+			if (m_Run > 0) {
+				*m_P++ = QoiOpRun | (m_Run - 1);
+				m_Run = 0;
+			}
+
+			const int hash = QoiHash(r, g, b, 255);
+			const uint32_t pixel = QoiPack(r, g, b, 255);
+			if (m_Index[hash] == pixel)
+				*m_P++ = QoiOpIndex | hash;
+			else {
+				m_Index[hash] = pixel;
+				const int dr = (signed char)(r - m_R);
+				const int dg = (signed char)(g - m_G);
+				const int db = (signed char)(b - m_B);
+				const int drg = dr - dg;
+				const int dbg = db - dg;
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					*m_P++ = QoiOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+				else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+					*m_P++ = QoiOpLuma | (dg + 32);
+					*m_P++ = (unsigned char)(((drg + 8) << 4) | (dbg + 8));
+				}
+				else {
+					*m_P++ = QoiOpRgb;
+					*m_P++ = r;
+					*m_P++ = g;
+					*m_P++ = b;
+				}
+			}
+			m_R = r;
+			m_G = g;
+			m_B = b;
+		}
+
+		void Finish() {
+			if (m_Run > 0)
+				*m_P++ = QoiOpRun | (m_Run - 1);
+			memcpy(m_P, QoiEnd, sizeof(QoiEnd));
+			m_P += sizeof(QoiEnd);
+			m_Out.resize(m_P - m_Out.data());
+		}
+
+	private:
+		std::vector<unsigned char>& m_Out;
+		size_t m_Begin;
+		unsigned char* m_P;
+		uint32_t m_Index[64];
+		// The spec starts from opaque black.
+		unsigned char m_R = 0, m_G = 0, m_B = 0;
+		int m_Run = 0;
+	};
+
+	void QoiEncode(const unsigned char* rgb, int width, int height, std::vector<unsigned char>& out) {
+		QoiEncoder encoder(out, width, height);
+		const unsigned char* end = rgb + (size_t)width * height * 3;
+		for (const unsigned char* p = rgb; p < end; p += 3)
+			encoder.Push(p[0], p[1], p[2]);
+		encoder.Finish();
+	}
+
+	void QoiEncode(const Framebuffer* framebuffer, std::vector<unsigned char>& out) {
+		const int width = framebuffer->GetWidth();
+		const int height = framebuffer->GetHeight();
+		QoiEncoder encoder(out, width, height);
+		if (framebuffer->GetFormat() == FramebufferFormat::BGRX8) {
+			for (int y = 0; y < height; y++) {
+				const uint32_t* row = framebuffer->GetPixels() + (size_t)y * framebuffer->GetStride();
+				for (int x = 0; x < width; x++)
+					encoder.Push((unsigned char)(row[x] >> 16), (unsigned char)(row[x] >> 8), (unsigned char)row[x]);
+			}
+			encoder.Finish();
+			return;
+		}
+
+		// A row at a time through RGB24: the conversion vectorizes on its own,
+		// but not inside the encoder's pixel-by-pixel loop.
+		const Vec3* colors = framebuffer->GetColorBuffer();
+		thread_local std::vector<unsigned char> bytes;
+		bytes.resize((size_t)width * 3);
+		for (int y = height - 1; y >= 0; y--) {
+			const Vec3* row = colors + (size_t)y * width;
+			unsigned char* dst = bytes.data();
+			for (int x = 0; x < width; x++) {
+				*dst++ = ColorToByte(row[x].X);
+				*dst++ = ColorToByte(row[x].Y);
+				*dst++ = ColorToByte(row[x].Z);
+			}
+			for (const unsigned char* p = bytes.data(); p < dst; p += 3)
+				encoder.Push(p[0], p[1], p[2]);
+		}
+		encoder.Finish();
+	}
+
+	bool QoiDecode(const unsigned char* data, size_t size, std::vector<unsigned char>& rgb, int& width, int& height) {
+		if (size < QoiHeaderSize + sizeof(QoiEnd) || memcmp(data, "qoif", 4))
+			return false;
+		const uint32_t w = ReadBE32(data + 4);
+		const uint32_t h = ReadBE32(data + 8);
+		const int channels = data[12];
+		if (w == 0 || h == 0 || (channels != 3 && channels != 4) || (uint64_t)w * h > (1ULL << 30))
+			return false;
+
+		width = (int)w;
+		height = (int)h;
+		rgb.resize((size_t)w * h * 3);
+
+		uint32_t index[64] = {};
+		unsigned char r = 0, g = 0, b = 0, a = 255;
+		int run = 0;
+		const unsigned char* p = data + QoiHeaderSize;
+		const unsigned char* end = data + size - sizeof(QoiEnd);
+
+		for (unsigned char* dst = rgb.data(); dst < rgb.data() + rgb.size(); dst += 3) {
+			if (run > 0)
+				run--;
+			else {
+				if (p >= end)
+					return false;
+				const unsigned char op = *p++;
+				if (op == QoiOpRgb) {
+					if (end - p < 3)
+						return false;
+					r = p[0]; g = p[1]; b = p[2];
+					p += 3;
+				}
+				else if (op == QoiOpRgba) {
+					if (end - p < 4)
+						return false;
+					r = p[0]; g = p[1]; b = p[2]; a = p[3];
+					p += 4;
+				}
+				else if ((op & QoiMask) == QoiOpIndex) {
+					const uint32_t pixel = index[op];
+					r = (unsigned char)pixel;
+					g = (unsigned char)(pixel >> 8);
+					b = (unsigned char)(pixel >> 16);
+					a = (unsigned char)(pixel >> 24);
+				}
+				else if ((op & QoiMask) == QoiOpDiff) {
+					r += ((op >> 4) & 3) - 2;
+					g += ((op >> 2) & 3) - 2;
+					b += (op & 3) - 2;
+				}
+				else if ((op & QoiMask) == QoiOpLuma) {
+					if (p >= end)
+						return false;
+					const int dg = (op & 0x3f) - 32;
+					const unsigned char second = *p++;
+					r += dg - 8 + ((second >> 4) & 0x0f);
+					g += dg;
+					b += dg - 8 + (second & 0x0f);
+				}
+				else
+					run = op & 0x3f;
+				index[QoiHash(r, g, b, a)] = QoiPack(r, g, b, a);
+			}
+			dst[0] = r;
+			dst[1] = g;
+			dst[2] = b;
+		}
+		return true;
+	}
+
+	bool ReadQoi(const std::string& path, std::vector<unsigned char>& rgb, int& width, int& height) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return QoiDecode(data.data(), data.size(), rgb, width, height);
+	}
+
+	bool ConvertQoiToPng(const std::string& path, int threads, QoiConvertStats* stats) {
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::filesystem::path> files;
+		std::error_code error;
+		if (std::filesystem::is_directory(path, error)) {
+			for (const auto& entry : std::filesystem::directory_iterator(path, error)) {
+				if (entry.is_regular_file() && entry.path().extension() == ".qoi")
+					files.push_back(entry.path());
+			}
+			std::sort(files.begin(), files.end());
+		}
+		else
+			files.push_back(path);
+
+		std::atomic<size_t> next{ 0 };
+		std::mutex mutex;
+		QoiConvertStats total;
+		total.files = (int)files.size();
+
+		auto worker = [&]() {
+			std::vector<unsigned char> rgb;
+			for (;;) {
+				const size_t i = next++;
+				if (i >= files.size())
+					break;
+
+				const std::filesystem::path png = std::filesystem::path(files[i]).replace_extension(".png");
+				int width = 0, height = 0;
+				std::error_code sizeError;
+				const bool ok = ReadQoi(files[i].string(), rgb, width, height)
+					&& stbi_write_png(png.string().c_str(), width, height, 3, rgb.data(), width * 3);
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!ok) {
+					if (total.failed++ < 10)
+						printf("Can't convert %s\n", files[i].string().c_str());
+					continue;
+				}
+				total.qoiBytes += std::filesystem::file_size(files[i], sizeError);
+				total.pngBytes += std::filesystem::file_size(png, sizeError);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i < std::max(1, threads); i++)
+			workers.emplace_back(worker);
+		for (std::thread& t : workers)
+			t.join();
+
+		total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (stats)
+			*stats = total;
+		return total.failed == 0 && !files.empty();
+	}
+
+}
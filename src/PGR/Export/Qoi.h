@@ -0,0 +1,40 @@
+#pragma once
+#include "PGR/Window/Framebuffer.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	// QOI ("Quite OK Image"): lossless, one pass, no entropy coder. Each pixel
+	// becomes a run of the previous pixel, an index into a 64-entry table of
+	// recently seen pixels, a small delta from the previous pixel, or a literal.
+	// Far cheaper than PNG's zlib, for frame dumps that have to keep up with
+	// the renderer. Images here are always 3-channel sRGB.
+
+	// Appends the encoded image to `out`. `rgb` is top-down RGB24.
+	void QoiEncode(const unsigned char* rgb, int width, int height, std::vector<unsigned char>& out);
+	// The same bytes as converting to RGB24 first (FrameWriter::Convert), but
+	// straight from the framebuffer (float or BGRX8), a row at a time.
+	void QoiEncode(const Framebuffer* framebuffer, std::vector<unsigned char>& out);
+
+	// Decodes 3- or 4-channel QOI into top-down RGB24, dropping alpha.
+	// Returns false for a truncated or malformed image.
+	bool QoiDecode(const unsigned char* data, size_t size, std::vector<unsigned char>& rgb, int& width, int& height);
+
+	bool ReadQoi(const std::string& path, std::vector<unsigned char>& rgb, int& width, int& height);
+
+	struct QoiConvertStats {
+		int files = 0;
+		int failed = 0;
+		uint64_t qoiBytes = 0;
+		uint64_t pngBytes = 0;
+		double seconds = 0.0;
+	};
+
+	// Converts `path`, or every .qoi in the directory `path`, into a .png
+	// next to it, on `threads` threads. Returns false if any file failed.
+	bool ConvertQoiToPng(const std::string& path, int threads, QoiConvertStats* stats = nullptr);
+
+}
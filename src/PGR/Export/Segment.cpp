@@ -0,0 +1,295 @@
+#include "Segment.h"
+#include "PGR/Audio/Wav.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#include "cJSON/cJSON.h"
+
+namespace PGR {
+
+	uint64_t HashFrame(const unsigned char* data, size_t size) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ data[i]) * 1099511628211ULL;
+		return hash;
+	}
+
+	int64_t FrameToSample(int64_t frame, int fps, int sampleRate) {
+		return frame * sampleRate / fps;
+	}
+
+	bool WriteManifest(const std::string& path, const SegmentManifest& manifest) {
+		cJSON* root = cJSON_CreateObject();
+		cJSON_AddNumberToObject(root, "version", 1);
+		cJSON_AddStringToObject(root, "chart", manifest.chart.c_str());
+		cJSON_AddNumberToObject(root, "chartSeed", manifest.chartSeed);
+		cJSON_AddNumberToObject(root, "width", manifest.width);
+		cJSON_AddNumberToObject(root, "height", manifest.height);
+		cJSON_AddNumberToObject(root, "fps", manifest.fps);
+		cJSON_AddStringToObject(root, "format", GetFrameFormatName(manifest.format));
+		cJSON_AddStringToObject(root, "framebuffer", GetFramebufferFormatName(manifest.framebuffer));
+		cJSON_AddNumberToObject(root, "startFrame", manifest.startFrame);
+		cJSON_AddNumberToObject(root, "endFrame", manifest.endFrame);
+		cJSON_AddStringToObject(root, "video", manifest.video.c_str());
+		cJSON_AddStringToObject(root, "audio", manifest.audio.c_str());
+		cJSON_AddNumberToObject(root, "sampleRate", manifest.sampleRate);
+		cJSON_AddNumberToObject(root, "channels", manifest.channels);
+		cJSON_AddNumberToObject(root, "startSample", (double)manifest.startSample);
+		cJSON_AddNumberToObject(root, "endSample", (double)manifest.endSample);
+
+		// 64-bit hashes don't survive a JSON number, so they are hex strings.
+		cJSON* hashes = cJSON_AddArrayToObject(root, "frameHashes");
+		for (uint64_t hash : manifest.frameHashes) {
+			char hex[17];
+			snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+			cJSON_AddItemToArray(hashes, cJSON_CreateString(hex));
+		}
+
+		char* text = cJSON_Print(root);
+		cJSON_Delete(root);
+
+		FILE* file = fopen(path.c_str(), "wb");
+		const bool ok = file && fputs(text, file) >= 0;
+		if (file)
+			fclose(file);
+		cJSON_free(text);
+		return ok;
+	}
+
+	bool ReadManifest(const std::string& path, SegmentManifest& manifest) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		cJSON* root = cJSON_Parse(json.c_str());
+		if (!root)
+			return false;
+
+		auto number = [&](const char* name) {
+			const cJSON* item = cJSON_GetObjectItem(root, name);
+			return cJSON_IsNumber(item) ? item->valuedouble : 0.0;
+		};
+		auto string = [&](const char* name) {
+			const cJSON* item = cJSON_GetObjectItem(root, name);
+			return std::string(cJSON_IsString(item) ? item->valuestring : "");
+		};
+
+		manifest = SegmentManifest();
+		manifest.chart = string("chart");
+		manifest.chartSeed = (uint32_t)number("chartSeed");
+		manifest.width = (int)number("width");
+		manifest.height = (int)number("height");
+		manifest.fps = (int)number("fps");
+		manifest.startFrame = (int)number("startFrame");
+		manifest.endFrame = (int)number("endFrame");
+		manifest.video = string("video");
+		manifest.audio = string("audio");
+		manifest.sampleRate = (int)number("sampleRate");
+		manifest.channels = (int)number("channels");
+		manifest.startSample = (int64_t)number("startSample");
+		manifest.endSample = (int64_t)number("endSample");
+
+		bool ok = ParseFrameFormat(string("format"), manifest.format);
+		// Manifests from before BGRX8 framebuffers have no "framebuffer".
+		const std::string framebuffer = string("framebuffer");
+		if (!framebuffer.empty())
+			ok = ParseFramebufferFormat(framebuffer, manifest.framebuffer) && ok;
+		const cJSON* hashes = cJSON_GetObjectItem(root, "frameHashes");
+		for (int i = 0; i < cJSON_GetArraySize(hashes); i++) {
+			const cJSON* item = cJSON_GetArrayItem(hashes, i);
+			if (!cJSON_IsString(item)) {
+				ok = false;
+				break;
+			}
+			manifest.frameHashes.push_back(strtoull(item->valuestring, nullptr, 16));
+		}
+		cJSON_Delete(root);
+
+		return ok && manifest.width > 0 && manifest.height > 0 && manifest.fps > 0
+			&& (int)manifest.frameHashes.size() == manifest.endFrame - manifest.startFrame;
+	}
+
+	// The 16-bit samples of a WAV written by WavWriter, without going through
+	// float, so merged audio is bit-identical to the slices.
+	static bool ReadPcm16(const std::string& path, int sampleRate, int channels, std::vector<int16_t>& samples) {
+		FILE* file = fopen(path.c_str(), "rb");
+		if (!file)
+			return false;
+
+		unsigned char riff[12];
+		bool ok = fread(riff, 1, 12, file) == 12 && !memcmp(riff, "RIFF", 4) && !memcmp(riff + 8, "WAVE", 4);
+		bool format = false;
+		while (ok) {
+			unsigned char header[8];
+			if (fread(header, 1, 8, file) != 8) {
+				ok = false;
+				break;
+			}
+			const uint32_t size = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+			if (!memcmp(header, "fmt ", 4)) {
+				unsigned char fmt[16];
+				ok = size >= 16 && fread(fmt, 1, 16, file) == 16;
+				const int tag = fmt[0] | (fmt[1] << 8);
+				const int ch = fmt[2] | (fmt[3] << 8);
+				const int rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+				const int bits = fmt[14] | (fmt[15] << 8);
+				ok = ok && tag == 1 && ch == channels && rate == sampleRate && bits == 16;
+				format = true;
+				fseek(file, size - 16 + (size & 1), SEEK_CUR);
+			}
+			else if (!memcmp(header, "data", 4)) {
+				ok = format;
+				samples.resize(size / sizeof(int16_t));
+				ok = ok && fread(samples.data(), sizeof(int16_t), samples.size(), file) == samples.size();
+				break;
+			}
+			else
+				fseek(file, size + (size & 1), SEEK_CUR);
+		}
+		fclose(file);
+		return ok;
+	}
+
+	bool MergeSegments(const std::vector<std::string>& manifests, const std::string& videoPath, MergeStats* stats) {
+		struct Segment {
+			std::string path;
+			std::filesystem::path dir;
+			SegmentManifest manifest;
+		};
+
+		std::vector<Segment> segments;
+		for (const std::string& path : manifests) {
+			Segment segment;
+			segment.path = path;
+			segment.dir = std::filesystem::path(path).parent_path();
+			if (!ReadManifest(path, segment.manifest)) {
+				printf("Merge: can't read manifest %s\n", path.c_str());
+				return false;
+			}
+			// Segment images are already numbered by their global frame.
+			if (IsImageFormat(segment.manifest.format)) {
+				printf("Merge: %s is an image sequence, which needs no merge\n", path.c_str());
+				return false;
+			}
+			segments.push_back(segment);
+		}
+		if (segments.empty())
+			return false;
+
+		std::stable_sort(segments.begin(), segments.end(),
+			[](const Segment& a, const Segment& b) { return a.manifest.startFrame < b.manifest.startFrame; });
+
+		// Everything that can be checked from the manifests, before writing.
+		const SegmentManifest& first = segments[0].manifest;
+		bool ok = true;
+		for (size_t i = 0; i < segments.size(); i++) {
+			const SegmentManifest& m = segments[i].manifest;
+			const char* name = segments[i].path.c_str();
+			if (m.chartSeed != first.chartSeed || m.width != first.width || m.height != first.height || m.fps != first.fps
+				|| m.format != first.format || m.framebuffer != first.framebuffer || m.sampleRate != first.sampleRate || m.channels != first.channels) {
+				printf("Merge: %s doesn't match the layout of %s\n", name, segments[0].path.c_str());
+				ok = false;
+			}
+			if (m.startSample != FrameToSample(m.startFrame, m.fps, m.sampleRate) || m.endSample != FrameToSample(m.endFrame, m.fps, m.sampleRate)) {
+				printf("Merge: %s audio [%lld, %lld) doesn't match its frames\n", name, (long long)m.startSample, (long long)m.endSample);
+				ok = false;
+			}
+			if (i == 0)
+				continue;
+			const SegmentManifest& prev = segments[i - 1].manifest;
+			if (m.startFrame > prev.endFrame) {
+				printf("Merge: gap, frames [%d, %d) are missing before %s\n", prev.endFrame, m.startFrame, name);
+				ok = false;
+			}
+			else if (m.startFrame < prev.endFrame) {
+				printf("Merge: overlap, frames [%d, %d) are in both %s and %s\n",
+					m.startFrame, std::min(prev.endFrame, m.endFrame), segments[i - 1].path.c_str(), name);
+				ok = false;
+			}
+		}
+		if (!ok)
+			return false;
+
+		FrameWriter writer;
+		if (!writer.Open(videoPath, first.format, first.width, first.height, first.fps)) {
+			printf("Merge: can't open %s\n", videoPath.c_str());
+			return false;
+		}
+		const std::string audioPath = std::filesystem::path(videoPath).replace_extension(".wav").string();
+		WavWriter audio;
+		const bool withAudio = first.sampleRate > 0 && first.channels > 0;
+		if (withAudio && !audio.Open(audioPath, first.sampleRate, first.channels)) {
+			printf("Merge: can't open %s\n", audioPath.c_str());
+			return false;
+		}
+
+		MergeStats merged;
+		const size_t frameSize = writer.GetFrameSize();
+		std::vector<unsigned char> frame(frameSize);
+		std::vector<int16_t> samples;
+
+		for (const Segment& segment : segments) {
+			const SegmentManifest& m = segment.manifest;
+			const std::string video = (segment.dir / m.video).string();
+			FILE* file = fopen(video.c_str(), "rb");
+			if (!file) {
+				printf("Merge: can't open %s\n", video.c_str());
+				return false;
+			}
+
+			// Our own Y4M header and frame markers; the segment's are skipped.
+			if (m.format == FrameFormat::Y4M) {
+				int c;
+				while ((c = fgetc(file)) != EOF && c != '\n');
+			}
+
+			for (int i = 0; i < m.endFrame - m.startFrame && ok; i++) {
+				char marker[6];
+				if ((m.format == FrameFormat::Y4M && fread(marker, 1, 6, file) != 6) || fread(frame.data(), 1, frameSize, file) != frameSize) {
+					printf("Merge: %s ends after %d of %d frames\n", video.c_str(), i, m.endFrame - m.startFrame);
+					ok = false;
+					break;
+				}
+				if (HashFrame(frame.data(), frameSize) != m.frameHashes[i]) {
+					if (merged.hashMismatches++ < 10)
+						printf("Merge: frame %d in %s doesn't match its hash\n", m.startFrame + i, video.c_str());
+				}
+				if (!writer.WriteFrame(frame.data())) {
+					printf("Merge: failed to write %s\n", videoPath.c_str());
+					ok = false;
+				}
+				merged.frames++;
+			}
+			fclose(file);
+
+			if (ok && withAudio) {
+				const std::string slice = (segment.dir / m.audio).string();
+				const size_t expected = (size_t)(m.endSample - m.startSample) * m.channels;
+				if (!ReadPcm16(slice, m.sampleRate, m.channels, samples) || samples.size() != expected) {
+					printf("Merge: %s is missing or doesn't hold samples [%lld, %lld)\n",
+						slice.c_str(), (long long)m.startSample, (long long)m.endSample);
+					ok = false;
+				}
+				else {
+					audio.Write(samples.data(), samples.size() / m.channels);
+					merged.samples += m.endSample - m.startSample;
+				}
+			}
+			if (!ok)
+				break;
+			merged.segments++;
+		}
+
+		writer.Close();
+		audio.Close();
+
+		if (stats)
+			*stats = merged;
+		return ok && merged.hashMismatches == 0;
+	}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "PGR/Export/FrameWriter.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	// FNV-1a 64 of one converted output frame, as stored in manifests.
+	uint64_t HashFrame(const unsigned char* data, size_t size);
+
+	// First song sample of `frame`. Every segment rounds the same way, so
+	// audio slices of adjacent frame ranges meet without gap or overlap.
+	int64_t FrameToSample(int64_t frame, int fps, int sampleRate);
+
+	// Describes one exported frame range: where its video and audio slice are
+	// and the hash of every frame, so any other process or machine can check
+	// that it renders the same frames, and segments can be merged and verified
+	// without the chart. File names are relative to the manifest.
+	struct SegmentManifest {
+		std::string chart;
+		uint32_t chartSeed = 0;
+		int width = 0;
+		int height = 0;
+		int fps = 0;
+		FrameFormat format = FrameFormat::Y4M;
+		// What the frames were rendered into; BGRX8 blends in 8 bits, so the
+		// hashes only match a re-render in the same format.
+		FramebufferFormat framebuffer = FramebufferFormat::Float;
+		int startFrame = 0;
+		int endFrame = 0;
+		std::string video;
+		std::string audio;
+		int sampleRate = 0;
+		int channels = 0;
+		int64_t startSample = 0;
+		int64_t endSample = 0;
+		std::vector<uint64_t> frameHashes;
+	};
+
+	bool WriteManifest(const std::string& path, const SegmentManifest& manifest);
+	bool ReadManifest(const std::string& path, SegmentManifest& manifest);
+
+	struct MergeStats {
+		int segments = 0;
+		int frames = 0;
+		int64_t samples = 0;
+		int hashMismatches = 0;
+	};
+
+	// Joins the segments listed by `manifests` into `videoPath` (and the
+	// matching WAV next to it) by copying frames and samples unchanged. Fails
+	// without writing anything if the segments disagree on layout or leave a
+	// gap or overlap between frame ranges; frames whose bytes don't match
+	// their manifest hash are counted and fail the merge.
+	bool MergeSegments(const std::vector<std::string>& manifests, const std::string& videoPath, MergeStats* stats = nullptr);
+
+}
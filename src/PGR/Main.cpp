@@ -10,5 +10,5 @@ int main(int argc, char** argv) {
 
 	App.Run();
 
-	return 0;
+	return App.GetExitCode();
 }
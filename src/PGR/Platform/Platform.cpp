@@ -0,0 +1,104 @@
+#include "Platform.h"
+
+#ifdef _WIN32
+#include "PGR/Window/Window.h"
+
+#include <Windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace PGR {
+
+#ifdef _WIN32
+
+	class Win32Platform : public Platform {
+	public:
+		// 1 ms sleeps for FrameScheduler's waits, instead of the 15.6 ms default.
+		Win32Platform() { timeBeginPeriod(1); }
+
+		~Win32Platform() override {
+			timeEndPeriod(1);
+			if (m_MusicOpen)
+				mciSendString("close music", NULL, 0, NULL);
+			if (m_Window) {
+				delete m_Window;
+				Window::Terminate();
+			}
+		}
+
+		const char* GetName() const override { return "win32"; }
+
+		bool OpenWindow(const std::string& title, int width, int height) override {
+			Window::Init();
+			m_Window = Window::Create(title, width, height);
+			return m_Window != nullptr;
+		}
+
+		bool IsWindowOpen() const override { return m_Window && !m_Window->Closed(); }
+		int PollEvents() override {
+			m_Window->ResetWheel();
+			return Window::PollInputEvents();
+		}
+
+		void WaitEvents(double timeout) override {
+			MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)(timeout * 1000.0), QS_ALLINPUT);
+		}
+
+		void Present(Framebuffer* framebuffer) override { m_Window->DrawFramebuffer(framebuffer); }
+		int GetWidth() const override { return m_Window->GetWidth(); }
+		int GetHeight() const override { return m_Window->GetHeight(); }
+		bool IsActive() const override { return m_Window->IsActive(); }
+
+		char GetKey(uint32_t key) const override { return m_Window->GetKey(key); }
+		int GetMouseX() const override { return m_Window->GetMouseX(); }
+		int GetMouseY() const override { return m_Window->GetMouseY(); }
+		int GetWheel() const override { return m_Window->GetWhell(); }
+
+		std::wstring OpenChartDialog() override {
+			wchar_t szFile[260] = L"";
+			OPENFILENAMEW ofn;
+			ZeroMemory(&ofn, sizeof(ofn));
+			ofn.lStructSize = sizeof(ofn);
+			ofn.hwndOwner = NULL;
+			ofn.lpstrFile = szFile;
+			ofn.nMaxFile = sizeof(szFile) / sizeof(wchar_t);
+			ofn.lpstrFilter = L"Text Files (*.txt)\0*.txt\0All Files (*.*)\0*.*\0";
+			ofn.nFilterIndex = 1;
+			ofn.lpstrInitialDir = L"chart\\";
+			ofn.lpstrTitle = L"Choose chartInfo file";
+			ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST;
+			if (!GetOpenFileNameW(&ofn))
+				return L"";
+			return szFile;
+		}
+
+		bool OpenMusic(const std::string& path) override {
+			std::string str = "open " + path + " alias music";
+			m_MusicOpen = mciSendString(str.c_str(), NULL, 0, NULL) == 0;
+			return m_MusicOpen;
+		}
+
+		void PlayMusic() override { mciSendString("play music", NULL, 0, NULL); }
+		void PauseMusic() override { mciSendString("pause music", NULL, 0, NULL); }
+
+	private:
+		Window* m_Window = nullptr;
+		bool m_MusicOpen = false;
+	};
+
+	Platform* Platform::Create(bool headless) {
+		if (headless)
+			return new HeadlessPlatform();
+		return new Win32Platform();
+	}
+
+#else
+
+	Platform* Platform::Create(bool headless) {
+		return new HeadlessPlatform();
+	}
+
+#endif
+
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "PGR/Window/Framebuffer.h"
+#include "PGR/Window/InputCode.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+namespace PGR {
+
+	// What the interactive viewer needs from the OS: a window to present frames
+	// in and read input from, a file dialog, and a media player for songs the
+	// mixer can't stream. Nothing in pgr_core (chart, renderer, mixing, export)
+	// goes through here.
+	class Platform {
+	public:
+		virtual ~Platform() = default;
+
+		virtual const char* GetName() const = 0;
+
+		// Returns false when there is no display to open a window on.
+		virtual bool OpenWindow(const std::string& title, int width, int height) = 0;
+		virtual bool IsWindowOpen() const = 0;
+		// Handles every pending event; returns how many there were.
+		virtual int PollEvents() = 0;
+		// Blocks until an event arrives or `timeout` seconds pass.
+		virtual void WaitEvents(double timeout) = 0;
+		virtual void Present(Framebuffer* framebuffer) = 0;
+		virtual int GetWidth() const = 0;
+		virtual int GetHeight() const = 0;
+		virtual bool IsActive() const = 0;
+
+		// PGR_PRESS / PGR_RELEASE for the PGR_KEY_* and PGR_BUTTON_* codes.
+		virtual char GetKey(uint32_t key) const = 0;
+		virtual int GetMouseX() const = 0;
+		virtual int GetMouseY() const = 0;
+		virtual int GetWheel() const = 0;
+
+		// Asks for a chart's info.txt; empty if cancelled or there is no dialog.
+		virtual std::wstring OpenChartDialog() = 0;
+
+		// Returns false when there is no player.
+		virtual bool OpenMusic(const std::string& path) = 0;
+		virtual void PlayMusic() = 0;
+		virtual void PauseMusic() = 0;
+
+		// The GDI window, file dialog and MCI on Windows, unless `headless`;
+		// a HeadlessPlatform elsewhere.
+		static Platform* Create(bool headless);
+	};
+
+	// No display, dialog or player, for render servers: only the headless
+	// modes (--export, --mixdown, ...) run.
+	class HeadlessPlatform : public Platform {
+	public:
+		const char* GetName() const override { return "headless"; }
+
+		bool OpenWindow(const std::string& title, int width, int height) override { return false; }
+		bool IsWindowOpen() const override { return false; }
+		int PollEvents() override { return 0; }
+		void WaitEvents(double timeout) override { std::this_thread::sleep_for(std::chrono::duration<double>(timeout)); }
+		void Present(Framebuffer* framebuffer) override {}
+		int GetWidth() const override { return 0; }
+		int GetHeight() const override { return 0; }
+		bool IsActive() const override { return false; }
+
+		char GetKey(uint32_t key) const override { return PGR_RELEASE; }
+		int GetMouseX() const override { return 0; }
+		int GetMouseY() const override { return 0; }
+		int GetWheel() const override { return 0; }
+
+		std::wstring OpenChartDialog() override { return L""; }
+
+		bool OpenMusic(const std::string& path) override { return false; }
+		void PlayMusic() override {}
+		void PauseMusic() override {}
+	};
+
+}
@@ -0,0 +1,83 @@
+#include "Atlas.h"
+
+#include <stb_image/stb_rect_pack.h>
+
+namespace PGR {
+
+	Atlas::Atlas(const int pageSize, const int padding)
+		: m_PageSize(pageSize), m_Padding(padding) {
+	}
+
+	Atlas::~Atlas() {
+		for (Texture* page : m_Pages)
+			delete page;
+		m_Pages.clear();
+	}
+
+	void Atlas::Add(Texture** slot) {
+		if (slot && *slot)
+			m_Slots.push_back(slot);
+	}
+
+	void Atlas::Pack() {
+		std::vector<stbrp_rect> pending;
+		for (size_t i = 0; i < m_Slots.size(); i++) {
+			const Texture* texture = *m_Slots[i];
+			stbrp_rect rect = {};
+			rect.id = (int)i;
+			rect.w = texture->GetWidth() + m_Padding * 2;
+			rect.h = texture->GetHeight() + m_Padding * 2;
+			// Anything larger than a page stays a standalone texture.
+			if (rect.w <= m_PageSize && rect.h <= m_PageSize)
+				pending.push_back(rect);
+		}
+
+		std::vector<stbrp_node> nodes(m_PageSize);
+
+		while (!pending.empty()) {
+			stbrp_context context;
+			stbrp_init_target(&context, m_PageSize, m_PageSize, nodes.data(), (int)nodes.size());
+			stbrp_pack_rects(&context, pending.data(), (int)pending.size());
+
+			int width = 0, height = 0;
+			for (const stbrp_rect& rect : pending) {
+				if (!rect.was_packed)
+					continue;
+				width = std::max(width, rect.x + rect.w);
+				height = std::max(height, rect.y + rect.h);
+			}
+
+			Texture* page = new Texture(width, height, Vec4(0.0f));
+			m_Pages.push_back(page);
+
+			std::vector<stbrp_rect> rest;
+			for (const stbrp_rect& rect : pending) {
+				if (!rect.was_packed) {
+					rest.push_back(rect);
+					continue;
+				}
+
+				Texture*& slot = *m_Slots[rect.id];
+				const int x0 = rect.x + m_Padding;
+				const int y0 = rect.y + m_Padding;
+				const int w = slot->GetWidth();
+				const int h = slot->GetHeight();
+				for (int y = 0; y < h; y++)
+					for (int x = 0; x < w; x++)
+						page->SetColor(x0 + x, y0 + y, slot->GetColor(x, y));
+
+				delete slot;
+				slot = new Texture(page, x0, y0, w, h);
+			}
+			pending.swap(rest);
+		}
+	}
+
+	size_t Atlas::GetTexelCount() const {
+		size_t count = 0;
+		for (const Texture* page : m_Pages)
+			count += (size_t)page->GetWidth() * page->GetHeight();
+		return count;
+	}
+
+}
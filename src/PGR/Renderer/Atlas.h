@@ -0,0 +1,29 @@
+#pragma once
+#include "PGR/Renderer/Texture.h"
+
+#include <vector>
+
+namespace PGR {
+
+	class Atlas {
+	public:
+		Atlas(const int pageSize = 4096, const int padding = 2);
+		~Atlas();
+
+		// Registers a texture slot for packing. On Pack() the texture is copied
+		// into a page, deleted, and the slot is pointed at a view of the page.
+		void Add(Texture** slot);
+		void Pack();
+
+		size_t GetPageCount() const { return m_Pages.size(); }
+		Texture* GetPage(size_t index) const { return m_Pages[index]; }
+		size_t GetTexelCount() const;
+
+	private:
+		int m_PageSize;
+		int m_Padding;
+		std::vector<Texture**> m_Slots;
+		std::vector<Texture*> m_Pages;
+	};
+
+}
@@ -0,0 +1,711 @@
+#include "ChartRenderer.h"
+#include "PGR/Base/Profiler.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <string>
+
+namespace PGR {
+
+	// Judged notes are gone from the field and count towards the combo.
+	static bool IsNotePassed(const Note& note, float t) {
+		return (!note.isHold && note.sect < t) || (note.isHold && note.holdEndTime < t);
+	}
+
+	// A line's state in screen space, and the ends it is drawn between.
+	// Alpha is drawn in 1/1024 steps, below what 8-bit output can show, so a
+	// fade that crawls over a whole intro doesn't make every frame unique.
+	static void PlaceLine(const EventsValue& e, int width, int height, const Camera& camera, EventsValue& ev, Vec2 ends[2]) {
+		const float size = camera.size;
+		ev = e;
+		ev.alpha = std::round(e.alpha * 1024.0f) / 1024.0f;
+		ev.x *= width, ev.y *= height;
+		ev.x = (ev.x - width / 2) * size + width / 2 + camera.Pos.X;
+		ev.y = (ev.y - height / 2) * size + height / 2 + camera.Pos.Y;
+		ends[0] = rotatePoint(ev.x, ev.y, height * lineh * size, ev.rotate);
+		ends[1] = rotatePoint(ev.x, ev.y, height * lineh * size, ev.rotate + 180.0f);
+	}
+
+	// Distance of a note's head from its line, or false if it isn't drawn.
+	static bool PlaceNote(const Note& note, const JudgeLine& line, float lineFp, float t, int height, float size, bool debug, float& noteFp) {
+		noteFp = (note.floorPosition - lineFp) * pgrh * (pgrbeat / line.bpm) * height * size;
+
+		if (!note.isHold) {
+			noteFp *= note.speed;
+			if (noteFp < -1e6)
+				return false;
+		}
+
+		if ((debug ? noteFp : noteFp / size) > height * 2)
+			return false;
+
+		const bool clicked = note.sect < t;
+		if ((!note.isHold && noteFp < 0) || (note.isHold && noteFp < 0 && !clicked))
+			return false;
+		return true;
+	}
+
+	ChartRenderer::ChartRenderer(const C& c)
+		: m_C(c) {
+		m_EffectScheduler.Reset(&c.chart.data.clickEffectCollection, effectDur);
+		m_Particles.SetSeed(c.chart.data.seed);
+	}
+
+	void ChartRenderer::DrawTexture(Texture* texture, const int x, const int y, const float sx, float sy, float angle, const Vec4& tint) {
+		if (!texture) return;
+
+		if (sy == -1)
+			sy = sx;
+
+		const int texWidth = texture->GetWidth();
+		const int texHeight = texture->GetHeight();
+		const float srcW = static_cast<float>(texWidth);
+		const float srcH = static_cast<float>(texHeight);
+		const float w = srcW * sx;
+		const float h = srcH * sy;
+
+		const float rad = angle * 3.14159265f / 180.0f;
+		const float cosA = cosf(rad);
+		const float sinA = sinf(rad);
+
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+		float corners[4][2] = { {0, 0}, {w, 0}, {0, h}, {w, h} };
+		for (int k = 0; k < 4; ++k) {
+			float rx = corners[k][0] * cosA - corners[k][1] * sinA;
+			float ry = corners[k][0] * sinA + corners[k][1] * cosA;
+			minX = Min(minX, rx);
+			minY = Min(minY, ry);
+			maxX = Max(maxX, rx);
+			maxY = Max(maxY, ry);
+		}
+
+		const int startY = static_cast<int>(std::floor(minY));
+		const int endY = static_cast<int>(std::ceil(maxY));
+		const int startX = static_cast<int>(std::floor(minX));
+		const int endX = static_cast<int>(std::ceil(maxX));
+
+		const float invSx = 1.0f / sx;
+		const float invSy = 1.0f / sy;
+
+		const int windowWidth = m_Width;
+		const int windowHeight = m_Height;
+
+		const bool tinted = tint.X != 1.0f || tint.Y != 1.0f || tint.Z != 1.0f || tint.W != 1.0f;
+
+		Framebuffer* framebuffer = m_Framebuffer;
+
+		for (int j = startY; j <= endY; ++j) {
+			const float jSinA = j * sinA;
+			const float jCosA = j * cosA;
+			const int dstY = y + j;
+
+			if (dstY < 0 || dstY >= windowHeight)
+				continue;
+
+			for (int i = startX; i <= endX; ++i) {
+				const int dstX = x + i;
+				if (dstX < 0 || dstX >= windowWidth)
+					continue;
+
+				const float tx = (i * cosA + jSinA) * invSx;
+				const float ty = (-i * sinA + jCosA) * invSy;
+
+				if (tx >= 0 && tx < srcW && ty >= 0 && ty < srcH) {
+					const int texX = static_cast<int>(tx);
+					const int texY = static_cast<int>(ty);
+
+					Vec4 tColor = texture->GetColor(texX, texY);
+					if (tinted)
+						tColor = tColor * tint;
+					framebuffer->SetColor(dstX, dstY, tColor);
+				}
+			}
+		}
+	}
+
+	void ChartRenderer::DrawTexture(Framebuffer* framebuffer, Texture* texture, int x, int y, float sx, float sy, float angle, const Vec4& tint) {
+		m_Framebuffer = framebuffer;
+		m_Width = framebuffer->GetWidth();
+		m_Height = framebuffer->GetHeight();
+		DrawTexture(texture, x, y, sx, sy, angle, tint);
+	}
+
+	// FNV-1a over the exact values a frame is drawn from.
+	class FrameKeyHash {
+	public:
+		template<typename T>
+		void Add(const T& value) {
+			const unsigned char* bytes = (const unsigned char*)&value;
+			for (size_t i = 0; i < sizeof(T); i++)
+				m_Hash = (m_Hash ^ bytes[i]) * 1099511628211ULL;
+		}
+		uint64_t Get() const { return m_Hash; }
+
+	private:
+		uint64_t m_Hash = 14695981039346656037ULL;
+	};
+
+	uint64_t ChartRenderer::GetFrameKey(int width, int height, float t, const Camera& camera) {
+		FrameKeyHash key;
+		key.Add(width);
+		key.Add(height);
+		key.Add(camera.size);
+		key.Add(camera.Pos.X);
+		key.Add(camera.Pos.Y);
+
+		// Lines by the pixels they're drawn between, so a slow drift that
+		// doesn't move them stays the same frame. Notes are placed from the
+		// exact state, so a line with notes on it adds that too; a scrolling
+		// line with nothing on screen yet doesn't change the image.
+		int combo = 0;
+		for (size_t i = 0; i < m_C.chart.data.judgeLines.size(); i++) {
+			const JudgeLine& line = m_C.chart.data.judgeLines[i];
+			const EventsValue e = line.getState(t);
+			EventsValue ev;
+			Vec2 ends[2];
+			PlaceLine(e, width, height, camera, ev, ends);
+			key.Add((int)ends[0].X);
+			key.Add((int)ends[0].Y);
+			key.Add((int)ends[1].X);
+			key.Add((int)ends[1].Y);
+			key.Add(ev.alpha);
+
+			const float lineFp = line.getFp(line.sec2beat(t));
+			for (size_t j = 0; j < line.notes.size(); j++) {
+				const Note& note = line.notes[j];
+				if (IsNotePassed(note, t)) {
+					combo++;
+					continue;
+				}
+				float noteFp;
+				if (!PlaceNote(note, line, lineFp, t, height, camera.size, false, noteFp))
+					continue;
+				key.Add(j);
+				key.Add(noteFp);
+				key.Add(note.sect < t);
+				key.Add(ev.x);
+				key.Add(ev.y);
+				key.Add(ev.rotate);
+			}
+		}
+		key.Add(combo);
+
+		// Hit effects and their particles animate on every frame they're alive.
+		m_EffectScheduler.Update(t);
+		if (m_EffectScheduler.GetActiveCount() > 0)
+			key.Add(t);
+
+		// The progress bar, in the pixels it's drawn at.
+		const float endTime = m_C.chart.data.time;
+		const float progress = width * (Min(t, endTime) / endTime);
+		key.Add((int)progress);
+		key.Add((int)(progress - 0.5f));
+		key.Add((int)(progress + 0.5f));
+		return key.Get();
+	}
+
+	void ChartRenderer::Render(Framebuffer* framebuffer, float t, const Camera& camera, bool debug, int selectedLine) {
+		m_Framebuffer = framebuffer;
+		m_Width = framebuffer->GetWidth();
+		m_Height = framebuffer->GetHeight();
+
+		const float size = camera.size;
+		const float ox = camera.Pos.X;
+		const float oy = camera.Pos.Y;
+
+		{
+			PGR_PROFILE_SCOPE(Background);
+
+			DrawTexture(
+				m_C.chart.blurImage, 0, 0,
+				(float)m_Width / m_C.chart.blurImage->GetWidth(),
+				(float)m_Height / m_C.chart.blurImage->GetHeight()
+			);
+
+			m_Framebuffer->FillRect(0, 0, m_Width, m_Height, Vec4(0.0f, 0.0f, 0.0f, 0.2f));
+
+			Texture* texture = m_C.chart.image;
+			DrawTexture(
+				texture, (int)(m_Width / 2 - m_Width * size / 2 + ox), (int)(m_Height / 2 - m_Height * size / 2 + oy),
+				(float)m_Width / texture->GetWidth() * size,
+				(float)m_Height / texture->GetHeight() * size
+			);
+
+			m_Framebuffer->FillRect(
+				(int)(m_Width / 2.0f - m_Width / 2.0f * camera.size + camera.Pos.X),
+				m_Height - (int)(m_Height / 2.0f - m_Height / 2.0f * camera.size + camera.Pos.Y),
+				(int)(m_Width / 2.0f + m_Width / 2.0f * camera.size + camera.Pos.X),
+				m_Height - (int)(m_Height / 2.0f + m_Height / 2.0f * camera.size + camera.Pos.Y),
+				Vec4(0.0f, 0.0f, 0.0f, 0.6f)
+			);
+		}
+
+		float noteW = noteSize * m_Width * size;
+
+		int combo = 0;
+
+		for (size_t i = 0; i < m_C.chart.data.judgeLines.size(); i++) {
+			PGR_PROFILE_SCOPE(JudgeLines);
+
+			const JudgeLine& line = m_C.chart.data.judgeLines[i];
+
+			EventsValue e = line.getState(t);
+			EventsValue ev;
+			Vec2 linePos[2];
+			PlaceLine(e, m_Width, m_Height, camera, ev, linePos);
+
+			m_Framebuffer->DrawLine(
+				(int)linePos[0].X, (int)linePos[0].Y,
+				(int)linePos[1].X, (int)linePos[1].Y,
+				m_Height * linew * size,
+				Vec4(i == selectedLine ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : pcolor, debug ? ev.alpha * 0.99f + 0.01f : ev.alpha)
+			);
+
+			Vec2 lineAPos = rotatePoint(ev.x, ev.y, m_Height * 0.025f, ev.rotate + 90.0f);
+
+			if (debug) {
+
+				m_Framebuffer->DrawLine(
+					(int)ev.x, (int)ev.y,
+					(int)lineAPos.X, (int)lineAPos.Y,
+					m_Height * linew * size, Vec4(i == selectedLine ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : pcolor, ev.alpha * 0.99f + 0.01f)
+				);
+
+			}
+
+			float beatt = line.sec2beat(t);
+			float lineFp = line.getFp(beatt);
+
+			const JudgeLine& currentLine = m_C.chart.data.judgeLines[i];
+			float pgrwTimesWidth = pgrw * m_Width * size;
+			float PI_OVER_180 = PI / 180.0f;
+			float cosEvRotate = cos(ev.rotate * PI_OVER_180);
+			float sinEvRotate = sin(ev.rotate * PI_OVER_180);
+
+
+			if (debug) {
+				char speedBuf[32];
+				sprintf(speedBuf, "%.2f", ev.speed);
+
+				char PosXBuf[32];
+				sprintf(PosXBuf, "%.2f", (double)e.x - (double)0.5f);
+
+				char PosYBuf[32];
+				sprintf(PosYBuf, "%.2f", (double)e.y - (double)0.5f);
+
+				std::string lineStr =
+					"[" + std::to_string(i) +
+					"] (" + PosXBuf +
+					", " + PosYBuf +
+					") " + std::to_string((int)ev.rotate) +
+					"d " + std::to_string((int)(ev.alpha * 100.0f)) +
+					": " + speedBuf;
+
+				m_Framebuffer->DrawCenterTextTTF(
+					(int)(ev.x + sin(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
+					(int)(m_Height - ev.y + cos(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
+					lineStr,
+					Vec4(i == selectedLine ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : pcolor, ev.alpha * 0.9f + 0.1f), m_Width * 0.04f, -ev.rotate
+				);
+
+				if (selectedLine == i) {
+					std::string lineStr =
+						"[" + std::to_string(selectedLine) +
+						"] (" + PosXBuf +
+						", " + PosYBuf +
+						") " + std::to_string((int)ev.rotate) +
+						"d " + std::to_string((int)(ev.alpha * 100.0f)) +
+						": " + speedBuf;
+
+					m_Framebuffer->DrawCenterTextTTF(
+						(int)(m_Width / 2.0f),
+						(int)(m_Height - m_Height * 0.03f),
+						lineStr,
+						Vec4(1.0f), m_Width * 0.04f, 0.0f
+					);
+				}
+
+			}
+		}
+
+		for (int i = 0; i < m_C.chart.data.judgeLines.size(); i++) {
+			PGR_PROFILE_SCOPE(Notes);
+
+			const JudgeLine& line = m_C.chart.data.judgeLines[i];
+
+			EventsValue e = line.getState(t);
+			EventsValue ev = e;
+			ev.x *= m_Width, ev.y *= m_Height;
+			ev.x = (ev.x - m_Width / 2) * size + m_Width / 2 + ox;
+			ev.y = (ev.y - m_Height / 2) * size + m_Height / 2 + oy;
+
+			float beatt = line.sec2beat(t);
+			float lineFp = line.getFp(beatt);
+
+			const JudgeLine& currentLine = m_C.chart.data.judgeLines[i];
+			float pgrwTimesWidth = pgrw * m_Width * size;
+			float PI_OVER_180 = PI / 180.0f;
+			float cosEvRotate = cos(ev.rotate * PI_OVER_180);
+			float sinEvRotate = sin(ev.rotate * PI_OVER_180);
+
+			const auto& notes = currentLine.notes;
+			size_t notesCount = notes.size();
+			for (size_t j = 0; j < notesCount; j++) {
+				const Note& note = notes[j];
+				const bool clicked = note.sect < t;
+
+				if (IsNotePassed(note, t)) {
+					combo++;
+					continue;
+				}
+
+				float noteFp;
+				if (!PlaceNote(note, line, lineFp, t, m_Height, size, debug, noteFp)) {
+					continue;
+				}
+
+				bool drawHead = note.sect > t;
+				Texture* noteHeadImg = m_C.noteHeadImgs[note.type - 1][note.morebets];
+
+				float thisNoteWidth = 1.0f * noteSize * size;
+
+				if (note.morebets) {
+					thisNoteWidth = noteSize * size * (
+						(float)(m_C.noteHeadImgs[note.type - 1][1]->GetWidth())
+						/ (float)(m_C.noteHeadImgs[note.type - 1][0]->GetWidth())
+						);
+				}
+
+				float headImgWidth = (float)noteHeadImg->GetWidth();
+				float headImgHeight = (float)noteHeadImg->GetHeight();
+				float thisNoteHeadHeight = thisNoteWidth / headImgWidth * headImgHeight;
+				float posX = note.positionX * pgrwTimesWidth;
+
+				float noteAtlineX = ev.x + posX * cosEvRotate;
+				float noteAtlineY = ev.y + posX * sinEvRotate;
+				Vec2 noteAtlinePos(noteAtlineX, noteAtlineY);
+
+				float l2nRotate = ev.rotate - (note.isAbove ? -90 : 90);
+				float l2nRad = l2nRotate * PI_OVER_180;
+				float cosL2n = cos(l2nRad);
+				float sinL2n = sin(l2nRad);
+
+				float headX = noteAtlineX + noteFp * cosL2n;
+				float headY = noteAtlineY + noteFp * sinL2n;
+				Vec2 noteHeadPos(headX, headY);
+
+				float noteDrawRotate = ev.rotate - (note.isAbove ? 0 : 180);
+				float drawRad = noteDrawRotate * PI_OVER_180;
+				float cosDrawRad = cos(drawRad);
+				float sinDrawRad = sin(drawRad);
+
+				float texScale = thisNoteWidth * m_Width / headImgWidth;
+				float Size = m_Width * noteSize / headImgWidth * size;
+				float W = texScale * headImgWidth / 2.0f;
+				float H = texScale * headImgHeight / 2.0f;
+				float w = W * cosDrawRad - H * sinDrawRad;
+				float h = H * cosDrawRad + W * sinDrawRad;
+
+				float noteBodyHeight = 0.0f;
+
+				if (note.isHold) {
+					Texture* noteBodyImg = m_C.holdBodyImgs[note.morebets];
+					Texture* noteTailImg = m_C.holdTailImgs[note.morebets];
+
+					float noteTillHeight = thisNoteWidth * m_Width / noteTailImg->GetWidth() * noteTailImg->GetHeight();
+					float noteHeadHeight = thisNoteWidth * m_Width / headImgWidth * headImgHeight;
+
+					noteBodyHeight = Max(
+						note.holdLength * size * m_Height +
+						Min(0.0f, noteFp) +
+						(clicked ? noteHeadHeight : 0.0f) -
+						noteTillHeight * 1.5f,
+						0.0f
+					);
+
+					if (noteBodyHeight > 0.0f) {
+						PGR_PROFILE_SCOPE(HoldBodies);
+
+						float tailPosBaseX = clicked ? noteAtlineX : headX;
+						float tailPosBaseY = clicked ? noteAtlineY : headY;
+						float tailOffset = (clicked ? noteHeadHeight / 2.0f : noteHeadHeight) + noteBodyHeight;
+						float tailX = tailPosBaseX + tailOffset * cosL2n;
+						float tailY = tailPosBaseY + tailOffset * sinL2n;
+						Vec2 noteTailPos(tailX, tailY);
+
+						float headH = thisNoteWidth * m_Width / headImgWidth * headImgHeight;
+						float x = headX - w - headH * sinDrawRad;
+						float y = headY - h + headH * cosDrawRad;
+
+						float bodyTexScaleX = thisNoteWidth * m_Width / headImgWidth;
+						float bodyTexScaleY = noteBodyHeight / noteBodyImg->GetHeight();
+						DrawTexture(
+							noteBodyImg,
+							clicked ? (int)(noteAtlineX - w - headH / 2 * sinDrawRad) : (int)x,
+							clicked ? (int)(noteAtlineY - h + headH / 2 * cosDrawRad) : (int)y,
+							bodyTexScaleX, bodyTexScaleY,
+							noteDrawRotate
+						);
+
+						float tailImgWidth = (float)noteTailImg->GetWidth();
+						float tailImgHeight = (float)noteTailImg->GetHeight();
+						float tailS = m_Width * noteSize / tailImgWidth;
+						float tailW = tailS * tailImgWidth * thisNoteWidth / noteSize / 2.0f;
+						float tailH = tailS * tailImgHeight / 2.0f * size;
+						float tailw = tailW * cosDrawRad - tailH * sinDrawRad;
+						float tailh = tailH * cosDrawRad + tailW * sinDrawRad;
+
+						float tailTexScale = thisNoteWidth * m_Width / headImgWidth;
+						DrawTexture(
+							noteTailImg,
+							(int)(noteTailPos.X - tailw), (int)(noteTailPos.Y - tailh),
+							tailTexScale, tailTexScale,
+							noteDrawRotate
+						);
+
+					}
+				}
+
+				if (drawHead && ((note.isHold && noteBodyHeight > 0.0f) || !note.isHold)) {
+					DrawTexture(
+						noteHeadImg, (int)(noteHeadPos.X - w), (int)(noteHeadPos.Y - h),
+						texScale, texScale,
+						noteDrawRotate
+					);
+
+					if (debug) {
+
+						const char* typeStr = "";
+
+						switch (note.type) {
+						case 1:
+							typeStr = "click";
+							break;
+						case 2:
+							typeStr = "drag";
+							break;
+						case 3:
+							typeStr = "hold";
+							break;
+						case 4:
+							typeStr = "flick";
+							break;
+						}
+
+						char PosXBuf[32], PosYBuf[32];
+
+						sprintf(PosXBuf, "%.2f", note.positionX);
+						sprintf(PosYBuf, "%.2f", noteFp / (pgrh * m_Height * size));
+
+						std::string noteStr =
+							"[" + std::to_string(i) +
+							"]" + std::to_string(j) +
+							"( " + PosXBuf +
+							"," + PosYBuf +
+							" ): " + typeStr +
+							": " + std::to_string((int)note.sect);
+
+						if (note.isHold)
+							noteStr += "/ " + std::to_string((int)note.holdEndTime);
+
+						m_Framebuffer->DrawCenterTextTTF(
+							(int)(noteHeadPos.X + sin(noteDrawRotate * PI_OVER_180) * m_Width * 0.03f),
+							(int)(m_Height - noteHeadPos.Y + cos(noteDrawRotate * PI_OVER_180) * m_Width * 0.03f),
+							noteStr, i == selectedLine ? Vec4(0.0f, 1.0f, 0.0f, 1.0f) : Vec4(1.0f, 0.5f), m_Width * 0.025f, -noteDrawRotate
+						);
+
+					}
+				}
+			}
+		}
+
+		{
+			PGR_PROFILE_SCOPE(HitEffects);
+
+			float pgrwTimesWidthEffect = pgrw * m_Width * size;
+			const auto& hitFxImgs = m_C.hitFxImgs;
+			size_t hitFxImgsCount = hitFxImgs.size();
+
+			m_EffectScheduler.Update(t);
+			m_Particles.Clear();
+
+			for (size_t effectIdx = m_EffectScheduler.Begin(); effectIdx < m_EffectScheduler.End(); effectIdx++) {
+				const HitEffect& fx = m_C.chart.data.clickEffectCollection[effectIdx];
+
+				float p = (t - fx.sect) / effectDur;
+				float alpha = 1.0f - p;
+
+				size_t imgIndex = static_cast<size_t>(Max(0.0f, Min(static_cast<float>(hitFxImgsCount - 1), floor(p * hitFxImgsCount))));
+				Texture* img = hitFxImgs[imgIndex];
+				float effectSize = noteW * 1.375f * 1.12f;
+				float halfEffectSize = effectSize * 0.5f;
+
+				float posX = (fx.x * m_Width - m_Width / 2) * size + m_Width / 2;
+				float posY = (fx.y * m_Height - m_Height / 2) * size + m_Height / 2;
+				float offsetX = fx.positionX * pgrwTimesWidthEffect;
+
+				float finalX = posX + offsetX * fx.cosRotate + ox;
+				float finalY = posY + offsetX * fx.sinRotate + oy;
+				Vec2 pos(finalX, finalY);
+
+				float texScale = effectSize / img->GetWidth();
+				DrawTexture(
+					img,
+					(int)(finalX - halfEffectSize), (int)(finalY - halfEffectSize),
+					texScale, texScale, 0.0f,
+					Vec4(pcolor, 1.0f)
+				);
+
+				m_Particles.Emit((uint32_t)effectIdx, finalX, finalY, p, alpha);
+			}
+		}
+
+		{
+			PGR_PROFILE_SCOPE(Particles);
+
+			float particleScale = m_Width / 4040.0f * 3.0f * size;
+			m_Particles.Update(particleScale);
+			m_Particles.Draw(m_Framebuffer, pcolor, ParticleSystem::Size * particleScale);
+		}
+
+		PGR_PROFILE_SCOPE(Hud);
+
+		float endTime = m_C.chart.data.time;
+
+		m_Framebuffer->FillRect(
+			0, 0,
+			(int)(m_Width * (Min(t, endTime) / endTime)), (int)(m_Height * 12.0f / 1080.0f),
+			Vec4(0.45f, 1.0f)
+		);
+
+		m_Framebuffer->FillRect(
+			(int)(m_Width * (Min(t, endTime) / endTime) - 0.5f), 0,
+			(int)(m_Width * (Min(t, endTime) / endTime) + 0.5f), (int)(m_Height * 12.0f / 1080.0f),
+			Vec4(1.0f, 1.0f)
+		);
+
+		m_Framebuffer->FillRect(
+			(int)(m_Width * 33.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f),
+			(int)(m_Width * 45.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f + m_Width * 39.0f / 1920.0f),
+			Vec4(1.0f)
+		);
+
+		m_Framebuffer->FillRect(
+			(int)(m_Width * 56.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f),
+			(int)(m_Width * 68.0f / 1920.0f), (int)(m_Height * 39.0f / 1080.0f + m_Width * 39.0f / 1920.0f),
+			Vec4(1.0f)
+		);
+
+		if (combo >= 3) {
+			m_Framebuffer->DrawCenterTextTTF(
+				(int)(m_Width * 0.5f), (int)(m_Height * 39.0f / 1080.0f + m_Width * 60.0f / 1920.0f),
+				std::to_string(combo), Vec4(1.0f), (m_Width * 86.0f / 1920.0f), 0.0f
+			);
+
+			m_Framebuffer->DrawCenterTextTTF(
+				(int)(m_Width * 0.5f), (int)((m_Height * 39.0f / 1080.0f + m_Width * 60.0f / 1920.0f) * 84.0f / 63.0f),
+				"AUTOPLAY", Vec4(1.0f), (m_Width * 34.0f / 1920.0f), 0.0f
+			);
+		}
+
+		float score = (float)combo / m_C.chart.data.noteCount * 1000000.0f;
+		char scoreStr[10];
+		sprintf(scoreStr, "%07d", (int)score);
+		m_Framebuffer->DrawTextTTF(
+			(int)(m_Width - (m_Width * 365.0f / 1920.0f)), (int)(m_Height * 39.0f / 1080.0f),
+			scoreStr, Vec4(1.0f), m_Width * 70.0f / 1920.0f
+		);
+
+		m_Framebuffer->DrawWTextTTF(
+			(int)(m_Width * 48.0f / 1920.0f), (int)(m_Height * 980.0f / 1080.0f),
+			m_C.chart.info.name, Vec4(1.0f), m_Width * 60.0f / 1920.0f
+		);
+
+		m_Framebuffer->DrawWTextTTF(
+			(int)(m_Width - m_Width * 35.0f / 1920.0f * m_C.chart.info.level.length()), (int)(m_Height * 980.0f / 1080.0f),
+			m_C.chart.info.level, Vec4(1.0f), m_Width * 60.0f / 1920.0f
+		);
+
+		if (selectedLine != -1 && debug) {
+			const JudgeLine& line = m_C.chart.data.judgeLines[selectedLine];
+
+			EventsValue e = line.getState(t);
+			EventsValue ev = e;
+			ev.x *= m_Width, ev.y *= m_Height;
+			ev.x = (ev.x - m_Width / 2) * size + m_Width / 2 + ox;
+			ev.y = (ev.y - m_Height / 2) * size + m_Height / 2 + oy;
+			Vec2 linePos[2] = {
+				rotatePoint(ev.x, ev.y, m_Height * lineh * size, ev.rotate),
+				rotatePoint(ev.x, ev.y, m_Height * lineh * size, ev.rotate + 180.0f)
+			};
+
+			m_Framebuffer->DrawLine(
+				(int)linePos[0].X, (int)linePos[0].Y,
+				(int)linePos[1].X, (int)linePos[1].Y,
+				m_Height* linew* size,
+				Vec4(0.0f, 1.0f, 0.0f, 1.0f)
+			);
+
+			Vec2 lineAPos = rotatePoint(ev.x, ev.y, m_Height * 0.025f, ev.rotate + 90.0f);
+
+			m_Framebuffer->DrawLine(
+				(int)ev.x, (int)ev.y,
+				(int)lineAPos.X, (int)lineAPos.Y,
+				m_Height * linew * size, Vec4(0.0f, 1.0f, 0.0f, 1.0f)
+			);
+
+			float beatt = line.sec2beat(t);
+			float lineFp = line.getFp(beatt);
+
+			const JudgeLine& currentLine = m_C.chart.data.judgeLines[selectedLine];
+			const auto& notes = currentLine.notes;
+			size_t notesCount = notes.size();
+			float pgrwTimesWidth = pgrw * m_Width * size;
+			float PI_OVER_180 = PI / 180.0f;
+			float cosEvRotate = cos(ev.rotate * PI_OVER_180);
+			float sinEvRotate = sin(ev.rotate * PI_OVER_180);
+
+			char speedBuf[32];
+			sprintf(speedBuf, "%.2f", ev.speed);
+
+			char PosXBuf[32];
+			sprintf(PosXBuf, "%.2f", (double)e.x - (double)0.5f);
+
+			char PosYBuf[32];
+			sprintf(PosYBuf, "%.2f", (double)e.y - (double)0.5f);
+
+			std::string lStr =
+				"[" + std::to_string(selectedLine) +
+				"] (" + PosXBuf +
+				", " + PosYBuf +
+				") " + std::to_string((int)ev.rotate) +
+				"d " + std::to_string((int)(ev.alpha * 100.0f)) +
+				": " + speedBuf;
+
+			m_Framebuffer->DrawCenterTextTTF(
+				(int)(ev.x + sin(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
+				(int)(m_Height - ev.y + cos(ev.rotate * PI_OVER_180) * m_Width * 0.04f),
+				lStr,
+				Vec4(0.0f, 1.0f, 0.0f, 1.0f), m_Width * 0.04f, -ev.rotate
+			);
+
+			std::string lineStr =
+				"[" + std::to_string(selectedLine) +
+				"] (" + PosXBuf +
+				", " + PosYBuf +
+				") " + std::to_string((int)ev.rotate) +
+				"d " + std::to_string((int)(ev.alpha * 100.0f)) +
+				": " + speedBuf;
+
+			m_Framebuffer->DrawCenterTextTTF(
+				(int)(m_Width / 2.0f),
+				(int)(m_Height - m_Height * 0.03f),
+				lineStr,
+				Vec4(0.0f, 1.0f, 0.0f, 1.0f), m_Width * 0.04f, 0.0f
+			);
+
+		}
+	}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "PGR/Chart/Chart.h"
+#include "PGR/Window/Framebuffer.h"
+#include "PGR/Renderer/EffectScheduler.h"
+#include "PGR/Renderer/Particles.h"
+
+namespace PGR {
+
+	// Draws one frame of a loaded chart. The image is a function of the chart,
+	// the time and the camera only: note hit state is derived from `t`, and the
+	// hit-effect window and particle buffers are caches that are rebuilt for
+	// whatever time is asked for, in any order. One renderer per thread.
+	class ChartRenderer {
+	public:
+		ChartRenderer(const C& c);
+
+		void Render(Framebuffer* framebuffer, float t, const Camera& camera, bool debug = false, int selectedLine = -1);
+
+		// Hash of everything a non-debug Render() at `t` draws from: line
+		// states, the notes on screen and where, hit effects, combo and the
+		// progress bar. Two times with the same key render the same pixels,
+		// without rasterizing either.
+		uint64_t GetFrameKey(int width, int height, float t, const Camera& camera);
+
+		// One textured quad, drawn as Render draws notes and hit effects; for
+		// timing the blitter on its own.
+		void DrawTexture(Framebuffer* framebuffer, Texture* texture, int x, int y, float sx, float sy = -1.0f, float angle = 0.0f, const Vec4& tint = Vec4(1.0f));
+
+	private:
+		void DrawTexture(Texture* texture, int x, int y, const float sx = 1.0f, const float sy = -1.0f, float angle = 0.0f, const Vec4& tint = Vec4(1.0f));
+
+	private:
+		const C& m_C;
+
+		Framebuffer* m_Framebuffer = nullptr;
+		int m_Width = 0, m_Height = 0;
+
+		EffectScheduler<HitEffect> m_EffectScheduler;
+		ParticleSystem m_Particles;
+	};
+
+}
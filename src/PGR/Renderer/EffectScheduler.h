@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+#include <cstddef>
+
+namespace PGR {
+
+	// Keeps the window of effects alive at time t over a list sorted by `sect`.
+	// Every effect lives for the same duration, so the alive ones always form
+	// one contiguous index range [Begin(), End()). Playing forward only touches
+	// effects that start or expire; a seek re-derives the range by binary search.
+	template<typename T>
+	class EffectScheduler {
+	public:
+		EffectScheduler() = default;
+
+		void Reset(const std::vector<T>* effects, float duration) {
+			m_Effects = effects;
+			m_Duration = duration;
+			m_Begin = 0;
+			m_End = 0;
+			m_Time = -FLT_MAX;
+		}
+
+		void Update(float t) {
+			if (!m_Effects)
+				return;
+
+			if (t < m_Time || t - m_Time > m_Duration) {
+				Seek(t);
+				return;
+			}
+
+			const std::vector<T>& es = *m_Effects;
+			while (m_End < es.size() && es[m_End].sect <= t)
+				m_End++;
+			while (m_Begin < m_End && es[m_Begin].sect + m_Duration < t)
+				m_Begin++;
+			m_Time = t;
+		}
+
+		void Seek(float t) {
+			const std::vector<T>& es = *m_Effects;
+			m_Begin = FirstAlive(t);
+			m_End = m_Begin;
+			while (m_End < es.size() && es[m_End].sect <= t)
+				m_End++;
+			m_Time = t;
+		}
+
+		size_t Begin() const { return m_Begin; }
+		size_t End() const { return m_End; }
+		size_t GetActiveCount() const { return m_End - m_Begin; }
+
+	private:
+		size_t FirstAlive(float t) const {
+			const std::vector<T>& es = *m_Effects;
+			size_t l = 0, r = es.size();
+			while (l < r) {
+				size_t m = (l + r) / 2;
+				if (es[m].sect + m_Duration < t)
+					l = m + 1;
+				else
+					r = m;
+			}
+			return l;
+		}
+
+	private:
+		const std::vector<T>* m_Effects = nullptr;
+		float m_Duration = 0.0f;
+		float m_Time = -FLT_MAX;
+		size_t m_Begin = 0;
+		size_t m_End = 0;
+	};
+
+}
@@ -0,0 +1,154 @@
+#include "FramePipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+namespace PGR {
+
+	static double Seconds() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	FramePipeline::FramePipeline(int width, int height, FramebufferFormat format, int depth, const std::string& font) {
+		m_Slots.resize(std::clamp(depth, 1, 3));
+		for (Slot& slot : m_Slots) {
+			slot.framebuffer = Framebuffer::Create(width, height, format);
+			slot.framebuffer->LoadFontTTF(font);
+		}
+		m_Thread = std::thread(&FramePipeline::RenderLoop, this);
+	}
+
+	FramePipeline::~FramePipeline() {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Quit = true;
+		}
+		m_Work.notify_all();
+		m_Thread.join();
+		for (Slot& slot : m_Slots)
+			delete slot.framebuffer;
+	}
+
+	int FramePipeline::GetInFlight() const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return (int)m_InFlight.size();
+	}
+
+	void FramePipeline::Submit(int width, int height, RenderFunc render) {
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		auto free = [&]() {
+			return std::find_if(m_Slots.begin(), m_Slots.end(), [](const Slot& s) { return s.state == SlotState::Free; });
+		};
+		if (free() == m_Slots.end()) {
+			PGR_TRACE_SCOPE("Wait for a free buffer", "frame");
+			const double start = Seconds();
+			m_Done.wait(lock, [&]() { return free() != m_Slots.end(); });
+			m_Stats.submitWaitSeconds += Seconds() - start;
+		}
+
+		const int index = (int)(free() - m_Slots.begin());
+		Slot& slot = m_Slots[index];
+		slot.state = SlotState::Rendering;
+		slot.render = std::move(render);
+		slot.width = width;
+		slot.height = height;
+		slot.submitted = Seconds();
+		slot.sequence = m_Submitted++;
+		m_Jobs.push_back(index);
+		m_InFlight.push_back(index);
+		lock.unlock();
+		m_Work.notify_one();
+	}
+
+	Framebuffer* FramePipeline::Acquire(FrameTimings* timings) {
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_InFlight.empty())
+			return nullptr;
+		Slot& slot = m_Slots[m_InFlight.front()];
+		if (slot.state != SlotState::Ready) {
+			PGR_TRACE_SCOPE("Wait for a rendered frame", "frame");
+			const double start = Seconds();
+			m_Done.wait(lock, [&]() { return slot.state == SlotState::Ready; });
+			m_Stats.acquireWaitSeconds += Seconds() - start;
+		}
+		slot.state = SlotState::Presenting;
+		if (timings)
+			*timings = slot.timings;
+		return slot.framebuffer;
+	}
+
+	void FramePipeline::Release(Framebuffer* framebuffer) {
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_InFlight.empty() || m_Slots[m_InFlight.front()].framebuffer != framebuffer)
+				return;
+			Slot& slot = m_Slots[m_InFlight.front()];
+			m_InFlight.pop_front();
+			slot.state = SlotState::Free;
+
+			const double latency = Seconds() - slot.submitted;
+			m_Stats.frames++;
+			m_Stats.latencySum += latency;
+			m_Stats.latencyMax = std::max(m_Stats.latencyMax, latency);
+		}
+		m_Done.notify_all();
+	}
+
+	void FramePipeline::RenderLoop() {
+		Trace::SetThreadName("Render");
+		for (;;) {
+			Slot* slot;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				const double start = Seconds();
+				m_Work.wait(lock, [&]() { return m_Quit || !m_Jobs.empty(); });
+				m_Stats.idleSeconds += Seconds() - start;
+				// Render what was submitted before quitting.
+				if (m_Jobs.empty())
+					return;
+				slot = &m_Slots[m_Jobs.front()];
+				m_Jobs.pop_front();
+			}
+
+			// Only this thread touches a Rendering slot.
+			const double start = Seconds();
+			PGR_TRACE_SCOPE_ARG("Frame", "frame", slot->sequence);
+			Framebuffer* framebuffer = slot->framebuffer;
+			slot->timings = FrameTimings();
+			SetProfileTarget(&slot->timings);
+			{
+				PGR_PROFILE_SCOPE(Background);
+				if (framebuffer->GetWidth() != slot->width || framebuffer->GetHeight() != slot->height)
+					framebuffer->Resize(slot->width, slot->height);
+				framebuffer->Clear(Vec3(0.0f));
+			}
+			slot->render(framebuffer);
+			slot->render = nullptr;
+			SetProfileTarget(nullptr);
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Stats.renderSeconds += Seconds() - start;
+				slot->state = SlotState::Ready;
+			}
+			m_Done.notify_all();
+		}
+	}
+
+	FramePipelineStats FramePipeline::GetStats() const {
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Stats;
+	}
+
+	void FramePipeline::PrintStats() const {
+		const FramePipelineStats stats = GetStats();
+		const double n = (double)std::max<uint64_t>(stats.frames, 1);
+		printf("Pipeline: depth %d, %llu frames, render %.2f ms/frame, latency mean %.2f ms, max %.2f ms\n",
+			GetDepth(), (unsigned long long)stats.frames, stats.renderSeconds * 1000.0 / n,
+			stats.latencySum * 1000.0 / n, stats.latencyMax * 1000.0);
+		printf("Pipeline: waited %.2f s for a free buffer, %.2f s for a rendered frame; render thread idle %.2f s\n",
+			stats.submitWaitSeconds, stats.acquireWaitSeconds, stats.idleSeconds);
+	}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "PGR/Window/Framebuffer.h"
+#include "PGR/Base/Profiler.h"
+#include "PGR/Base/Trace.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace PGR {
+
+	struct FramePipelineStats {
+		uint64_t frames = 0;
+		// Render thread: drawing, and waiting for work.
+		double renderSeconds = 0.0;
+		double idleSeconds = 0.0;
+		// Calling thread: blocked on a free buffer, or on a frame to present.
+		double submitWaitSeconds = 0.0;
+		double acquireWaitSeconds = 0.0;
+		// Submit() to Release(): from the state a frame was drawn from to it
+		// being on screen.
+		double latencySum = 0.0;
+		double latencyMax = 0.0;
+	};
+
+	// Rasterizes frames on a thread of its own while the caller presents (or
+	// encodes) the one before. `depth` framebuffers cycle Free -> Rendering
+	// -> Ready -> Presenting -> Free; each state has one owner and buffers
+	// only change hands under the lock, so neither side touches a buffer the
+	// other holds. The caller keeps at most `depth` - 1 frames in flight
+	// before presenting the oldest: depth 2 overlaps rendering frame N+1 with
+	// presenting frame N for one frame of latency, depth 1 is the serial loop.
+	class FramePipeline {
+	public:
+		using RenderFunc = std::function<void(Framebuffer*)>;
+
+		FramePipeline(int width, int height, FramebufferFormat format = FramebufferFormat::Float, int depth = 2, const std::string& font = "font.ttf");
+		// Finishes the queued frames first.
+		~FramePipeline();
+
+		int GetDepth() const { return (int)m_Slots.size(); }
+		// Frames submitted and not yet released.
+		int GetInFlight() const;
+
+		// Queues a `width` x `height` frame, cleared and drawn by `render` on
+		// the render thread. Blocks while every buffer is in use.
+		void Submit(int width, int height, RenderFunc render);
+		// The oldest submitted frame, once it is rendered; nullptr if nothing
+		// is in flight. `timings` gets its render phases (see Profiler.h).
+		Framebuffer* Acquire(FrameTimings* timings = nullptr);
+		// Returns the frame from Acquire() once it is presented.
+		void Release(Framebuffer* framebuffer);
+
+		FramePipelineStats GetStats() const;
+		void PrintStats() const;
+
+	private:
+		enum class SlotState {
+			Free,
+			Rendering,
+			Ready,
+			Presenting
+		};
+
+		struct Slot {
+			Framebuffer* framebuffer = nullptr;
+			SlotState state = SlotState::Free;
+			RenderFunc render;
+			FrameTimings timings;
+			int width = 0, height = 0;
+			double submitted = 0.0;
+			// Submit order, to tell frames apart in a trace.
+			uint64_t sequence = 0;
+		};
+
+		void RenderLoop();
+
+	private:
+		std::vector<Slot> m_Slots;
+		// Slot indices in submit order: waiting for the render thread, and all in flight.
+		std::deque<int> m_Jobs;
+		std::deque<int> m_InFlight;
+		bool m_Quit = false;
+		uint64_t m_Submitted = 0;
+
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_Work;
+		std::condition_variable m_Done;
+		FramePipelineStats m_Stats;
+		std::thread m_Thread;
+	};
+
+}
@@ -0,0 +1,81 @@
+#include "Particles.h"
+
+namespace PGR {
+
+	uint32_t ParticleSystem::Hash(uint32_t x) {
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+		x ^= x >> 16;
+		return x;
+	}
+
+	float ParticleSystem::Random(uint32_t seed, uint32_t effect, uint32_t index, float a, float b) {
+		const uint32_t h = Hash(seed ^ Hash(effect * 0x9e3779b9U + index));
+		const float u = (float)(h >> 8) * (1.0f / 16777216.0f);
+		return a + (b - a) * u;
+	}
+
+	void ParticleSystem::Clear() {
+		m_CenterX.clear();
+		m_CenterY.clear();
+		m_DirX.clear();
+		m_DirY.clear();
+		m_Radius.clear();
+		m_Progress.clear();
+		m_Alpha.clear();
+	}
+
+	void ParticleSystem::Emit(uint32_t effect, float x, float y, float p, float alpha) {
+		for (uint32_t i = 0; i < PerEffect; i++) {
+			const float rad = Random(m_Seed, effect, i * 2, 0.0f, 360.0f) * PI / 180.0f;
+			const float r = Random(m_Seed, effect, i * 2 + 1, 185.0f, 265.0f);
+
+			m_CenterX.push_back(x);
+			m_CenterY.push_back(y);
+			m_DirX.push_back(cosf(rad));
+			m_DirY.push_back(sinf(rad));
+			m_Radius.push_back(r);
+			m_Progress.push_back(p);
+			m_Alpha.push_back(alpha);
+		}
+	}
+
+	// Branch-free over plain arrays so the compiler can vectorize it.
+	static void UpdateKernel(
+		size_t count, float scale,
+		const float* cx, const float* cy,
+		const float* dx, const float* dy,
+		const float* r, const float* p,
+		float* __restrict ox, float* __restrict oy
+	) {
+		for (size_t i = 0; i < count; i++) {
+			const float d = r[i] * scale * (9.0f * p[i] / (8.0f * p[i] + 1.0f));
+			ox[i] = cx[i] + dx[i] * d;
+			oy[i] = cy[i] + dy[i] * d;
+		}
+	}
+
+	void ParticleSystem::Update(float scale) {
+		const size_t count = m_CenterX.size();
+		m_X.resize(count);
+		m_Y.resize(count);
+
+		UpdateKernel(
+			count, scale,
+			m_CenterX.data(), m_CenterY.data(),
+			m_DirX.data(), m_DirY.data(),
+			m_Radius.data(), m_Progress.data(),
+			m_X.data(), m_Y.data()
+		);
+	}
+
+	void ParticleSystem::Draw(Framebuffer* framebuffer, const Vec3& color, float size) const {
+		const int height = framebuffer->GetHeight();
+		const int s = (int)size;
+		for (size_t i = 0; i < m_X.size(); i++)
+			framebuffer->FillSizeRect((int)m_X[i], (int)(height - m_Y[i]), s, s, Vec4(color, m_Alpha[i]));
+	}
+
+}
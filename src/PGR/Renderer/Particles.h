@@ -0,0 +1,49 @@
+#pragma once
+#include "PGR/Base/Maths.h"
+#include "PGR/Window/Framebuffer.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace PGR {
+
+	// Hit-effect particles. The random direction and distance of a particle are
+	// a pure function of (seed, effect index, particle index), so nothing is
+	// stored per effect and the same chart time always yields the same image.
+	// Particles of all active effects are collected into flat arrays each frame
+	// and advanced by one branch-free loop before drawing.
+	class ParticleSystem {
+	public:
+		static constexpr int PerEffect = 4;
+		static constexpr float Size = 33.0f * 0.75f;
+
+		ParticleSystem() = default;
+
+		void SetSeed(uint32_t seed) { m_Seed = seed; }
+		uint32_t GetSeed() const { return m_Seed; }
+
+		void Clear();
+		void Emit(uint32_t effect, float x, float y, float p, float alpha);
+		void Update(float scale);
+		void Draw(Framebuffer* framebuffer, const Vec3& color, float size) const;
+
+		size_t GetCount() const { return m_X.size(); }
+
+		static uint32_t Hash(uint32_t x);
+		static float Random(uint32_t seed, uint32_t effect, uint32_t index, float a, float b);
+
+	private:
+		uint32_t m_Seed = 0;
+
+		// inputs
+		std::vector<float> m_CenterX, m_CenterY;
+		std::vector<float> m_DirX, m_DirY;
+		std::vector<float> m_Radius;
+		std::vector<float> m_Progress;
+		std::vector<float> m_Alpha;
+
+		// outputs
+		std::vector<float> m_X, m_Y;
+	};
+
+}
@@ -1,5 +1,7 @@
 #include "Texture.h"
 
+#include <cstring>
+
 namespace PGR {
 
 	Texture::Texture(const std::string& path)
@@ -23,8 +25,30 @@ namespace PGR {
 		m_Data[0] = value;
 	}
 
+	Texture::Texture(const int width, const int height, const Vec4& value) {
+		m_Width = width;
+		m_Height = height;
+		m_Stride = width;
+		m_Channels = 4;
+		m_Data = new Vec4[(size_t)width * (size_t)height];
+		for (int i = 0; i < width * height; i++)
+			m_Data[i] = value;
+	}
+
+	// A view into a sub-rectangle of another texture (an atlas page).
+	// The page keeps ownership of the texels and must outlive the view.
+	Texture::Texture(Texture* page, int x, int y, int width, int height) {
+		m_Width = width;
+		m_Height = height;
+		m_Stride = page->m_Stride;
+		m_Channels = page->m_Channels;
+		m_Path = page->GetPath() + "_view";
+		m_Data = page->m_Data + x + y * page->m_Stride;
+		m_OwnsData = false;
+	}
+
 	Texture::~Texture() {
-		if (m_Data)
+		if (m_Data && m_OwnsData)
 			delete[] m_Data;
 		m_Data = nullptr;
 	}
@@ -49,6 +73,7 @@ namespace PGR {
 
 		m_Height = height;
 		m_Width = width;
+		m_Stride = width;
 		m_Channels = channels;
 		int size = width * height;
 		m_Data = new Vec4[size];
@@ -116,7 +141,7 @@ namespace PGR {
 			int x = (int)(vx * (m_Width - 1) + 0.5f);
 			int y = (int)(vy * (m_Height - 1) + 0.5f);
 
-			int index = x + y * m_Width;
+			int index = x + y * m_Stride;
 			return m_Data[index];
 		}
 		else {
@@ -134,10 +159,10 @@ namespace PGR {
 			float dx = fx - x0;
 			float dy = fy - y0;
 
-			Vec4 c00 = m_Data[x0 + y0 * m_Width];
-			Vec4 c10 = m_Data[x1 + y0 * m_Width];
-			Vec4 c01 = m_Data[x0 + y1 * m_Width];
-			Vec4 c11 = m_Data[x1 + y1 * m_Width];
+			Vec4 c00 = m_Data[x0 + y0 * m_Stride];
+			Vec4 c10 = m_Data[x1 + y0 * m_Stride];
+			Vec4 c01 = m_Data[x0 + y1 * m_Stride];
+			Vec4 c11 = m_Data[x1 + y1 * m_Stride];
 
 			Vec4 c0 = c00 * (1 - dx) + c10 * dx;
 			Vec4 c1 = c01 * (1 - dx) + c11 * dx;
@@ -175,6 +200,7 @@ namespace PGR {
 		Texture* newTexture = new Texture(Vec4(0.0f, 0.0f, 0.0f, 0.0f));
 		newTexture->m_Width = this->GetWidth();
 		newTexture->m_Height = y1 - y0;
+		newTexture->m_Stride = newTexture->m_Width;
 		newTexture->m_Channels = this->m_Channels;
 		newTexture->m_Path = this->GetPath() + "_clipped";
 
@@ -184,7 +210,7 @@ namespace PGR {
 
 		for (int y = 0; y < newTexture->m_Height; y++) {
 			for (int x = 0; x < newTexture->m_Width; x++) {
-				int srcIndex = x + (y + y0) * this->GetWidth();
+				int srcIndex = x + (y + y0) * this->m_Stride;
 				int dstIndex = x + y * newTexture->m_Width;
 				newTexture->m_Data[dstIndex] = this->m_Data[srcIndex];
 			}
@@ -204,10 +230,12 @@ namespace PGR {
 		Texture* newTexture = new Texture(Vec4(0.0f, 0.0f, 0.0f, 0.0f));
 		newTexture->m_Width = x1 - x0;
 		newTexture->m_Height = y1 - y0;
+		newTexture->m_Stride = newTexture->m_Width;
 		newTexture->m_Channels = this->m_Channels;
 		newTexture->m_Path = this->GetPath() + "_blockclipped";
 
 		int newSize = newTexture->m_Width * newTexture->m_Height;
+		delete[] newTexture->m_Data;
 		newTexture->m_Data = new Vec4[newSize];
 
 		for (int y = 0; y < newTexture->m_Height; y++) {
@@ -227,6 +255,7 @@ namespace PGR {
 		Texture* newTexture = new Texture(color);
 		newTexture->m_Width = this->GetWidth();
 		newTexture->m_Height = this->GetHeight();
+		newTexture->m_Stride = newTexture->m_Width;
 		newTexture->m_Channels = this->m_Channels;
 		newTexture->m_Path = this->GetPath() + "_colored";
 
@@ -271,9 +300,9 @@ namespace PGR {
 
 			Vec4 sum = Vec4(0.0f);
 
-			for (int i = 0; i < size; ++i) {
-				sum += this->m_Data[i];
-			}
+			for (int y = 0; y < height; ++y)
+				for (int x = 0; x < width; ++x)
+					sum += this->GetColor(x, y);
 
 			Vec4 color = sum / static_cast<float>(size);
 
@@ -288,6 +317,7 @@ namespace PGR {
 		Texture* blurTexture = new Texture(Vec4(0.0f, 0.0f, 0.0f, 0.0f));
 		blurTexture->m_Width = width;
 		blurTexture->m_Height = height;
+		blurTexture->m_Stride = width;
 		blurTexture->m_Channels = this->m_Channels;
 		blurTexture->m_Path = this->GetPath() + "_blur";
 
@@ -303,7 +333,7 @@ namespace PGR {
 				for (int dx = -radius; dx <= radius; ++dx) {
 					int nx = x + dx;
 					if (nx >= 0 && nx < width) {
-						sum += this->m_Data[y * width + nx];
+						sum += this->GetColor(nx, y);
 						count++;
 					}
 				}
@@ -13,11 +13,13 @@ namespace PGR {
 		Texture(const std::string& path);
 		Texture(const float value);
 		Texture(const Vec4& value);
+		Texture(const int width, const int height, const Vec4& value);
+		Texture(Texture* page, int x, int y, int width, int height);
 		~Texture();
 
 		Vec4 Sample(Vec2 texCoords, bool enableLerp = true, Vec4 defaultValue = Vec4(0.0f)) const;
 		float SampleFloat(Vec2 texCoords, bool enableLerp = true, float defaultValue = 0.0f) const;
-		Vec4 GetColor(int x, int y) const { return m_Data[x + y * m_Width]; }
+		Vec4 GetColor(int x, int y) const { return m_Data[x + y * m_Stride]; }
 
 		int GetWidth() const { return m_Width; }
 		int GetHeight() const { return m_Height; }
@@ -28,13 +30,17 @@ namespace PGR {
 		Texture* ColorTexture(Vec4 color, bool reserve = true);
 		Texture* GetBlurImg(float radius, bool reserve = true);
 
-		void SetColor(int x, int y, Vec4 color) { m_Data[x + y * m_Width] = color; }
+		void SetColor(int x, int y, Vec4 color) { m_Data[x + y * m_Stride] = color; }
+
+		bool IsView() const { return !m_OwnsData; }
 
 	private:
 		void Init();
 
 	private:
 		int m_Width, m_Height, m_Channels;
+		int m_Stride = 1;
+		bool m_OwnsData = true;
 		std::string m_Path;
 		Vec4* m_Data;
 	};
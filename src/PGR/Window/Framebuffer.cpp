@@ -1,18 +1,75 @@
 ﻿#include "Framebuffer.h"
 
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PGR_PACK_SSE2
+#endif
+
 namespace PGR {
 
-	Framebuffer::Framebuffer(const int width, const int height)
-		: m_Width(width), m_Height(height) {
+	static_assert(sizeof(Vec3) == 3 * sizeof(float), "the pack kernel reads Vec3 rows as packed floats");
+
+	static constexpr uint32_t OpaqueX = 0xff000000;
+
+	static uint32_t PackColor(const Vec3& color) {
+#ifdef PGR_PACK_SSE2
+		// One vector for the whole pixel, X as a fourth channel at 1.0; rounds
+		// like ColorToByte.
+		__m128 c = _mm_set_ps(1.0f, color.X, color.Y, color.Z);
+		c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		const __m128i i = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+		const __m128i words = _mm_packs_epi32(i, i);
+		return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+#else
+		return OpaqueX | ((uint32_t)ColorToByte(color.X) << 16) | ((uint32_t)ColorToByte(color.Y) << 8) | ColorToByte(color.Z);
+#endif
+	}
+
+	static Vec3 UnpackColor(uint32_t pixel) {
+		constexpr float scale = 1.0f / 255.0f;
+		return Vec3(((pixel >> 16) & 0xff) * scale, ((pixel >> 8) & 0xff) * scale, (pixel & 0xff) * scale);
+	}
+
+	bool ParseFramebufferFormat(const std::string& name, FramebufferFormat& format) {
+		if (name == "float")
+			format = FramebufferFormat::Float;
+		else if (name == "bgrx")
+			format = FramebufferFormat::BGRX8;
+		else
+			return false;
+		return true;
+	}
+
+	const char* GetFramebufferFormatName(FramebufferFormat format) {
+		return format == FramebufferFormat::BGRX8 ? "bgrx" : "float";
+	}
+
+	Framebuffer::Framebuffer(const int width, const int height, FramebufferFormat format)
+		: m_Width(width), m_Height(height), m_Format(format) {
 		ASSERT(width > 0 && height > 0);
-		m_PixelSize = m_Width * m_Height;
-		m_ColorBuffer = new Vec3[m_PixelSize]();
+		Allocate();
 		Clear();
 	}
 
 	Framebuffer::~Framebuffer() {
 		delete[] m_ColorBuffer;
 		m_ColorBuffer = nullptr;
+		delete[] m_Pixels;
+		m_Pixels = nullptr;
+	}
+
+	void Framebuffer::Allocate() {
+		m_PixelSize = m_Width * m_Height;
+		if (m_Format == FramebufferFormat::Float)
+			m_ColorBuffer = new Vec3[m_PixelSize]();
+		else {
+			// Whole 16-byte vectors per row, and the DWORD-aligned rows a DIB wants.
+			m_Stride = (m_Width + 3) & ~3;
+			m_Pixels = new uint32_t[(size_t)m_Stride * m_Height]();
+		}
 	}
 
 	void Framebuffer::SetColor(const int x, const int y, const Vec4& color) {
@@ -21,9 +78,26 @@ namespace PGR {
 			return;
 		}
 
+		const float alpha = color.W;
+		if (m_Format == FramebufferFormat::BGRX8) {
+			if (alpha <= 0.0f)
+				return;
+			uint32_t& target = m_Pixels[(size_t)(m_Height - 1 - y) * m_Stride + x];
+			const uint32_t source = PackColor(Vec3(color.X, color.Y, color.Z));
+			if (alpha >= 1.0f)
+				target = source;
+			else {
+				// 8.8 fixed point per channel, rounded.
+				const uint32_t a = (uint32_t)(alpha * 256.0f + 0.5f);
+				const uint32_t rb = ((source & 0xff00ff) * a + (target & 0xff00ff) * (256 - a) + 0x800080) >> 8;
+				const uint32_t g = ((source & 0xff00) * a + (target & 0xff00) * (256 - a) + 0x8000) >> 8;
+				target = OpaqueX | (rb & 0xff00ff) | (g & 0xff00);
+			}
+			return;
+		}
+
 		const int index = x + y * m_Width;
 
-		const float alpha = color.W;
 		if (alpha >= 1.0f) {
 			m_ColorBuffer[index] = Vec3(color.X, color.Y, color.Z);
 		}
@@ -34,18 +108,76 @@ namespace PGR {
 	}
 
 	Vec3 Framebuffer::GetColor(const int x, const int y) const {
-		if (x >= 0 && x < m_Width && y >= 0 && y < m_Height)
+		if (x >= 0 && x < m_Width && y >= 0 && y < m_Height) {
+			if (m_Format == FramebufferFormat::BGRX8)
+				return UnpackColor(m_Pixels[(size_t)(m_Height - 1 - y) * m_Stride + x]);
 			return m_ColorBuffer[x + y * m_Width];
+		}
 		else
 			ASSERT(false);
 		return Vec3(0.0f, 0.0f, 0.0f);
 	}
 
 	void Framebuffer::Clear(const Vec3& color) {
+		if (m_Format == FramebufferFormat::BGRX8) {
+			const uint32_t pixel = PackColor(color);
+			const size_t count = (size_t)m_Stride * m_Height;
+			for (size_t i = 0; i < count; i++)
+				m_Pixels[i] = pixel;
+			return;
+		}
 		for (int i = 0; i < m_PixelSize; i++)
 			m_ColorBuffer[i] = color;
 	}
 
+	void Framebuffer::CopyToBGRX(uint32_t* dst, int dstStride, int width, int height) const {
+		width = std::min(width, m_Width);
+		height = std::min(height, m_Height);
+		if (width <= 0 || height <= 0)
+			return;
+
+		if (m_Format == FramebufferFormat::BGRX8) {
+			for (int y = 0; y < height; y++)
+				memcpy(dst + (size_t)y * dstStride, m_Pixels + (size_t)y * m_Stride, (size_t)width * sizeof(uint32_t));
+			return;
+		}
+
+		for (int y = 0; y < height; y++) {
+			const Vec3* src = m_ColorBuffer + (size_t)(m_Height - 1 - y) * m_Width;
+			uint32_t* out = dst + (size_t)y * dstStride;
+			int x = 0;
+#ifdef PGR_PACK_SSE2
+			// Four pixels are three vectors of interleaved RGB; deinterleave them into
+			// R, G and B vectors, then clamp, round and shift the bytes into place.
+			// Rounds exactly like ColorToByte, so both paths give the same bytes.
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 scale = _mm_set1_ps(255.0f);
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128i opaque = _mm_set1_epi32((int)OpaqueX);
+			for (; x + 4 <= width; x += 4) {
+				const float* p = &src[x].X;
+				const __m128 a = _mm_loadu_ps(p);      // r0 g0 b0 r1
+				const __m128 b = _mm_loadu_ps(p + 4);  // g1 b1 r2 g2
+				const __m128 c = _mm_loadu_ps(p + 8);  // b2 r3 g3 b3
+
+				const __m128 r = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+				const __m128 g = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 bl = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+				const __m128i ri = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), scale), half));
+				const __m128i gi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), scale), half));
+				const __m128i bi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(bl, zero), one), scale), half));
+
+				const __m128i pixels = _mm_or_si128(_mm_or_si128(opaque, _mm_slli_epi32(ri, 16)), _mm_or_si128(_mm_slli_epi32(gi, 8), bi));
+				_mm_storeu_si128((__m128i*)(out + x), pixels);
+			}
+#endif
+			for (; x < width; x++)
+				out[x] = PackColor(src[x]);
+		}
+	}
+
 	// short
 	void Framebuffer::LoadFontTTF(const std::string& fontPath) {
 		std::ifstream file(fontPath, std::ios::binary);
@@ -56,6 +188,8 @@ namespace PGR {
 				if (!file) {
 					file.open(fontPath + ".ttf", std::ios::binary);
 					if (!file) file.open("C:\\Windows\\Fonts\\arial.ttf", std::ios::binary);
+					// The font shipped in resources/, the only one found without Windows.
+					if (!file) file.open("Exo-Regular.ttf", std::ios::binary);
 				}
 			}
 		}
@@ -152,9 +286,9 @@ namespace PGR {
 
 	// wide
 	void Framebuffer::LoadWFontTTF(const std::wstring& fontPath) {
-		std::wifstream file(fontPath, std::ios::binary);
+		std::wifstream file(std::filesystem::path(fontPath), std::ios::binary);
 		if (!file) {
-			file.open(L"C:\\Windows\\Fonts\\" + fontPath + L".ttf", std::ios::binary);
+			file.open(std::filesystem::path(L"C:\\Windows\\Fonts\\" + fontPath + L".ttf"), std::ios::binary);
 			if (!file) return;
 		}
 		m_fontBuffer = std::vector<unsigned char>((std::istreambuf_iterator<wchar_t>(file)), std::istreambuf_iterator<wchar_t>());
@@ -252,13 +386,15 @@ namespace PGR {
 	void Framebuffer::Resize(int width, int height) {
 		m_Width = width;
 		m_Height = height;
-		m_PixelSize = width * height;
 		delete[] m_ColorBuffer;
-		m_ColorBuffer = new Vec3[(size_t)width * (size_t)height];
+		m_ColorBuffer = nullptr;
+		delete[] m_Pixels;
+		m_Pixels = nullptr;
+		Allocate();
 	}
 
-	Framebuffer* Framebuffer::Create(const int width, const int height) {
-		return new Framebuffer(width, height);
+	Framebuffer* Framebuffer::Create(const int width, const int height, FramebufferFormat format) {
+		return new Framebuffer(width, height, format);
 	}
 
 }
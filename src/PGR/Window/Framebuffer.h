@@ -3,22 +3,49 @@
 #include "PGR/Base/Maths.h"
 #include "PGR/Renderer/Texture.h"
 
-#include <Windows.h>
+#include <vector>
+#include <cstdint>
 #include <fstream>
+#include <filesystem>
 #include <stb_image/stb_truetype.h>
 
 namespace PGR {
 
+	// Float keeps a bottom-up Vec3 per pixel and blends at full precision.
+	// BGRX8 stores the layout of a top-down 32-bit DIB (ffmpeg's bgr0), rows
+	// padded to GetStride() pixels, so presenting it is a row copy; every
+	// blend rounds to 8 bits instead.
+	enum class FramebufferFormat {
+		Float,
+		BGRX8
+	};
+
+	// Parses "float" / "bgrx"; returns false for anything else.
+	bool ParseFramebufferFormat(const std::string& name, FramebufferFormat& format);
+	const char* GetFramebufferFormatName(FramebufferFormat format);
+
 	class Framebuffer {
 	public:
-		Framebuffer(const int width, const int height);
+		Framebuffer(const int width, const int height, FramebufferFormat format = FramebufferFormat::Float);
 		~Framebuffer();
 
 		int GetWidth() const { return m_Width; }
 		int GetHeight() const { return m_Height; }
+		FramebufferFormat GetFormat() const { return m_Format; }
 
+		// Coordinates are bottom-up in both formats.
 		void SetColor(const int x, const int y, const Vec4& color);
 		Vec3 GetColor(const int x, const int y) const;
+		// Float only, nullptr for BGRX8.
+		const Vec3* GetColorBuffer() const { return m_ColorBuffer; }
+		// BGRX8 only: top-down rows of GetStride() pixels, nullptr for Float.
+		const uint32_t* GetPixels() const { return m_Pixels; }
+		int GetStride() const { return m_Stride; }
+
+		// Writes the top-left `width` x `height` of the frame top-down as BGRX8
+		// into rows of `dstStride` pixels: a row copy for BGRX8, an SSE2
+		// clamp, pack and flip for Float.
+		void CopyToBGRX(uint32_t* dst, int dstStride, int width, int height) const;
 
 		void Clear(const Vec3& color = Vec3(0.0f, 0.0f, 0.0f));
 
@@ -39,16 +66,20 @@ namespace PGR {
 
 		void Resize(const int width, const int height);
 
-		static Framebuffer* Create(const int width, const int height);
+		static Framebuffer* Create(const int width, const int height, FramebufferFormat format = FramebufferFormat::Float);
 
 	private:
 		int GetPixelIndex(const int x, const int y) const { return (y * m_Width + x) * 3; }
+		void Allocate();
 
 	private:
 		int m_Width;
 		int m_Height;
 		int m_PixelSize;
-		Vec3* m_ColorBuffer;
+		FramebufferFormat m_Format;
+		Vec3* m_ColorBuffer = nullptr;
+		uint32_t* m_Pixels = nullptr;
+		int m_Stride = 0;
 
 		stbtt_fontinfo m_FontInfo;
 		std::vector<unsigned char> m_fontBuffer;
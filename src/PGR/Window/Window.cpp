@@ -6,7 +6,6 @@
 namespace PGR {
 
 	bool Window::s_Inited = false;
-	bool Window::s_IsWheel = false;
 
 	Window::Window(const std::string title, int width, int height)
 		: m_Title(title), m_Width(width), m_Height(height) {
@@ -34,12 +33,12 @@ namespace PGR {
 		biHeader.biWidth = ((long)m_Width);
 		biHeader.biHeight = -((long)m_Height);
 		biHeader.biPlanes = 1;
-		biHeader.biBitCount = 24;
+		biHeader.biBitCount = 32;
 		biHeader.biCompression = BI_RGB;
 
 		newBitmap = CreateDIBSection(m_MemoryDC, (BITMAPINFO*)&biHeader, DIB_RGB_COLORS, (void**)&m_Buffer, nullptr, 0);
 		ASSERT(newBitmap != NULL);
-		constexpr int channelCount = 3;
+		constexpr int channelCount = 4;
 		int size = m_Width * m_Height * channelCount * sizeof(unsigned char);
 		memset(m_Buffer, 0, size);
 		oldBitmap = (HBITMAP)SelectObject(m_MemoryDC, newBitmap);
@@ -94,36 +93,12 @@ namespace PGR {
 		BitBlt(windowDC, 0, 0, m_Width, m_Height, m_MemoryDC, 0, 0, SRCCOPY);
 		ShowWindow(m_Handle, SW_SHOW);
 		ReleaseDC(m_Handle, windowDC);
-		PollInputEvents();
 	}
 
 	void Window::DrawFramebuffer(Framebuffer* framebuffer) {
-		const int fWidth = framebuffer->GetWidth();
-		const int fHeight = framebuffer->GetHeight();
-		const int width = m_Width < fWidth ? m_Width : fWidth;
-		const int height = m_Height < fHeight ? m_Height : fHeight;
-		constexpr int channelCount = 3;
-
-		int rowSize = m_Width * channelCount;
-		if (rowSize % 4 != 0) {
-			rowSize += 4 - (rowSize % 4);
-		}
-
-		unsigned char* buffer = m_Buffer;
-		const int fHeightMinusOne = fHeight - 1;
-
-		for (int i = 0; i < height; i++) {
-			unsigned char* rowStart = buffer + i * rowSize;
-			int framebufferY = fHeightMinusOne - i;
-
-			for (int j = 0; j < width; j++) {
-				Vec3 color = framebuffer->GetColor(j, framebufferY);
-
-				rowStart[j * channelCount + 2] = Float2UChar(color.X); // R
-				rowStart[j * channelCount + 1] = Float2UChar(color.Y); // G
-				rowStart[j * channelCount + 0] = Float2UChar(color.Z); // B
-			}
-		}
+		// A 32bpp top-down DIB: rows are already DWORD-aligned, and a BGRX8
+		// framebuffer has exactly this layout.
+		framebuffer->CopyToBGRX((uint32_t*)m_Buffer, m_Width, m_Width, m_Height);
 		Show();
 	}
 
@@ -165,6 +140,9 @@ namespace PGR {
 		case WM_SIZE:
 			window->Resize(LOWORD(lParam), HIWORD(lParam));
 			return 0;
+		case WM_MOUSEWHEEL:
+			window->m_MouseWheel += GET_WHEEL_DELTA_WPARAM(wParam);
+			return 0;
 		case WM_ACTIVATE:
 			if (LOWORD(wParam) == WA_INACTIVE) {
 				window->m_Active = false;
@@ -176,25 +154,18 @@ namespace PGR {
 			}
 			return 0;
 		}
-		if (msgID == WM_MOUSEWHEEL && !s_IsWheel) {
-			window->m_MouseWheel = GET_WHEEL_DELTA_WPARAM(wParam);
-			s_IsWheel = true;
-			return 0;
-		}
-		else if (s_IsWheel) {
-			window->m_MouseWheel = 0;
-			s_IsWheel = false;
-			return 0;
-		}
-
 		return DefWindowProc(hWnd, msgID, wParam, lParam);
 	}
 
-	void Window::PollInputEvents() {
+	int Window::PollInputEvents() {
 		MSG message;
-		PeekMessage(&message, NULL, 0, 0, PM_REMOVE);
-		TranslateMessage(&message);
-		DispatchMessage(&message);
+		int count = 0;
+		while (PeekMessage(&message, NULL, 0, 0, PM_REMOVE)) {
+			TranslateMessage(&message);
+			DispatchMessage(&message);
+			count++;
+		}
+		return count;
 	}
 
 	void Window::Resize(int width, int height) {
@@ -214,19 +185,16 @@ namespace PGR {
 		biHeader.biWidth = static_cast<long>(width);
 		biHeader.biHeight = -static_cast<long>(height);
 		biHeader.biPlanes = 1;
-		biHeader.biBitCount = 24;
+		biHeader.biBitCount = 32;
 		biHeader.biCompression = BI_RGB;
 
 		void* newBuffer = nullptr;
 		HBITMAP newBitmap = CreateDIBSection(newMemoryDC, (BITMAPINFO*)&biHeader, DIB_RGB_COLORS, &newBuffer, nullptr, 0);
 		ASSERT(newBitmap != NULL);
 
-		constexpr int channelCount = 3;
+		constexpr int channelCount = 4;
 
 		int rowSize = width * channelCount;
-		if (rowSize % 4 != 0) {
-			rowSize += 4 - (rowSize % 4);
-		}
 		int bufferSize = rowSize * height;
 		memset(newBuffer, 0, bufferSize);
 
@@ -27,7 +27,9 @@ namespace PGR {
 		int GetMouseX() const { return m_MouseX; }
 		int GetMouseY() const { return m_MouseY; }
 		int GetMsg() const { return m_Msg; }
+		// Wheel delta summed over the events since ResetWheel().
 		int GetWhell() const { return m_MouseWheel; }
+		void ResetWheel() { m_MouseWheel = 0; }
 		bool IsActive() const { return m_Active; }
 
 		int GetWidth() const { return m_Width; }
@@ -39,7 +41,8 @@ namespace PGR {
 		static LRESULT CALLBACK WndProc(HWND hWnd, UINT msgID, WPARAM wParam, LPARAM lParam);
 		static void SetMsg(Window* window, UINT msgID, const WPARAM wParam, const LPARAM lParam);
 
-		static void PollInputEvents();
+		// Dispatches every queued message; returns how many.
+		static int PollInputEvents();
 
 		void Resize(int width, int height);
 
@@ -60,8 +63,6 @@ namespace PGR {
 
 		static bool s_Inited;
 
-		static bool s_IsWheel;
-
 		int m_MouseX, m_MouseY;
 		unsigned int m_Msg;
 
@@ -0,0 +1 @@
+#include "stb_image/stb_vorbis.c"